@@ -0,0 +1,3 @@
+// ArduinoOTA.h (native HAL)
+#pragma once
+#include "Arduino.h"
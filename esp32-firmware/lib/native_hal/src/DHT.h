@@ -0,0 +1,15 @@
+// DHT.h (native HAL)
+// Readings come from hal_setDht(); NAN reproduces a failed read.
+#pragma once
+#include "Arduino.h"
+
+#define DHT11 11
+#define DHT22 22
+
+class DHT {
+public:
+  DHT(uint8_t pin, uint8_t type) { (void)pin; (void)type; }
+  void begin() {}
+  float readTemperature();
+  float readHumidity();
+};
@@ -0,0 +1,34 @@
+// EEPROM.h (native HAL)
+// RAM-backed EEPROM emulation; reads before begin() or past the end return 0xFF.
+#pragma once
+#include "Arduino.h"
+#include <vector>
+
+class EEPROMClass {
+public:
+  bool begin(size_t size) {
+    if (data_.size() < size) data_.resize(size, 0xFF);
+    return true;
+  }
+  uint8_t read(int addr) const { return (addr >= 0 && (size_t)addr < data_.size()) ? data_[addr] : 0xFF; }
+  void write(int addr, uint8_t v) { if (addr >= 0 && (size_t)addr < data_.size()) data_[addr] = v; }
+  bool commit() { commits_++; return true; }
+  size_t length() const { return data_.size(); }
+  unsigned long commitCount() const { return commits_; }
+
+  template <typename T> T& get(int addr, T& out) const {
+    uint8_t* p = (uint8_t*)&out;
+    for (size_t i = 0; i < sizeof(T); i++) p[i] = read(addr + (int)i);
+    return out;
+  }
+  template <typename T> const T& put(int addr, const T& in) {
+    const uint8_t* p = (const uint8_t*)&in;
+    for (size_t i = 0; i < sizeof(T); i++) write(addr + (int)i, p[i]);
+    return in;
+  }
+
+private:
+  std::vector<uint8_t> data_;
+  unsigned long commits_ = 0;
+};
+extern EEPROMClass EEPROM;
@@ -0,0 +1,3 @@
+// HTTPUpdate.h (native HAL)
+#pragma once
+#include "Arduino.h"
@@ -0,0 +1,53 @@
+// LittleFS.h (native HAL)
+// In-memory file system: contents live for the life of the process, which
+// keeps forked fleet instances isolated from each other.
+#pragma once
+#include "Arduino.h"
+#include <memory>
+#include <string>
+
+class File : public Stream {
+public:
+  File() {}
+  File(std::shared_ptr<std::string> data, const char* path, bool writable)
+    : data_(data), path_(path), writable_(writable) {}
+  explicit operator bool() const { return (bool)data_; }
+  int available() override { return data_ ? (int)(data_->size() - pos_) : 0; }
+  int read() override { return (data_ && pos_ < data_->size()) ? (uint8_t)(*data_)[pos_++] : -1; }
+  int peek() override { return (data_ && pos_ < data_->size()) ? (uint8_t)(*data_)[pos_] : -1; }
+  using Print::write;
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buf, size_t n) override {
+    if (!data_ || !writable_) return 0;
+    data_->append((const char*)buf, n);
+    return n;
+  }
+  size_t size() const { return data_ ? data_->size() : 0; }
+  const char* path() const { return path_.c_str(); }
+  void close() { data_.reset(); }
+
+private:
+  std::shared_ptr<std::string> data_;
+  std::string path_;
+  bool writable_ = false;
+  size_t pos_ = 0;
+};
+
+class LittleFSFS {
+public:
+  bool begin(bool formatOnFail = false, const char* basePath = "/littlefs", uint8_t maxOpenFiles = 10,
+             const char* partitionLabel = "spiffs");
+  bool exists(const char* path);
+  File open(const char* path, const char* mode = "r");
+  bool remove(const char* path);
+  bool format();
+  size_t totalBytes() { return 1441792; }
+  size_t usedBytes();
+  // number of begin() calls that actually had to mount (host bookkeeping)
+  unsigned long mountCount() const { return mounts_; }
+
+private:
+  bool mounted_ = false;
+  unsigned long mounts_ = 0;
+};
+extern LittleFSFS LittleFS;
@@ -0,0 +1,22 @@
+// NTPClient.h (native HAL)
+// Wall-clock time derived from the virtual clock and hal_setEpochBase().
+#pragma once
+#include "Arduino.h"
+#include "WiFiUdp.h"
+
+class NTPClient {
+public:
+  NTPClient(WiFiUDP& udp, const char* server, long offsetSeconds, unsigned long intervalMs)
+    : offset_(offsetSeconds) { (void)udp; (void)server; (void)intervalMs; }
+  void begin() {}
+  bool update() { return true; }
+  bool forceUpdate() { return true; }
+  unsigned long getEpochTime() const;
+  int getHours() const { return (int)((getEpochTime() % 86400L) / 3600); }
+  int getMinutes() const { return (int)((getEpochTime() % 3600) / 60); }
+  int getSeconds() const { return (int)(getEpochTime() % 60); }
+  int getDay() const { return (int)(((getEpochTime() / 86400L) + 4) % 7); }
+
+private:
+  long offset_;
+};
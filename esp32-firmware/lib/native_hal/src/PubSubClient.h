@@ -0,0 +1,40 @@
+// PubSubClient.h (native HAL)
+// Talks to the in-process broker stand-in in net_sim.cpp. The packet buffer
+// limit of the real library is kept, so oversized publishes fail the same way.
+#pragma once
+#include "Arduino.h"
+#include "WiFiClient.h"
+#include <functional>
+
+#define MQTT_MAX_HEADER_SIZE 5
+#define MQTT_CALLBACK_SIGNATURE std::function<void(char*, uint8_t*, unsigned int)> callback
+
+class PubSubClient {
+public:
+  PubSubClient() {}
+  explicit PubSubClient(Client& c) { (void)c; }
+  PubSubClient& setClient(Client& c) { (void)c; return *this; }
+  PubSubClient& setServer(const char* host, uint16_t port) { (void)host; (void)port; return *this; }
+  PubSubClient& setCallback(MQTT_CALLBACK_SIGNATURE) { callback_ = callback; return *this; }
+  bool setBufferSize(uint16_t size) { bufferSize_ = size; return true; }
+  uint16_t getBufferSize() const { return bufferSize_; }
+
+  bool connect(const char* id);
+  bool connect(const char* id, const char* user, const char* pass);
+  bool connect(const char* id, const char* user, const char* pass, const char* willTopic,
+               uint8_t willQos, bool willRetain, const char* willMessage);
+  void disconnect() { connected_ = false; }
+  bool connected();
+  int state() { return connected() ? 0 : -1; }
+  bool subscribe(const char* topic, uint8_t qos = 0);
+  bool publish(const char* topic, const uint8_t* payload, unsigned int len, bool retained = false);
+  bool publish(const char* topic, const char* payload, bool retained = false) {
+    return publish(topic, (const uint8_t*)payload, (unsigned int)strlen(payload), retained);
+  }
+  bool loop();
+
+private:
+  std::function<void(char*, uint8_t*, unsigned int)> callback_;
+  uint16_t bufferSize_ = 256;
+  bool connected_ = false;
+};
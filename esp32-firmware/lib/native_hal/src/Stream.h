@@ -0,0 +1,26 @@
+// Stream.h (native HAL)
+#ifndef NATIVE_STREAM_H
+#define NATIVE_STREAM_H
+
+#include "Print.h"
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  // Host streams never wait for data, so there is no timeout to honour
+  void setTimeout(unsigned long) {}
+  size_t readBytes(char* buf, size_t n) {
+    size_t got = 0;
+    while (got < n) {
+      int c = read();
+      if (c < 0) break;
+      buf[got++] = (char)c;
+    }
+    return got;
+  }
+  size_t readBytes(uint8_t* buf, size_t n) { return readBytes((char*)buf, n); }
+};
+
+#endif
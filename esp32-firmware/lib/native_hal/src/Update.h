@@ -0,0 +1,18 @@
+// Update.h (native HAL)
+// Accepts an image and discards it; the host never reboots into it.
+#pragma once
+#include "Arduino.h"
+
+class UpdateClass {
+public:
+  bool begin(size_t size) { size_ = size; written_ = 0; return true; }
+  size_t write(uint8_t* data, size_t len) { (void)data; written_ += len; return len; }
+  bool end(bool evenIfRemaining = false) { return evenIfRemaining || written_ == size_; }
+  void abort() { written_ = 0; }
+  bool hasError() const { return false; }
+
+private:
+  size_t size_ = 0;
+  size_t written_ = 0;
+};
+extern UpdateClass Update;
@@ -0,0 +1,42 @@
+// WebServer.h (native HAL)
+// Handlers are invoked by hal_webRequest() instead of a listening socket.
+#pragma once
+#include "Arduino.h"
+#include <functional>
+#include <vector>
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+
+typedef enum { HTTP_ANY = 0, HTTP_GET = 1, HTTP_HEAD = 2, HTTP_POST = 3 } HTTPMethod;
+
+class WebServer {
+public:
+  typedef std::function<void(void)> THandlerFunction;
+  explicit WebServer(int port = 80);
+  void on(const char* uri, HTTPMethod method, THandlerFunction fn) { routes_.push_back({uri, method, fn}); }
+  void on(const char* uri, THandlerFunction fn) { on(uri, HTTP_ANY, fn); }
+  void begin() {}
+  void handleClient() {}
+  void send(int code, const char* contentType = nullptr, const String& content = String());
+  void setContentLength(size_t) {}
+  // chunked responses: send() the head, then append with sendContent()
+  void sendContent(const char* content, size_t size) { response_.append(content, size); }
+  void sendContent(const String& content) { response_ += content.c_str(); }
+  String arg(const char* name) { return strcmp(name, "plain") == 0 ? body_ : String(); }
+  bool hasArg(const char* name) { return strcmp(name, "plain") == 0 && body_.length() > 0; }
+  String uri() const { return uri_; }
+
+  int dispatch(HTTPMethod method, const char* uri, const char* body, std::string* response);
+
+private:
+  struct Route {
+    std::string uri;
+    HTTPMethod method;
+    THandlerFunction fn;
+  };
+  std::vector<Route> routes_;
+  String body_;
+  String uri_;
+  int code_ = 0;
+  std::string response_;
+};
@@ -0,0 +1,42 @@
+// WiFi.h (native HAL)
+// Station link state is controlled by hal_setWiFiConnected(); begin() joins
+// instantly whenever the simulated access point is reachable.
+#pragma once
+#include "Arduino.h"
+#include "WiFiClient.h"
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+
+class IPAddress {
+public:
+  IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : o_{a, b, c, d} {}
+  String toString() const;
+  uint8_t operator[](int i) const { return o_[i & 3]; }
+
+private:
+  uint8_t o_[4];
+};
+
+class WiFiClass {
+public:
+  bool mode(wifi_mode_t m);
+  wl_status_t begin(const char* ssid, const char* pass = nullptr);
+  bool disconnect(bool wifiOff = false);
+  wl_status_t status();
+  IPAddress localIP();
+  String macAddress();
+  uint8_t* macAddress(uint8_t* mac);
+  int8_t RSSI() { return -60; }
+  int16_t scanNetworks() { return 0; }
+  String SSID(uint8_t) { return String(); }
+  int32_t RSSI(uint8_t) { return -60; }
+};
+extern WiFiClass WiFi;
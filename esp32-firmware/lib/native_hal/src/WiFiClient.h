@@ -0,0 +1,29 @@
+// WiFiClient.h (native HAL)
+// A client is just a readable buffer holding whatever the stand-in backend
+// answered; there are no sockets on the host.
+#pragma once
+#include "Arduino.h"
+#include <string>
+
+class Client : public Stream {
+public:
+  virtual uint8_t connected() { return 0; }
+  virtual void stop() {}
+};
+
+class WiFiClient : public Client {
+public:
+  void setData(const std::string& data) { data_ = data; pos_ = 0; }
+  int available() override { return (int)(data_.size() - pos_); }
+  int read() override { return pos_ < data_.size() ? (uint8_t)data_[pos_++] : -1; }
+  int peek() override { return pos_ < data_.size() ? (uint8_t)data_[pos_] : -1; }
+  using Print::write;
+  size_t write(uint8_t) override { return 1; }
+  size_t write(const uint8_t*, size_t n) override { return n; }
+  uint8_t connected() override { return pos_ < data_.size(); }
+  void stop() override { data_.clear(); pos_ = 0; }
+
+private:
+  std::string data_;
+  size_t pos_ = 0;
+};
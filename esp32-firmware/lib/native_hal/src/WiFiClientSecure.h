@@ -0,0 +1,9 @@
+// WiFiClientSecure.h (native HAL)
+#pragma once
+#include "WiFiClient.h"
+
+class WiFiClientSecure : public WiFiClient {
+public:
+  void setInsecure() {}
+  void setCACert(const char*) {}
+};
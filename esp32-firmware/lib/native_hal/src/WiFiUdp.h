@@ -0,0 +1,10 @@
+// WiFiUdp.h (native HAL)
+#pragma once
+#include "Arduino.h"
+
+class WiFiUDP {
+public:
+  int beginPacket(const char* host, uint16_t port) { (void)host; (void)port; return 1; }
+  size_t write(const uint8_t* buf, size_t n) { (void)buf; return n; }
+  int endPacket() { return 1; }
+};
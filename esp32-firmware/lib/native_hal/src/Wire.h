@@ -0,0 +1,9 @@
+// Wire.h (native HAL)
+#pragma once
+#include "Arduino.h"
+
+class TwoWire {
+public:
+  bool begin(int sda = -1, int scl = -1) { (void)sda; (void)scl; return true; }
+};
+extern TwoWire Wire;
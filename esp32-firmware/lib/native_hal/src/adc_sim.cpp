@@ -0,0 +1,138 @@
+// adc_sim.cpp
+// Continuous ADC shim (driver/adc.h) on the virtual clock.
+#include "Arduino.h"
+#include "hal_sim.h"
+#include "driver/adc.h"
+#include "esp_adc_cal.h"
+
+namespace {
+// ADC1 channel -> GPIO on the ESP32
+const uint8_t kAdc1Pins[8] = {36, 37, 38, 39, 32, 33, 34, 35};
+
+struct AdcSim {
+  bool initialized = false;
+  bool running = false;
+  uint32_t bufSamples = 0;    // ring size; older conversions are lost
+  uint32_t frameSamples = 1;  // delivered in whole frames, like the DMA EOF interrupt
+  uint32_t rateHz = 0;
+  uint8_t pattern[SOC_ADC_PATT_LEN_MAX];
+  uint32_t patternNum = 0;
+  uint64_t startUs = 0;
+  uint64_t stopUs = 0;
+  uint64_t consumed = 0;  // conversions handed out (or dropped) since start
+} g_adc;
+bool g_available = true;
+
+uint64_t producedBy(uint64_t us) {
+  uint64_t end = g_adc.running ? us : g_adc.stopUs;
+  if (end <= g_adc.startUs) return 0;
+  return (end - g_adc.startUs) * g_adc.rateHz / 1000000ULL;
+}
+}  // namespace
+
+int8_t digitalPinToAnalogChannel(uint8_t pin) {
+  for (int8_t ch = 0; ch < 8; ch++) {
+    if (kAdc1Pins[ch] == pin) return ch;
+  }
+  return -1;
+}
+
+void hal_setAdcContinuous(bool available) { g_available = available; }
+
+esp_err_t adc_digi_initialize(const adc_digi_init_config_t* cfg) {
+  if (!g_available) return ESP_FAIL;
+  if (!cfg || cfg->adc2_chan_mask || !cfg->conv_num_each_intr) return ESP_ERR_INVALID_ARG;
+  g_adc = AdcSim();
+  g_adc.initialized = true;
+  g_adc.bufSamples = cfg->max_store_buf_size / SOC_ADC_DIGI_RESULT_BYTES;
+  g_adc.frameSamples = cfg->conv_num_each_intr / SOC_ADC_DIGI_RESULT_BYTES;
+  if (!g_adc.frameSamples) g_adc.frameSamples = 1;
+  return ESP_OK;
+}
+
+esp_err_t adc_digi_deinitialize() {
+  g_adc = AdcSim();
+  return ESP_OK;
+}
+
+esp_err_t adc_digi_controller_configure(const adc_digi_configuration_t* cfg) {
+  if (!g_adc.initialized || g_adc.running) return ESP_ERR_INVALID_STATE;
+  if (!cfg || !cfg->pattern_num || cfg->pattern_num > SOC_ADC_PATT_LEN_MAX ||
+      cfg->conv_mode != ADC_CONV_SINGLE_UNIT_1 || cfg->format != ADC_DIGI_OUTPUT_FORMAT_TYPE1 ||
+      cfg->sample_freq_hz < SOC_ADC_SAMPLE_FREQ_THRES_LOW || cfg->sample_freq_hz > SOC_ADC_SAMPLE_FREQ_THRES_HIGH)
+    return ESP_ERR_INVALID_ARG;
+  for (uint32_t i = 0; i < cfg->pattern_num; i++) {
+    if (cfg->adc_pattern[i].unit != 0 || cfg->adc_pattern[i].channel > 7) return ESP_ERR_INVALID_ARG;
+    g_adc.pattern[i] = cfg->adc_pattern[i].channel;
+  }
+  g_adc.patternNum = cfg->pattern_num;
+  g_adc.rateHz = cfg->sample_freq_hz;
+  return ESP_OK;
+}
+
+esp_err_t adc_digi_start() {
+  if (!g_adc.initialized || !g_adc.patternNum) return ESP_ERR_INVALID_STATE;
+  g_adc.running = true;
+  g_adc.startUs = hal_nowUs();
+  g_adc.consumed = 0;
+  return ESP_OK;
+}
+
+esp_err_t adc_digi_stop() {
+  if (g_adc.running) {
+    g_adc.stopUs = hal_nowUs();
+    g_adc.running = false;
+  }
+  return ESP_OK;
+}
+
+esp_err_t adc_digi_read_bytes(uint8_t* buf, uint32_t length_max, uint32_t* out_length, uint32_t timeout_ms) {
+  *out_length = 0;
+  if (!g_adc.initialized || !g_adc.patternNum) return ESP_ERR_INVALID_STATE;
+  uint64_t deadline = timeout_ms == ADC_MAX_DELAY ? UINT64_MAX : hal_nowUs() + (uint64_t)timeout_ms * 1000ULL;
+  uint64_t avail;
+  while (true) {
+    uint64_t produced = producedBy(hal_nowUs());
+    // the ring keeps only the newest bufSamples conversions
+    if (produced - g_adc.consumed > g_adc.bufSamples) g_adc.consumed = produced - g_adc.bufSamples;
+    avail = (produced - g_adc.consumed) / g_adc.frameSamples * g_adc.frameSamples;
+    if (!g_adc.running && produced > g_adc.consumed) avail = produced - g_adc.consumed;
+    if (avail || !g_adc.running || hal_nowUs() >= deadline) break;
+    // wait for the next frame boundary
+    uint64_t need = g_adc.consumed + g_adc.frameSamples;
+    uint64_t wake = g_adc.startUs + (need * 1000000ULL + g_adc.rateHz - 1) / g_adc.rateHz;
+    hal_sleepUntil(wake < deadline ? wake : deadline);
+  }
+  if (!avail) return ESP_ERR_TIMEOUT;
+  uint32_t n = length_max / SOC_ADC_DIGI_RESULT_BYTES;
+  if (avail < n) n = (uint32_t)avail;
+  adc_digi_output_data_t* out = (adc_digi_output_data_t*)buf;
+  for (uint32_t i = 0; i < n; i++) {
+    uint8_t ch = g_adc.pattern[(g_adc.consumed + i) % g_adc.patternNum];
+    out[i].val = 0;
+    out[i].type1.channel = ch;
+    out[i].type1.data = analogRead(kAdc1Pins[ch]);
+  }
+  g_adc.consumed += n;
+  *out_length = n * SOC_ADC_DIGI_RESULT_BYTES;
+  return ESP_OK;
+}
+
+// ---- esp_adc_cal ----
+
+esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t adc_num, adc_atten_t atten, adc_bits_width_t bit_width,
+                                             uint32_t default_vref, esp_adc_cal_characteristics_t* chars) {
+  chars->adc_num = adc_num;
+  chars->atten = atten;
+  chars->bit_width = bit_width;
+  chars->coeff_a = 3300;
+  chars->coeff_b = 0;
+  chars->vref = default_vref;
+  chars->low_curve = nullptr;
+  chars->high_curve = nullptr;
+  return ESP_ADC_CAL_VAL_DEFAULT_VREF;
+}
+
+uint32_t esp_adc_cal_raw_to_voltage(uint32_t adc_reading, const esp_adc_cal_characteristics_t* chars) {
+  return adc_reading * chars->coeff_a / 4095UL + chars->coeff_b;
+}
@@ -0,0 +1,99 @@
+// alloc_sim.cpp
+// Counts heap traffic by interposing the C allocator. operator new in
+// libstdc++ ends up in malloc(), so ArduinoJson, String and std containers
+// are all covered. Allocations inside a HalInternalAllocScope are skipped,
+// so the counters describe the firmware's own heap use.
+#include "hal_sim.h"
+#include <atomic>
+#include <errno.h>
+#include <malloc.h>
+#include <string.h>
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* p);
+}
+
+namespace {
+std::atomic<uint64_t> g_allocs{0};
+std::atomic<uint64_t> g_frees{0};
+std::atomic<uint64_t> g_bytes{0};
+std::atomic<int64_t> g_live{0};
+std::function<void(size_t)> g_hook;
+thread_local int t_internal = 0;
+
+void* counted(void* p, size_t requested) {
+  if (p && t_internal == 0) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(requested, std::memory_order_relaxed);
+    g_live.fetch_add((int64_t)malloc_usable_size(p), std::memory_order_relaxed);
+    if (g_hook) {
+      HalInternalAllocScope scope;
+      g_hook(requested);
+    }
+  }
+  return p;
+}
+
+// frees are matched by scope too; liveBytes is approximate when a block
+// crosses a scope boundary
+void uncounted(void* p) {
+  if (!p || t_internal) return;
+  g_frees.fetch_add(1, std::memory_order_relaxed);
+  g_live.fetch_sub((int64_t)malloc_usable_size(p), std::memory_order_relaxed);
+}
+}  // namespace
+
+extern "C" {
+void* malloc(size_t size) { return counted(__libc_malloc(size), size); }
+
+void* calloc(size_t n, size_t size) { return counted(__libc_calloc(n, size), n * size); }
+
+void* realloc(void* p, size_t size) {
+  uncounted(p);
+  void* q = __libc_realloc(p, size);
+  if (!q && size) {
+    // the old block is still valid when realloc fails
+    counted(p, 0);
+    return nullptr;
+  }
+  return counted(q, size);
+}
+
+void free(void* p) {
+  uncounted(p);
+  __libc_free(p);
+}
+
+void* memalign(size_t alignment, size_t size) { return counted(__libc_memalign(alignment, size), size); }
+
+void* aligned_alloc(size_t alignment, size_t size) { return memalign(alignment, size); }
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+  void* p = memalign(alignment, size);
+  if (!p) return ENOMEM;
+  *out = p;
+  return 0;
+}
+}
+
+HalInternalAllocScope::HalInternalAllocScope() { t_internal++; }
+
+HalInternalAllocScope::~HalInternalAllocScope() { t_internal--; }
+
+void hal_setAllocHook(std::function<void(size_t)> fn) {
+  HalInternalAllocScope scope;
+  g_hook = fn;
+}
+
+HalAllocStats hal_allocStats() {
+  HalAllocStats s;
+  s.allocs = g_allocs.load(std::memory_order_relaxed);
+  s.frees = g_frees.load(std::memory_order_relaxed);
+  s.bytes = g_bytes.load(std::memory_order_relaxed);
+  s.liveBytes = g_live.load(std::memory_order_relaxed);
+  return s;
+}
@@ -0,0 +1,161 @@
+// arduino_sim.cpp
+// Arduino core shims: clock, GPIO, ADC, Serial and ESP system calls.
+#include "Arduino.h"
+#include "hal_sim.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+
+namespace {
+const int NUM_PINS = 40;
+int g_analog[NUM_PINS];
+int g_input[NUM_PINS];
+int g_output[NUM_PINS];
+std::function<int(uint8_t)> g_analogSource;
+std::function<void(uint8_t, uint8_t)> g_gpioHook;
+std::function<void(const char*, size_t)> g_serialHook;
+bool g_serialEcho = true;
+bool g_restart = false;
+uint32_t g_rng = 1;
+
+struct PinInit {
+  PinInit() {
+    for (int i = 0; i < NUM_PINS; i++) g_input[i] = HIGH;  // buttons idle high (pull-up)
+  }
+} g_pinInit;
+}  // namespace
+
+// ---- clock ----
+
+unsigned long millis() { return (uint32_t)(hal_nowUs() / 1000ULL); }
+unsigned long micros() { return (uint32_t)hal_nowUs(); }
+void delay(uint32_t ms) { vTaskDelay(pdMS_TO_TICKS(ms)); }
+void delayMicroseconds(uint32_t us) { hal_sleepUntil(hal_nowUs() + us); }
+void yield() {}
+
+// ---- GPIO / ADC ----
+
+void rmtSimPinMode(uint8_t pin, uint8_t mode);  // rmt_sim.cpp
+
+void pinMode(uint8_t pin, uint8_t mode) { rmtSimPinMode(pin, mode); }
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  if (pin >= NUM_PINS) return;
+  g_output[pin] = level ? HIGH : LOW;
+  if (g_gpioHook) {
+    HalInternalAllocScope scope;
+    g_gpioHook(pin, (uint8_t)g_output[pin]);
+  }
+}
+
+int digitalRead(uint8_t pin) { return pin < NUM_PINS ? g_input[pin] : LOW; }
+
+uint16_t analogRead(uint8_t pin) {
+  if (pin >= NUM_PINS) return 0;
+  int v = g_analog[pin];
+  if (g_analogSource) {
+    HalInternalAllocScope scope;
+    v = g_analogSource(pin);
+  }
+  return (uint16_t)constrain(v, 0, 4095);
+}
+
+uint32_t analogReadMilliVolts(uint8_t pin) { return (uint32_t)analogRead(pin) * 3300UL / 4095UL; }
+void analogSetPinAttenuation(uint8_t, adc_attenuation_t) {}
+void analogSetWidth(uint8_t) {}
+
+void hal_setAnalog(uint8_t pin, int value) { if (pin < NUM_PINS) g_analog[pin] = value; }
+void hal_setAnalogSource(std::function<int(uint8_t)> fn) { g_analogSource = fn; }
+void hal_setDigitalInput(uint8_t pin, int level) { if (pin < NUM_PINS) g_input[pin] = level; }
+int hal_digitalOutput(uint8_t pin) { return pin < NUM_PINS ? g_output[pin] : LOW; }
+void hal_setGpioWriteHook(std::function<void(uint8_t, uint8_t)> fn) { g_gpioHook = fn; }
+
+// ---- math helpers ----
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  if (inMax == inMin) return outMin;
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// Deterministic xorshift so simulations are repeatable run to run
+long random(long howBig) {
+  if (howBig <= 0) return 0;
+  g_rng ^= g_rng << 13;
+  g_rng ^= g_rng >> 17;
+  g_rng ^= g_rng << 5;
+  return (long)(g_rng % (uint32_t)howBig);
+}
+
+long random(long howSmall, long howBig) {
+  if (howSmall >= howBig) return howSmall;
+  return howSmall + random(howBig - howSmall);
+}
+
+void randomSeed(unsigned long seed) { g_rng = seed ? (uint32_t)seed : 1; }
+
+// ---- Serial ----
+
+size_t Print::write(const char* s) { return s ? write((const uint8_t*)s, strlen(s)) : 0; }
+
+// Same shape as the Arduino-ESP32 core: a 64-byte stack buffer, and a heap
+// buffer for anything longer
+size_t Print::printf(const char* fmt, ...) {
+  char locBuf[64];
+  char* buf = locBuf;
+  va_list ap, copy;
+  va_start(ap, fmt);
+  va_copy(copy, ap);
+  int n = vsnprintf(buf, sizeof(locBuf), fmt, copy);
+  va_end(copy);
+  if (n < 0) {
+    va_end(ap);
+    return 0;
+  }
+  if ((size_t)n >= sizeof(locBuf)) {
+    buf = (char*)malloc(n + 1);
+    if (!buf) {
+      va_end(ap);
+      return 0;
+    }
+    vsnprintf(buf, n + 1, fmt, ap);
+  }
+  va_end(ap);
+  size_t w = write((const uint8_t*)buf, (size_t)n);
+  if (buf != locBuf) free(buf);
+  return w;
+}
+
+size_t HardwareSerial::write(const uint8_t* buf, size_t n) {
+  if (g_serialEcho) fwrite(buf, 1, n, stdout);
+  if (g_serialHook) {
+    HalInternalAllocScope scope;
+    g_serialHook((const char*)buf, n);
+  }
+  return n;
+}
+
+void hal_setSerialEcho(bool on) { g_serialEcho = on; }
+void hal_setSerialHook(std::function<void(const char*, size_t)> fn) { g_serialHook = fn; }
+
+// ---- ESP system ----
+
+uint32_t EspClass::getFreeHeap() { return 200000; }
+uint32_t EspClass::getMinFreeHeap() { return 180000; }
+uint32_t EspClass::getHeapSize() { return 320000; }
+uint64_t EspClass::getEfuseMac() { return 0x0000A1B2C3D4E5F6ULL; }
+// 240 MHz core clock expressed on the virtual timeline
+uint32_t EspClass::getCycleCount() { return (uint32_t)(hal_nowUs() * 240ULL); }
+void EspClass::restart() { g_restart = true; }
+void EspClass::deepSleep(uint64_t) { g_restart = true; }
+
+bool hal_restartRequested() { return g_restart; }
+
+// ---- String ----
+
+String::String(float v, unsigned int decimals) : String((double)v, decimals) {}
+
+String::String(double v, unsigned int decimals) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+  s_ = buf;
+}
@@ -0,0 +1,110 @@
+// devices_sim.cpp
+// Peripheral shims: LCD, DHT, I2C, NTP time, EEPROM and LittleFS.
+#include "Arduino.h"
+#include "DHT.h"
+#include "EEPROM.h"
+#include "LittleFS.h"
+#include "NTPClient.h"
+#include "Wire.h"
+#include "hd44780.h"
+#include "hal_sim.h"
+#include <map>
+
+TwoWire Wire;
+EEPROMClass EEPROM;
+LittleFSFS LittleFS;
+
+namespace {
+char g_lcd[4][21];
+float g_dhtTemp = 25.0f;
+float g_dhtHum = 60.0f;
+uint32_t g_epochBase = 1700000000UL;
+std::map<std::string, std::shared_ptr<std::string>> g_files;
+}  // namespace
+
+// ---- LCD ----
+
+int hd44780::begin(uint8_t cols, uint8_t rows) {
+  cols_ = cols > 20 ? 20 : cols;
+  rows_ = rows > 4 ? 4 : rows;
+  clear();
+  return 0;
+}
+
+void hd44780::clear() {
+  for (int r = 0; r < 4; r++) {
+    memset(g_lcd[r], ' ', 20);
+    g_lcd[r][20] = '\0';
+  }
+  col_ = row_ = 0;
+}
+
+size_t hd44780::write(uint8_t c) {
+  if (row_ < rows_ && col_ < cols_) g_lcd[row_][col_] = (char)c;
+  col_++;
+  return 1;
+}
+
+const char* hal_lcdRow(int row) { return (row >= 0 && row < 4) ? g_lcd[row] : ""; }
+
+// ---- DHT ----
+
+float DHT::readTemperature() { return g_dhtTemp; }
+float DHT::readHumidity() { return g_dhtHum; }
+
+void hal_setDht(float temp, float hum) {
+  g_dhtTemp = temp;
+  g_dhtHum = hum;
+}
+
+void hal_getDht(float* temp, float* hum) {
+  *temp = g_dhtTemp;
+  *hum = g_dhtHum;
+}
+
+// ---- NTP ----
+
+unsigned long NTPClient::getEpochTime() const {
+  return g_epochBase + offset_ + (unsigned long)(hal_nowUs() / 1000000ULL);
+}
+
+void hal_setEpochBase(uint32_t epoch) { g_epochBase = epoch; }
+
+// ---- LittleFS ----
+
+bool LittleFSFS::begin(bool, const char*, uint8_t, const char*) {
+  if (!mounted_) {
+    mounted_ = true;
+    mounts_++;
+  }
+  return true;
+}
+
+bool LittleFSFS::exists(const char* path) { return g_files.count(path) != 0; }
+
+File LittleFSFS::open(const char* path, const char* mode) {
+  bool write = mode && (mode[0] == 'w' || mode[0] == 'a');
+  auto it = g_files.find(path);
+  if (!write) {
+    if (it == g_files.end()) return File();
+    return File(it->second, path, false);
+  }
+  if (it == g_files.end() || mode[0] == 'w') {
+    // replace the node so readers holding the old contents are unaffected
+    g_files[path] = std::make_shared<std::string>();
+  }
+  return File(g_files[path], path, true);
+}
+
+bool LittleFSFS::remove(const char* path) { return g_files.erase(path) != 0; }
+
+bool LittleFSFS::format() {
+  g_files.clear();
+  return true;
+}
+
+size_t LittleFSFS::usedBytes() {
+  size_t n = 0;
+  for (auto& f : g_files) n += f.second->size();
+  return n;
+}
@@ -0,0 +1,45 @@
+// esp32-hal-rmt.h (native HAL)
+// RMT receive API of the Arduino-ESP32 2.x core. A receiver on a DHT pin
+// answers like a DHT11: when the firmware releases the pin (pinMode INPUT*)
+// after holding it low for at least 18 ms, the frame built from the
+// hal_setDht() values reaches the callback ~5 ms later on the RMT task.
+// NAN readings leave the pin silent.
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#define RMT_TX_MODE true
+#define RMT_RX_MODE false
+
+typedef enum {
+  RMT_MEM_64 = 1,
+  RMT_MEM_128,
+  RMT_MEM_192,
+  RMT_MEM_256,
+  RMT_MEM_320,
+  RMT_MEM_384,
+  RMT_MEM_448,
+  RMT_MEM_512
+} rmt_reserve_memsize_t;
+
+typedef struct {
+  union {
+    struct {
+      uint32_t duration0 : 15;
+      uint32_t level0 : 1;
+      uint32_t duration1 : 15;
+      uint32_t level1 : 1;
+    };
+    uint32_t val;
+  };
+} rmt_data_t;
+
+typedef struct rmt_obj_s rmt_obj_t;
+typedef void (*rmt_rx_data_cb_t)(uint32_t* data, size_t len, void* arg);
+
+rmt_obj_t* rmtInit(int pin, bool tx_not_rx, rmt_reserve_memsize_t memsize);
+float rmtSetTick(rmt_obj_t* rmt, float tick);
+bool rmtSetRxThreshold(rmt_obj_t* rmt, uint32_t value);
+bool rmtSetFilter(rmt_obj_t* rmt, bool filter_en, uint32_t filter_level);
+bool rmtRead(rmt_obj_t* rmt, rmt_rx_data_cb_t cb, void* arg);
+bool rmtEnd(rmt_obj_t* rmt);
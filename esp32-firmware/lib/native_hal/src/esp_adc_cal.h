@@ -0,0 +1,28 @@
+// esp_adc_cal.h (native HAL)
+// ADC characterisation as in IDF 4.4. The simulated chip has no eFuse
+// calibration: it reports the default Vref and converts linearly over
+// 0..3300 mV, the same as analogReadMilliVolts().
+#pragma once
+#include <stdint.h>
+#include "driver/adc.h"
+
+typedef enum {
+  ESP_ADC_CAL_VAL_EFUSE_VREF = 0,
+  ESP_ADC_CAL_VAL_EFUSE_TP = 1,
+  ESP_ADC_CAL_VAL_DEFAULT_VREF = 2,
+} esp_adc_cal_value_t;
+
+typedef struct {
+  adc_unit_t adc_num;
+  adc_atten_t atten;
+  adc_bits_width_t bit_width;
+  uint32_t coeff_a;
+  uint32_t coeff_b;
+  uint32_t vref;
+  const uint32_t* low_curve;
+  const uint32_t* high_curve;
+} esp_adc_cal_characteristics_t;
+
+esp_adc_cal_value_t esp_adc_cal_characterize(adc_unit_t adc_num, adc_atten_t atten, adc_bits_width_t bit_width,
+                                             uint32_t default_vref, esp_adc_cal_characteristics_t* chars);
+uint32_t esp_adc_cal_raw_to_voltage(uint32_t adc_reading, const esp_adc_cal_characteristics_t* chars);
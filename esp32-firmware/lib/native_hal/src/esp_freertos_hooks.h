@@ -0,0 +1,11 @@
+// esp_freertos_hooks.h (native HAL)
+#pragma once
+#include <stdint.h>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_ERR_NOT_SUPPORTED 0x106
+
+typedef bool (*esp_freertos_idle_cb_t)(void);
+// the simulation has no idle task, so core load stays unreported
+inline esp_err_t esp_register_freertos_idle_hook_for_cpu(esp_freertos_idle_cb_t, unsigned) { return ESP_ERR_NOT_SUPPORTED; }
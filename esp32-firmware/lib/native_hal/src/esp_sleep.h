@@ -0,0 +1,6 @@
+// esp_sleep.h (native HAL)
+#pragma once
+#include <stdint.h>
+
+typedef int gpio_num_t;
+inline int esp_sleep_enable_ext0_wakeup(gpio_num_t, int) { return 0; }
@@ -0,0 +1,4 @@
+// esp_task_wdt.h (native HAL)
+#pragma once
+
+inline int esp_task_wdt_reset() { return 0; }
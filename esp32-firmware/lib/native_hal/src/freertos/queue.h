@@ -0,0 +1,3 @@
+// freertos/queue.h (native HAL)
+#pragma once
+#include "FreeRTOS.h"
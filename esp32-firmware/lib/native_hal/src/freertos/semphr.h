@@ -0,0 +1,3 @@
+// freertos/semphr.h (native HAL)
+#pragma once
+#include "FreeRTOS.h"
@@ -0,0 +1,3 @@
+// freertos/task.h (native HAL)
+#pragma once
+#include "FreeRTOS.h"
@@ -0,0 +1,294 @@
+// freertos_sim.cpp
+// Virtual clock plus a cooperative, deterministic FreeRTOS stand-in.
+//
+// Every task gets its own host thread, but only one context (a task or the
+// driver thread) ever runs at a time. Whenever the running task blocks it
+// picks the task with the earliest wake time (then highest priority, then
+// round-robin), advances the clock to it and hands over directly; control
+// returns to the driver once nothing is due before the end of hal_runUntil().
+// Firmware code therefore costs zero virtual time; only delays, timeouts and
+// injected network latency move the clock.
+#include "freertos/FreeRTOS.h"
+#include "hal_sim.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+struct SimTask {
+  TaskFunction_t fn;
+  void* arg;
+  char name[16];
+  UBaseType_t prio;
+  BaseType_t core;
+  uint32_t stackDepth;
+  uint64_t wakeUs;
+  const void* waitObj;
+  uint32_t seq;
+  bool deleted;
+  std::condition_variable cv;
+};
+
+struct SimQueue {
+  UBaseType_t length;
+  UBaseType_t itemSize;
+  std::deque<std::vector<uint8_t>> items;
+};
+
+namespace {
+struct Sched {
+  std::mutex mu;
+  std::condition_variable driverCv;
+  std::vector<SimTask*> tasks;
+  SimTask* running = nullptr;  // nullptr: the driver thread owns the CPU
+  std::atomic<uint64_t> nowUs{0};
+  uint64_t endUs = 0;          // end of the current hal_runUntil() window
+  bool active = false;         // a hal_runUntil() window is open
+  uint32_t seq = 0;
+};
+
+// Intentionally leaked: task threads stay parked on the condition variable
+// at exit and must never see it destroyed.
+Sched& S() {
+  static Sched* s = new Sched();
+  return *s;
+}
+
+thread_local SimTask* t_self = nullptr;
+
+void parkUntilScheduled(std::unique_lock<std::mutex>& lk, SimTask* t) {
+  t->cv.wait(lk, [t] { return S().running == t; });
+}
+
+SimTask* pickNext() {
+  SimTask* next = nullptr;
+  for (SimTask* t : S().tasks) {
+    if (t->deleted) continue;
+    if (!next || t->wakeUs < next->wakeUs ||
+        (t->wakeUs == next->wakeUs && (t->prio > next->prio ||
+                                       (t->prio == next->prio && t->seq < next->seq)))) {
+      next = t;
+    }
+  }
+  return next;
+}
+
+// Give the CPU to the next due task, or back to the driver. Caller holds mu.
+void dispatch() {
+  SimTask* next = S().active ? pickNext() : nullptr;
+  if (next && next->wakeUs <= S().endUs) {
+    if (next->wakeUs > S().nowUs) S().nowUs = next->wakeUs;
+    S().running = next;
+    next->cv.notify_one();
+  } else {
+    S().running = nullptr;
+    S().driverCv.notify_one();
+  }
+}
+
+void taskEntry(SimTask* t) {
+  t_self = t;
+  {
+    std::unique_lock<std::mutex> lk(S().mu);
+    parkUntilScheduled(lk, t);
+  }
+  t->fn(t->arg);
+  // FreeRTOS tasks must not return; treat it like vTaskDelete(NULL)
+  std::lock_guard<std::mutex> lk(S().mu);
+  t->deleted = true;
+  dispatch();
+}
+
+uint64_t ticksToDeadline(TickType_t ticks) {
+  if (ticks == portMAX_DELAY) return UINT64_MAX;
+  return S().nowUs + (uint64_t)ticks * 1000ULL;
+}
+
+// Block the current context on obj until woken or the deadline passes
+void blockOn(const void* obj, uint64_t wakeUs) {
+  SimTask* t = t_self;
+  if (!t) {
+    // driver thread: nothing else can run, so waiting just moves the clock
+    if (wakeUs != UINT64_MAX && wakeUs > S().nowUs) S().nowUs = wakeUs;
+    return;
+  }
+  std::unique_lock<std::mutex> lk(S().mu);
+  t->wakeUs = wakeUs;
+  t->waitObj = obj;
+  t->seq = ++S().seq;
+  dispatch();
+  parkUntilScheduled(lk, t);
+  t->waitObj = nullptr;
+}
+
+void wakeWaiters(const void* obj) {
+  std::lock_guard<std::mutex> lk(S().mu);
+  for (SimTask* t : S().tasks) {
+    if (t->waitObj == obj && !t->deleted) t->wakeUs = S().nowUs;
+  }
+}
+}  // namespace
+
+// ---- clock ----
+
+uint64_t hal_nowUs() { return S().nowUs; }
+
+void hal_advanceMs(uint32_t ms) { S().nowUs += (uint64_t)ms * 1000ULL; }
+
+void hal_sleepUntil(uint64_t wakeUs) { blockOn(nullptr, wakeUs); }
+
+void hal_runUntil(uint64_t endUs) {
+  std::unique_lock<std::mutex> lk(S().mu);
+  S().endUs = endUs;
+  S().active = true;
+  dispatch();
+  S().driverCv.wait(lk, [] { return S().running == nullptr; });
+  S().active = false;
+  if (endUs > S().nowUs) S().nowUs = endUs;
+}
+
+void hal_runFor(uint32_t ms) { hal_runUntil(S().nowUs + (uint64_t)ms * 1000ULL); }
+
+// ---- tasks ----
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                                   void* param, UBaseType_t prio, TaskHandle_t* out, BaseType_t core) {
+  SimTask* t = new SimTask();
+  t->fn = fn;
+  t->arg = param;
+  strncpy(t->name, name ? name : "", sizeof(t->name) - 1);
+  t->prio = prio;
+  t->core = core;
+  t->stackDepth = stackDepth;
+  t->wakeUs = S().nowUs;
+  t->waitObj = nullptr;
+  t->deleted = false;
+  {
+    std::lock_guard<std::mutex> lk(S().mu);
+    t->seq = ++S().seq;
+    S().tasks.push_back(t);
+  }
+  std::thread(taskEntry, t).detach();
+  if (out) *out = t;
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth,
+                       void* param, UBaseType_t prio, TaskHandle_t* out) {
+  return xTaskCreatePinnedToCore(fn, name, stackDepth, param, prio, out, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t t) {
+  SimTask* self = t_self;
+  if (!t) t = self;
+  if (!t) return;
+  {
+    std::lock_guard<std::mutex> lk(S().mu);
+    t->deleted = true;
+  }
+  // a task deleting itself parks forever; its thread is never scheduled again
+  if (t == self) blockOn(t, UINT64_MAX);
+}
+
+void vTaskDelay(TickType_t ticks) { blockOn(nullptr, ticksToDeadline(ticks)); }
+
+void vTaskDelayUntil(TickType_t* prev, TickType_t increment) {
+  *prev += increment;
+  uint64_t wake = (uint64_t)(*prev) * 1000ULL;
+  blockOn(nullptr, wake > S().nowUs ? wake : (uint64_t)S().nowUs);
+}
+
+TickType_t xTaskGetTickCount() { return (TickType_t)(S().nowUs / 1000ULL); }
+
+TaskHandle_t xTaskGetCurrentTaskHandle() { return t_self; }
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t t) {
+  // the host cannot observe target stack usage; report the full allocation
+  if (!t) t = t_self;
+  return t ? t->stackDepth : 0;
+}
+
+const char* pcTaskGetName(TaskHandle_t t) {
+  if (!t) t = t_self;
+  return t ? t->name : "driver";
+}
+
+BaseType_t xPortGetCoreID() {
+  SimTask* t = t_self;
+  return (t && t->core != tskNO_AFFINITY) ? t->core : 0;
+}
+
+void taskYIELD() { blockOn(nullptr, S().nowUs); }
+
+// ---- queues ----
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  SimQueue* q = new SimQueue();
+  q->length = length;
+  q->itemSize = itemSize;
+  return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t wait) {
+  if (!q) return errQUEUE_FULL;
+  uint64_t deadline = ticksToDeadline(wait);
+  while (q->items.size() >= q->length) {
+    if (wait == 0 || S().nowUs >= deadline) return errQUEUE_FULL;
+    if (!t_self) {
+      blockOn(q, deadline);
+      return errQUEUE_FULL;
+    }
+    blockOn(q, deadline);
+  }
+  const uint8_t* p = (const uint8_t*)item;
+  {
+    // item storage is part of the queue on target
+    HalInternalAllocScope scope;
+    q->items.emplace_back(p, p + q->itemSize);
+  }
+  wakeWaiters(q);
+  return pdPASS;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t q, const void* item, TickType_t wait) {
+  return xQueueSend(q, item, wait);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void* out, TickType_t wait) {
+  if (!q) return pdFAIL;
+  uint64_t deadline = ticksToDeadline(wait);
+  while (q->items.empty()) {
+    if (wait == 0 || S().nowUs >= deadline) return pdFAIL;
+    if (!t_self) {
+      blockOn(q, deadline);
+      return pdFAIL;
+    }
+    blockOn(q, deadline);
+  }
+  if (q->itemSize && out) memcpy(out, q->items.front().data(), q->itemSize);
+  {
+    HalInternalAllocScope scope;
+    q->items.pop_front();
+  }
+  wakeWaiters(q);
+  return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) { return q ? (UBaseType_t)q->items.size() : 0; }
+
+// ---- semaphores (zero-size queues, as in FreeRTOS) ----
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  SemaphoreHandle_t s = xQueueCreate(1, 0);
+  xQueueSend(s, nullptr, 0);
+  return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() { return xQueueCreate(1, 0); }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t wait) { return xQueueReceive(s, nullptr, wait); }
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s) { return xQueueSend(s, nullptr, 0); }
@@ -0,0 +1,112 @@
+// hal_sim.h
+// Host-side control surface of the native HAL. Firmware code never includes
+// this file; simulators and benchmarks under native/ use it to drive the
+// virtual clock, feed inputs (ADC, DHT, buttons) and stand in for the network.
+#ifndef HAL_SIM_H
+#define HAL_SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <string>
+
+// ---- virtual clock ----
+// All time (millis, micros, vTaskDelay, NTP) derives from this clock. It only
+// moves when the driver advances it or a task blocks.
+uint64_t hal_nowUs();
+// Move the clock forward from the driver thread (no tasks run)
+void hal_advanceMs(uint32_t ms);
+// Run the FreeRTOS tasks created so far cooperatively until the clock
+// reaches now + ms. Tasks switch only at blocking calls (vTaskDelay, delay,
+// queue/semaphore waits), so a run is fully deterministic.
+void hal_runFor(uint32_t ms);
+void hal_runUntil(uint64_t endUs);
+// Block the calling context until the clock reaches wakeUs (used by delay-like shims)
+void hal_sleepUntil(uint64_t wakeUs);
+
+// ---- GPIO / ADC / DHT ----
+void hal_setAnalog(uint8_t pin, int value);
+// Optional per-read provider; overrides hal_setAnalog values when set
+void hal_setAnalogSource(std::function<int(uint8_t pin)> fn);
+void hal_setDigitalInput(uint8_t pin, int level);
+int hal_digitalOutput(uint8_t pin);
+// Called on every digitalWrite (pin, level) with the clock already current
+void hal_setGpioWriteHook(std::function<void(uint8_t pin, uint8_t level)> fn);
+// Continuous (DMA) ADC mode, on by default; off makes adc_digi_initialize()
+// fail so the firmware falls back to analogRead()
+void hal_setAdcContinuous(bool available);
+// NAN simulates a failed DHT read
+void hal_setDht(float temp, float hum);
+void hal_getDht(float* temp, float* hum);
+// RMT receivers, on by default; off makes rmtInit() fail so the firmware
+// falls back to the bit-banging DHT library
+void hal_setRmtAvailable(bool available);
+
+// ---- console ----
+// Serial output goes to stdout when echo is on (default) and to the hook always
+void hal_setSerialEcho(bool on);
+void hal_setSerialHook(std::function<void(const char* data, size_t len)> fn);
+
+// ---- network stand-ins ----
+void hal_setWiFiConnected(bool connected);
+void hal_setNetIdentity(const char* ip, const char* mac);
+
+struct HalHttpRequest {
+  const char* method;
+  const char* url;
+  const uint8_t* body;
+  size_t len;
+  size_t headerBytes;  // request line plus headers as the ESP32 HTTPClient sends them
+};
+struct HalHttpResponse {
+  int code;          // HTTP status, or negative HTTPC_ERROR_* for transport errors
+  std::string body;
+  uint32_t delayMs;  // virtual time the request blocks the caller
+};
+// Stub backend for HTTPClient. Without a handler every request fails with
+// HTTPC_ERROR_CONNECTION_REFUSED.
+void hal_setHttpHandler(std::function<HalHttpResponse(const HalHttpRequest&)> fn);
+
+// In-process MQTT broker stand-in used by the PubSubClient shim
+void hal_setMqttAvailable(bool available);
+// Queue a message for delivery on the client's next loop()
+void hal_mqttInject(const char* topic, const char* payload);
+void hal_setMqttPublishHook(std::function<void(const char* topic, const uint8_t* payload, size_t len, bool retained)> fn);
+// Called on every PubSubClient::connect() attempt with its outcome
+void hal_setMqttConnectHook(std::function<void(const char* clientId, bool ok)> fn);
+
+// Invoke a handler registered on the WebServer shim; returns the status code
+int hal_webRequest(int method, const char* uri, const char* body, std::string* response);
+
+// ---- time of day / system ----
+// Epoch (seconds, UTC) that corresponds to clock zero; NTPClient adds its offset
+void hal_setEpochBase(uint32_t epoch);
+// ESP.restart()/deepSleep() cannot leave the process; they only set this flag
+bool hal_restartRequested();
+
+// ---- heap ----
+// Process-wide allocation counters (malloc/calloc/realloc and operator new).
+// Take a snapshot before and after a piece of work to see what it allocated.
+struct HalAllocStats {
+  uint64_t allocs;      // successful allocations, including reallocs
+  uint64_t frees;
+  uint64_t bytes;       // total bytes requested
+  int64_t liveBytes;    // usable bytes currently allocated
+};
+HalAllocStats hal_allocStats();
+// Called after every counted allocation; install it once boot is done to
+// catch steady-state heap use (the hook itself may allocate).
+void hal_setAllocHook(std::function<void(size_t size)> fn);
+// Heap use of the HAL's own bookkeeping (queue items, broker copies, stub
+// backend responses) has no counterpart in the firmware's heap on target.
+// Allocations made while one of these is alive are not counted or hooked.
+struct HalInternalAllocScope {
+  HalInternalAllocScope();
+  ~HalInternalAllocScope();
+};
+
+// ---- LCD ----
+// Current contents of one 20-char row of the hd44780 shim
+const char* hal_lcdRow(int row);
+
+#endif
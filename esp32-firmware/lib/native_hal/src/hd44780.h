@@ -0,0 +1,19 @@
+// hd44780.h (native HAL)
+// 20x4 character LCD backed by a RAM frame buffer readable via hal_lcdRow().
+#pragma once
+#include "Arduino.h"
+
+class hd44780 : public Print {
+public:
+  int begin(uint8_t cols, uint8_t rows);
+  void clear();
+  void setCursor(uint8_t col, uint8_t row) { col_ = col; row_ = row; }
+  void backlight() { backlight_ = true; }
+  void noBacklight() { backlight_ = false; }
+  using Print::write;
+  size_t write(uint8_t c) override;
+
+private:
+  uint8_t cols_ = 20, rows_ = 4, col_ = 0, row_ = 0;
+  bool backlight_ = true;
+};
@@ -0,0 +1,5 @@
+// hd44780ioClass/hd44780_I2Cexp.h (native HAL)
+#pragma once
+#include "../hd44780.h"
+
+class hd44780_I2Cexp : public hd44780 {};
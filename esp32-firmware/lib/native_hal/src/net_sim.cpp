@@ -0,0 +1,255 @@
+// net_sim.cpp
+// Network stand-ins: WiFi link, HTTP stub backend, debug web server and an
+// in-process MQTT broker for the single PubSubClient the firmware owns.
+#include "HTTPClient.h"
+#include "PubSubClient.h"
+#include "Update.h"
+#include "WebServer.h"
+#include "WiFi.h"
+#include "hal_sim.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+WiFiClass WiFi;
+UpdateClass Update;
+
+namespace {
+bool g_linkUp = true;
+bool g_joined = true;
+char g_ip[16] = "192.168.31.50";
+char g_mac[18] = "24:6F:28:A1:B2:C3";
+std::function<HalHttpResponse(const HalHttpRequest&)> g_httpHandler;
+WebServer* g_webServer = nullptr;
+
+struct MqttMessage {
+  std::string topic;
+  std::string payload;
+};
+bool g_brokerUp = true;
+std::vector<std::string> g_subscriptions;
+std::deque<MqttMessage> g_inbox;
+std::function<void(const char*, const uint8_t*, size_t, bool)> g_publishHook;
+std::function<void(const char*, bool)> g_connectHook;
+
+bool topicMatches(const std::string& filter, const std::string& topic) {
+  if (!filter.empty() && filter.back() == '#') return topic.compare(0, filter.size() - 1, filter, 0, filter.size() - 1) == 0;
+  return filter == topic;
+}
+}  // namespace
+
+// ---- WiFi ----
+
+String IPAddress::toString() const {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%u.%u.%u.%u", o_[0], o_[1], o_[2], o_[3]);
+  return String(buf);
+}
+
+bool WiFiClass::mode(wifi_mode_t m) {
+  if (m == WIFI_OFF) g_joined = false;
+  return true;
+}
+
+wl_status_t WiFiClass::begin(const char*, const char*) {
+  g_joined = true;
+  return status();
+}
+
+bool WiFiClass::disconnect(bool) {
+  g_joined = false;
+  return true;
+}
+
+wl_status_t WiFiClass::status() { return (g_linkUp && g_joined) ? WL_CONNECTED : WL_DISCONNECTED; }
+
+IPAddress WiFiClass::localIP() {
+  if (status() != WL_CONNECTED) return IPAddress();
+  unsigned a = 0, b = 0, c = 0, d = 0;
+  sscanf(g_ip, "%u.%u.%u.%u", &a, &b, &c, &d);
+  return IPAddress((uint8_t)a, (uint8_t)b, (uint8_t)c, (uint8_t)d);
+}
+
+String WiFiClass::macAddress() { return String(g_mac); }
+
+uint8_t* WiFiClass::macAddress(uint8_t* mac) {
+  unsigned b[6] = {0};
+  sscanf(g_mac, "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]);
+  for (int i = 0; i < 6; i++) mac[i] = (uint8_t)b[i];
+  return mac;
+}
+
+void hal_setWiFiConnected(bool connected) {
+  g_linkUp = connected;
+  g_joined = connected;
+}
+
+void hal_setNetIdentity(const char* ip, const char* mac) {
+  if (ip) snprintf(g_ip, sizeof(g_ip), "%s", ip);
+  if (mac) snprintf(g_mac, sizeof(g_mac), "%s", mac);
+}
+
+// ---- HTTP ----
+
+void hal_setHttpHandler(std::function<HalHttpResponse(const HalHttpRequest&)> fn) { g_httpHandler = fn; }
+
+int HTTPClient::request(const char* method, const uint8_t* body, size_t len) {
+  HalInternalAllocScope scope;
+  body_.clear();
+  size_ = -1;
+  if (WiFi.status() != WL_CONNECTED) return HTTPC_ERROR_NOT_CONNECTED;
+  if (!g_httpHandler) return HTTPC_ERROR_CONNECTION_REFUSED;
+  // size the request head the way the Arduino-ESP32 HTTPClient writes it
+  size_t hostAt = url_.find("://");
+  hostAt = hostAt == std::string::npos ? 0 : hostAt + 3;
+  size_t pathAt = url_.find('/', hostAt);
+  std::string host = url_.substr(hostAt, pathAt == std::string::npos ? std::string::npos : pathAt - hostAt);
+  std::string head = std::string(method) + " " + (pathAt == std::string::npos ? "/" : url_.substr(pathAt)) +
+                     " HTTP/1.1\r\nHost: " + host +
+                     "\r\nUser-Agent: ESP32HTTPClient\r\nConnection: keep-alive\r\n"
+                     "Accept-Encoding: identity;q=1,chunked;q=0.1,*;q=0\r\n";
+  if (len) head += "Content-Length: " + std::to_string(len) + "\r\n";
+  size_t headerBytes = head.size() + headerBytes_ + 2;
+  HalHttpRequest req = {method, url_.c_str(), body, len, headerBytes};
+  HalHttpResponse resp = g_httpHandler(req);
+  if (resp.delayMs > timeoutMs_) {
+    hal_sleepUntil(hal_nowUs() + (uint64_t)timeoutMs_ * 1000ULL);
+    return HTTPC_ERROR_READ_TIMEOUT;
+  }
+  if (resp.delayMs) hal_sleepUntil(hal_nowUs() + (uint64_t)resp.delayMs * 1000ULL);
+  if (resp.code > 0) {
+    body_ = resp.body;
+    size_ = (int)body_.size();
+    stream_.setData(body_);
+  }
+  return resp.code;
+}
+
+bool HTTPClient::begin(const char* url) {
+  HalInternalAllocScope scope;
+  url_ = url ? url : "";
+  headerBytes_ = 0;
+  return true;
+}
+
+int HTTPClient::GET() { return request("GET", nullptr, 0); }
+
+int HTTPClient::POST(uint8_t* payload, size_t size) { return request("POST", payload, size); }
+
+String HTTPClient::errorToString(int code) {
+  switch (code) {
+    case HTTPC_ERROR_CONNECTION_REFUSED: return String("connection refused");
+    case HTTPC_ERROR_SEND_PAYLOAD_FAILED: return String("send payload failed");
+    case HTTPC_ERROR_NOT_CONNECTED: return String("not connected");
+    case HTTPC_ERROR_CONNECTION_LOST: return String("connection lost");
+    case HTTPC_ERROR_READ_TIMEOUT: return String("read Timeout");
+    default: return String();
+  }
+}
+
+// ---- WebServer ----
+
+WebServer::WebServer(int) { g_webServer = this; }
+
+void WebServer::send(int code, const char*, const String& content) {
+  code_ = code;
+  response_ = content.c_str();
+}
+
+int WebServer::dispatch(HTTPMethod method, const char* uri, const char* body, std::string* response) {
+  for (Route& r : routes_) {
+    if (r.uri != uri || (r.method != HTTP_ANY && r.method != method)) continue;
+    {
+      HalInternalAllocScope scope;
+      body_ = String(body ? body : "");
+      uri_ = String(uri);
+    }
+    code_ = 0;
+    response_.clear();
+    r.fn();
+    if (response) *response = response_;
+    return code_;
+  }
+  return 404;
+}
+
+int hal_webRequest(int method, const char* uri, const char* body, std::string* response) {
+  if (!g_webServer) return -1;
+  return g_webServer->dispatch((HTTPMethod)method, uri, body, response);
+}
+
+// ---- MQTT broker stand-in ----
+
+void hal_setMqttAvailable(bool available) { g_brokerUp = available; }
+
+void hal_mqttInject(const char* topic, const char* payload) { g_inbox.push_back({topic, payload}); }
+
+void hal_setMqttPublishHook(std::function<void(const char*, const uint8_t*, size_t, bool)> fn) { g_publishHook = fn; }
+
+void hal_setMqttConnectHook(std::function<void(const char*, bool)> fn) { g_connectHook = fn; }
+
+bool PubSubClient::connect(const char* id) { return connect(id, nullptr, nullptr, nullptr, 0, false, nullptr); }
+
+bool PubSubClient::connect(const char* id, const char* user, const char* pass) {
+  return connect(id, user, pass, nullptr, 0, false, nullptr);
+}
+
+bool PubSubClient::connect(const char* id, const char*, const char*, const char*, uint8_t, bool, const char*) {
+  HalInternalAllocScope scope;
+  connected_ = g_brokerUp && WiFi.status() == WL_CONNECTED;
+  if (connected_) g_subscriptions.clear();
+  if (g_connectHook) g_connectHook(id, connected_);
+  return connected_;
+}
+
+bool PubSubClient::connected() {
+  if (connected_ && (!g_brokerUp || WiFi.status() != WL_CONNECTED)) connected_ = false;
+  return connected_;
+}
+
+bool PubSubClient::subscribe(const char* topic, uint8_t) {
+  if (!connected()) return false;
+  HalInternalAllocScope scope;
+  g_subscriptions.push_back(topic);
+  return true;
+}
+
+bool PubSubClient::publish(const char* topic, const uint8_t* payload, unsigned int len, bool retained) {
+  if (!connected()) return false;
+  if (MQTT_MAX_HEADER_SIZE + 2 + strlen(topic) + len > bufferSize_) return false;
+  if (g_publishHook) {
+    HalInternalAllocScope scope;
+    g_publishHook(topic, payload, len, retained);
+  }
+  return true;
+}
+
+bool PubSubClient::loop() {
+  if (!connected()) return false;
+  std::vector<char> topic;
+  std::vector<uint8_t> payload;
+  for (;;) {
+    size_t len;
+    {
+      // the real client reads into its fixed buffer; these copies are HAL-side
+      HalInternalAllocScope scope;
+      if (g_inbox.empty()) break;
+      MqttMessage m = g_inbox.front();
+      g_inbox.pop_front();
+      bool subscribed = false;
+      for (const std::string& f : g_subscriptions) subscribed = subscribed || topicMatches(f, m.topic);
+      // the real client drops packets that do not fit its buffer
+      if (!subscribed || !callback_ || MQTT_MAX_HEADER_SIZE + 2 + m.topic.size() + m.payload.size() > bufferSize_) continue;
+      topic.assign(m.topic.begin(), m.topic.end());
+      topic.push_back('\0');
+      payload.assign(m.payload.begin(), m.payload.end());
+      payload.push_back(0);
+      len = m.payload.size();
+    }
+    callback_(topic.data(), payload.data(), (unsigned int)len);
+  }
+  HalInternalAllocScope scope;
+  std::vector<char>().swap(topic);
+  std::vector<uint8_t>().swap(payload);
+  return true;
+}
@@ -0,0 +1,126 @@
+// rmt_sim.cpp
+// RMT receiver shim (esp32-hal-rmt.h) that plays a DHT11 on the virtual clock.
+#include "Arduino.h"
+#include "hal_sim.h"
+#include "esp32-hal-rmt.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+struct rmt_obj_s {
+  int pin;
+  float tickNs;
+  rmt_rx_data_cb_t cb;
+  void* arg;
+  QueueHandle_t releases;  // low-pulse lengths (us) from pinMode()
+  uint64_t lowSinceUs;
+  bool output;
+};
+
+namespace {
+const int NUM_PINS = 40;
+rmt_obj_s* g_rx[NUM_PINS];
+bool g_available = true;
+
+// DHT11 frame: 80 us low/high response, then per bit 50 us low and a
+// 26 us (0) or 70 us (1) high, then 50 us low before the line idles
+size_t buildDht11Frame(rmt_data_t* items, size_t maxItems, float temp, float hum, float tickNs) {
+  uint8_t b[5];
+  float ht = fabsf(temp);
+  b[0] = (uint8_t)hum;
+  b[1] = (uint8_t)((hum - (int)hum) * 10.0f + 0.5f) % 10;
+  b[2] = (uint8_t)ht;
+  b[3] = (uint8_t)((uint8_t)((ht - (int)ht) * 10.0f + 0.5f) % 10 | (temp < 0 ? 0x80 : 0));
+  b[4] = (uint8_t)(b[0] + b[1] + b[2] + b[3]);
+  // (level, us) pairs; a zero duration ends the frame as the idle line does
+  uint8_t level[84];
+  uint32_t us[84];
+  size_t np = 0;
+  auto pulse = [&](uint8_t lv, uint32_t d) {
+    level[np] = lv;
+    us[np++] = d;
+  };
+  pulse(0, 80);
+  pulse(1, 80);
+  for (int i = 0; i < 40; i++) {
+    pulse(0, 50);
+    pulse(1, (b[i / 8] & (0x80 >> (i % 8))) ? 70 : 26);
+  }
+  pulse(0, 50);
+  pulse(1, 0);
+  size_t n = 0;
+  for (size_t i = 0; i + 1 < np && n < maxItems; i += 2, n++) {
+    items[n].val = 0;
+    items[n].level0 = level[i];
+    items[n].duration0 = (uint32_t)(us[i] * 1000.0f / tickNs);
+    items[n].level1 = level[i + 1];
+    items[n].duration1 = (uint32_t)(us[i + 1] * 1000.0f / tickNs);
+  }
+  return n;
+}
+
+// Stands in for the core's RMT receive task
+void rmtRxTask(void* pv) {
+  rmt_obj_s* rmt = (rmt_obj_s*)pv;
+  while (true) {
+    uint32_t lowUs;
+    if (xQueueReceive(rmt->releases, &lowUs, portMAX_DELAY) != pdPASS) continue;
+    float temp, hum;
+    hal_getDht(&temp, &hum);
+    if (lowUs < 18000 || isnan(temp) || isnan(hum)) continue;  // the sensor never answers
+    vTaskDelay(pdMS_TO_TICKS(5));
+    rmt_data_t items[64];
+    size_t n = buildDht11Frame(items, 64, temp, hum, rmt->tickNs);
+    rmt->cb((uint32_t*)items, n, rmt->arg);
+  }
+}
+}  // namespace
+
+void hal_setRmtAvailable(bool available) { g_available = available; }
+
+// Arduino pinMode() reports here so a receiver sees the host's start pulse
+void rmtSimPinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= NUM_PINS || !g_rx[pin]) return;
+  rmt_obj_s* rmt = g_rx[pin];
+  if (mode == OUTPUT) {
+    rmt->output = true;
+    rmt->lowSinceUs = hal_nowUs();
+  } else if (rmt->output) {
+    rmt->output = false;
+    uint32_t lowUs = hal_digitalOutput(pin) == LOW ? (uint32_t)(hal_nowUs() - rmt->lowSinceUs) : 0;
+    if (rmt->cb) xQueueSend(rmt->releases, &lowUs, 0);
+  }
+}
+
+rmt_obj_t* rmtInit(int pin, bool tx_not_rx, rmt_reserve_memsize_t) {
+  if (!g_available || tx_not_rx || pin < 0 || pin >= NUM_PINS) return nullptr;
+  rmt_obj_s* rmt = new rmt_obj_s();
+  rmt->pin = pin;
+  rmt->tickNs = 100.0f;
+  rmt->releases = xQueueCreate(2, sizeof(uint32_t));
+  g_rx[pin] = rmt;
+  return rmt;
+}
+
+float rmtSetTick(rmt_obj_t* rmt, float tick) {
+  if (!rmt) return 0;
+  rmt->tickNs = tick;
+  return tick;
+}
+
+bool rmtSetRxThreshold(rmt_obj_t* rmt, uint32_t) { return rmt != nullptr; }
+bool rmtSetFilter(rmt_obj_t* rmt, bool, uint32_t) { return rmt != nullptr; }
+
+bool rmtRead(rmt_obj_t* rmt, rmt_rx_data_cb_t cb, void* arg) {
+  if (!rmt || !cb) return false;
+  bool first = !rmt->cb;
+  rmt->cb = cb;
+  rmt->arg = arg;
+  if (first) xTaskCreatePinnedToCore(rmtRxTask, "rmt_rx_task", 4096, rmt, 20, nullptr, 1);
+  return true;
+}
+
+bool rmtEnd(rmt_obj_t* rmt) {
+  if (!rmt) return false;
+  g_rx[rmt->pin] = nullptr;
+  return true;  // the receive task stays parked on its queue
+}
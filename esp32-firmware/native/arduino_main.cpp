@@ -0,0 +1,14 @@
+// arduino_main.cpp
+// Builds main.ino for the native env (PlatformIO only converts sketches for
+// the arduino framework) and stands in for the core's loopTask.
+#include "../src/main.ino"
+#include "arduino_main.h"
+
+static void loopTask(void* param) {
+  setup();
+  for (;;) loop();
+}
+
+void startLoopTask() {
+  xTaskCreatePinnedToCore(loopTask, "loopTask", 8192, NULL, 1, NULL, 1);
+}
@@ -0,0 +1,10 @@
+// arduino_main.h
+// Entry points of the sketch compiled for the native env.
+#ifndef ARDUINO_MAIN_H
+#define ARDUINO_MAIN_H
+
+// Create the Arduino loopTask (setup() once, then loop() forever) exactly like
+// the ESP32 core does; it runs when the driver calls hal_runFor().
+void startLoopTask();
+
+#endif
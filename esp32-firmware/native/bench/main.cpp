@@ -0,0 +1,305 @@
+// bench/main.cpp
+// Host microbenchmarks for the work the firmware repeats every cycle:
+// settings CRC, telemetry JSON build/serialize, server response parse,
+// MQTT config apply, LCD main-screen formatting, the per-sample sensor
+// filters (sensor_filter.h) against the inline math they replaced, one
+// pass over the relay rule table, and the alert rule check after a sample.
+//
+// Usage: program [--json FILE] [--filter SUBSTR] [--min-ms N]
+// Reports ns/op plus heap allocations and bytes per op. The JSON file is what
+// scripts/bench_compare.py diffs against a stored baseline.
+#include "config.h"
+#include "sensors.h"
+#include "eeprom_utils.h"
+#include "wifi_server.h"
+#include "mqtt_client.h"
+#include "lcd_menu.h"
+#include "sensor_filter.h"
+#include "adc_calibration.h"
+#include "sensor_stats.h"
+#include "relay_control.h"
+#include "alerts.h"
+#include "hal_sim.h"
+#include <ArduinoJson.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct BenchResult {
+  std::string name;
+  uint64_t iterations;
+  double nsPerOp;
+  double allocsPerOp;
+  double bytesPerOp;
+};
+
+volatile uint32_t g_sink;
+uint32_t g_minMs = 200;
+
+uint64_t nowNs() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename F>
+uint64_t timeBatch(F& fn, uint64_t n) {
+  uint64_t t0 = nowNs();
+  for (uint64_t i = 0; i < n; i++) fn();
+  return nowNs() - t0;
+}
+
+// Size a batch to ~g_minMs, then keep the fastest of 5 batches (least
+// disturbed by the host). Allocations are counted over one extra batch.
+template <typename F>
+BenchResult measure(const char* name, F fn) {
+  uint64_t n = 1;
+  uint64_t target = (uint64_t)g_minMs * 1000000ULL / 5;
+  for (;;) {
+    uint64_t ns = timeBatch(fn, n);
+    if (ns >= target / 4 || n >= (1ULL << 30)) {
+      if (ns > 0) n = n * target / ns + 1;
+      break;
+    }
+    n *= 4;
+  }
+  double best = 1e30;
+  for (int rep = 0; rep < 5; rep++) {
+    double perOp = (double)timeBatch(fn, n) / (double)n;
+    if (perOp < best) best = perOp;
+  }
+  HalAllocStats before = hal_allocStats();
+  timeBatch(fn, n);
+  HalAllocStats after = hal_allocStats();
+  BenchResult r;
+  r.name = name;
+  r.iterations = n;
+  r.nsPerOp = best;
+  r.allocsPerOp = (double)(after.allocs - before.allocs) / (double)n;
+  r.bytesPerOp = (double)(after.bytes - before.bytes) / (double)n;
+  return r;
+}
+
+// Representative /status response: pending config plus top-level fields,
+// sized like real responses (must fit the firmware's 1024-byte buffer).
+const char* kServerResponse =
+    "{\"ok\":true,\"id\":\"SMFVN-A1B2C3\",\"addedToWeb\":true,\"dailyWater\":false,"
+    "\"tempThresh\":30.5,\"humThresh\":70,\"soilThresh\":45,\"lightThresh\":35,"
+    "\"phThreshMin\":5.5,\"phThreshMax\":7.5,\"lightAuto\":true,"
+    "\"pending\":{\"tempThresh\":30.5,\"humThresh\":70,\"soilThresh\":45,"
+    "\"lightThresh\":35,\"phThreshMin\":5.5,\"phThreshMax\":7.5,\"pumpAuto\":true,"
+    "\"fanAuto\":true,\"lightAuto\":true,\"schedules\":["
+    "{\"hour\":6,\"minute\":0,\"forPump\":true,\"forLight\":false},"
+    "{\"hour\":12,\"minute\":30,\"forPump\":true,\"forLight\":false},"
+    "{\"hour\":17,\"minute\":45,\"forPump\":true,\"forLight\":true},"
+    "{\"hour\":18,\"minute\":0,\"forPump\":false,\"forLight\":true}]},"
+    "\"schedules\":["
+    "{\"hour\":6,\"minute\":0,\"forPump\":true,\"forLight\":false},"
+    "{\"hour\":12,\"minute\":30,\"forPump\":true,\"forLight\":false},"
+    "{\"hour\":17,\"minute\":45,\"forPump\":true,\"forLight\":true},"
+    "{\"hour\":18,\"minute\":0,\"forPump\":false,\"forLight\":true}],"
+    "\"ota\":false,\"reset\":false,\"relay_override\":false,"
+    "\"updatedAt\":\"2024-05-01T10:20:30Z\"}";
+
+// Typical devices/<id>/config message from the dashboard
+const char* kMqttConfig =
+    "{\"tempThresh\":31,\"humThresh\":75,\"soilThresh\":40,\"lightThresh\":30,"
+    "\"phThreshMin\":5.8,\"phThreshMax\":7.2,\"pumpAuto\":true,\"fanAuto\":true,"
+    "\"lightAuto\":true,\"schedules\":[{\"hour\":6,\"minute\":0,\"forPump\":true,"
+    "\"forLight\":false},{\"hour\":18,\"minute\":0,\"forPump\":false,\"forLight\":true}]}";
+
+// raw ADC means as readSensors() sees them: soil, soil, light, pH, with a
+// spike every few cycles so the median stage has something to reject
+const int kRawSamples[8][4] = {
+    {2410, 2380, 1445, 164}, {2405, 2391, 2187, 262}, {2398, 2377, 1499, 178},
+    {2420, 2385, 2063, 733}, {2402, 2379, 1503, 141}, {3900, 2388, 1481, 155},
+    {2399, 2384, 1490, 160}, {2411, 2390, 1476, 170}};
+volatile uint32_t g_rawIdx;
+
+void setupFirmwareState() {
+  hal_setSerialEcho(false);
+  hal_advanceMs(2000);
+  loadSettings();
+  initAdcCalibration();
+  lcdMutex = xSemaphoreCreateMutex();
+  sensorValues[SENSOR_TEMP] = 27.4f;
+  sensorValues[SENSOR_HUM] = 61.0f;
+  sensorValues[SENSOR_SOIL1] = 48;
+  sensorValues[SENSOR_SOIL2] = 52;
+  sensorValues[SENSOR_LIGHT] = 73;
+  sensorValues[SENSOR_PH] = 6.6f;
+  publishSensorState();
+  hal_setWiFiConnected(true);
+  mqtt_init();
+}
+
+void printResult(const BenchResult& r) {
+  printf("%-28s %12.1f %10.2f %10.1f %12llu\n", r.name.c_str(), r.nsPerOp, r.allocsPerOp, r.bytesPerOp,
+         (unsigned long long)r.iterations);
+}
+
+bool writeJson(const char* path, const std::vector<BenchResult>& results) {
+  FILE* f = fopen(path, "w");
+  if (!f) return false;
+  fprintf(f, "{\n  \"firmware\": \"%s\",\n  \"results\": [\n", FIRMWARE_VERSION);
+  for (size_t i = 0; i < results.size(); i++) {
+    const BenchResult& r = results[i];
+    fprintf(f, "    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.1f, "
+               "\"allocs_per_op\": %.3f, \"bytes_per_op\": %.1f}%s\n",
+            r.name.c_str(), (unsigned long long)r.iterations, r.nsPerOp, r.allocsPerOp, r.bytesPerOp,
+            i + 1 < results.size() ? "," : "");
+  }
+  fprintf(f, "  ]\n}\n");
+  fclose(f);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const char* jsonPath = nullptr;
+  const char* filter = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) jsonPath = argv[++i];
+    else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) filter = argv[++i];
+    else if (strcmp(argv[i], "--min-ms") == 0 && i + 1 < argc) g_minMs = (uint32_t)atoi(argv[++i]);
+  }
+
+  setupFirmwareState();
+
+  std::vector<BenchResult> results;
+  auto run = [&](const char* name, auto fn) {
+    if (filter && !strstr(name, filter)) return;
+    results.push_back(measure(name, fn));
+    printResult(results.back());
+  };
+
+  printf("%-28s %12s %10s %10s %12s\n", "benchmark", "ns/op", "allocs/op", "bytes/op", "iterations");
+
+  run("crc32_settings", [] { g_sink = crc32((const uint8_t*)&settings, sizeof(Settings)); });
+
+  static char payload[1536];  // g_payloadBuf in wifi_server.cpp
+  run("telemetry_build_serialize", [] { g_sink = (uint32_t)buildTelemetryPayload(payload, sizeof(payload)); });
+  telemetryPersistConfig = true;
+  run("telemetry_build_persist", [] { g_sink = (uint32_t)buildTelemetryPayload(payload, sizeof(payload)); });
+  telemetryPersistConfig = false;
+
+  run("mqtt_publish_telemetry", [] { mqtt_publishTelemetry(); });
+
+  // same buffer type and document size as handleServerComm()
+  static char responseBuf[1024];
+  strncpy(responseBuf, kServerResponse, sizeof(responseBuf) - 1);
+  run("server_response_parse", [] {
+    DynamicJsonDocument respDoc(4096);
+    DeserializationError error = deserializeJson(respDoc, responseBuf);
+    g_sink = error ? 0 : (uint32_t)respDoc.memoryUsage();
+  });
+
+  // parse once; the benchmark covers applyConfigFromJson() including its
+  // EEPROM/identity persist, relay evaluation and main-screen redraw
+  static StaticJsonDocument<2048> configDoc;
+  deserializeJson(configDoc, kMqttConfig);
+  run("apply_config_from_json", [] { applyConfigFromJson(configDoc.as<JsonObjectConst>()); });
+
+  run("draw_main_screen", [] { drawMainScreen(); });
+
+  // one readSensors() worth of conversion (4 channels): the old inline float
+  // map/constrain/EMA against the fixed-point pipelines (calibration table
+  // lookup, median-of-3, map, EMA)
+  run("sensor_filter_inline", [] {
+    // the pre-pipeline SensorState fields
+    static int soil1, soil2, light;
+    static float ph = 7.0f;
+    const int* r = kRawSamples[g_rawIdx++ & 7];
+    const float ALPHA = 0.3f;
+    int s1 = constrain(map(r[0], 3800, 1000, 0, 100), 0, 100);
+    int s2 = constrain(map(r[1], 3800, 1000, 0, 100), 0, 100);
+    int percent = (int)((long)r[2] * 100L / 4095);
+    int l = constrain(100 - percent, 0, 100);
+    float voltage = ((float)r[3] * 3.3f) / 4095.0f;
+    float computedPH = 7.0f + ((2.5f - voltage) / 0.18f);
+    soil1 = (int)(ALPHA * s1 + (1.0f - ALPHA) * soil1);
+    soil2 = (int)(ALPHA * s2 + (1.0f - ALPHA) * soil2);
+    light = (int)(ALPHA * l + (1.0f - ALPHA) * light);
+    ph = ALPHA * computedPH + (1.0f - ALPHA) * ph;
+    g_sink = (uint32_t)(soil1 + soil2 + light) + (uint32_t)ph;
+  });
+  run("sensor_filter_pipeline", [] {
+    typedef FilterPipeline<int, FilterAdcMv<int>, FilterMedian<int, FILTER_MEDIAN_MAX>, FilterMap<int>,
+                           FilterEma<int>> SensorFilter;
+    static SensorFilter soil1, soil2, light, ph;
+    const int* r = kRawSamples[g_rawIdx++ & 7];
+    sensorValues[SENSOR_SOIL1] = (float)soil1.process(r[0], settings.filters[FILTER_SOIL1]);
+    sensorValues[SENSOR_SOIL2] = (float)soil2.process(r[1], settings.filters[FILTER_SOIL2]);
+    sensorValues[SENSOR_LIGHT] = (float)light.process(r[2], settings.filters[FILTER_LIGHT]);
+    sensorValues[SENSOR_PH] = ph.process(r[3], settings.filters[FILTER_PH]) / 1000.0f;
+  });
+
+  // one reading into both statistics windows (Welford update + threshold time)
+  run("sensor_stats_add", [] {
+    static unsigned long t = 10000;
+    statsAdd(SENSOR_SOIL1, (float)(40 + (g_rawIdx++ & 15)), t += 5000);
+  });
+
+  // seqlock: the sensor task's publish and an uncontended reader's copy
+  run("sensor_state_publish", [] { publishSensorState(); });
+  run("sensor_state_snapshot", [] {
+    SensorSnapshot snap;
+    snapshotSensorState(&snap);
+    g_sink = snap.seq;
+  });
+
+  // one control cycle of the rule table: the three default rules, then a full
+  // MAX_RULES table; values stay inside the bands so no relay switches
+  settings.pumpAuto = settings.fanAuto = settings.lightAuto = true;
+  sensorValues[SENSOR_SOIL1] = sensorValues[SENSOR_SOIL2] = settings.soilThresh + 2;
+  sensorValues[SENSOR_TEMP] = settings.tempThresh - 0.5f;
+  sensorValues[SENSOR_LIGHT] = settings.lightThresh + 2;
+  defaultRelayRules();
+  run("relay_rules_default", [] {
+    static unsigned long t = 10000;
+    g_sink = evaluateRules(sensorValues, 0xFF, t += 1000);
+  });
+  static StaticJsonDocument<2048> rulesDoc;
+  JsonArray rules = rulesDoc.to<JsonArray>();
+  for (uint8_t i = 0; i < MAX_RULES; i++) {
+    JsonObject r = rules.createNestedObject();
+    static const char* const kRelays[] = {"pump", "fan", "light"};
+    static const char* const kSensors[] = {"soil", "temp", "light"};
+    r["relay"] = kRelays[i % 3];
+    r["sensor"] = kSensors[i % 3];
+    r["cmp"] = i % 3 == 1 ? ">" : "<";
+    r["band"] = 5;
+    r["minOn"] = 5;
+    r["maxRun"] = 10;
+  }
+  applyRuleConfig(rules);
+  run("relay_rules_max", [] {
+    static unsigned long t = 10000;
+    g_sink = evaluateRules(sensorValues, 0xFF, t += 1000);
+  });
+  // a soil reading only wakes the rules that read soil
+  run("relay_rules_max_soil_event", [] {
+    static unsigned long t = 10000;
+    g_sink = evaluateRules(sensorValues, (1u << SENSOR_SOIL1) | (1u << SENSOR_SOIL2), t += 1000);
+  });
+
+  // the alert check the sensor task adds to a pH reading; pH in range, so
+  // nothing is queued
+  defaultAlertRules();
+  sensorValues[SENSOR_PH] = 6.5f;
+  run("alerts_evaluate_ph", [] {
+    static unsigned long t = 10000;
+    alertsEvaluate(1u << SENSOR_PH, t += 1000);
+  });
+
+  if (jsonPath) {
+    if (!writeJson(jsonPath, results)) {
+      fprintf(stderr, "cannot write %s\n", jsonPath);
+      return 1;
+    }
+    printf("results written to %s\n", jsonPath);
+  }
+  return 0;
+}
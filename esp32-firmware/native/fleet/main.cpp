@@ -0,0 +1,304 @@
+// fleet/main.cpp
+// Fleet simulator: runs N copies of the full firmware (telemetry POSTs,
+// retryFailedPayloads(), MQTT telemetry/heartbeat) against a stand-in backend
+// and broker, each device with its own ID, sensors and boot time, and reports
+// what the backend sees: request rate, burstiness and bytes on the wire.
+//
+// The firmware keeps its state in globals, so every device is a forked
+// process on its own virtual clock; records are merged onto one timeline.
+//
+// Usage: program [--devices N] [--minutes M] [--boot-spread S]
+//                [--outage START:LEN] [--http-delay MS] [--jobs J] [--seed N]
+#include "config.h"
+#include "eeprom_utils.h"
+#include "hal_sim.h"
+#include "../arduino_main.h"
+#include <algorithm>
+#include <math.h>
+#include <random>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+enum Kind : uint8_t {
+  HTTP_STATUS,
+  HTTP_RETRY,
+  HTTP_OTHER,
+  MQTT_TELEMETRY,
+  MQTT_HEARTBEAT,
+  MQTT_OTHER,
+  MQTT_CONNECT,
+  KIND_COUNT
+};
+const char* kKindNames[KIND_COUNT] = {"http status", "http retry", "http other", "mqtt telemetry",
+                                      "mqtt heartbeat", "mqtt other", "mqtt connect"};
+
+struct Record {
+  uint64_t tUs;       // fleet timeline (device boot offset applied)
+  uint32_t bytesUp;   // device -> server
+  uint32_t bytesDown; // server -> device
+  uint16_t device;
+  uint8_t kind;
+  uint8_t ok;
+};
+
+struct Options {
+  uint32_t devices = 100;
+  uint32_t minutes = 30;
+  uint32_t bootSpreadS = 0;  // 0: every device powers on together
+  uint32_t outageStartS = 0;
+  uint32_t outageLenS = 0;
+  uint32_t httpDelayMs = 80;
+  uint32_t jobs = 0;
+  uint32_t seed = 1;
+};
+
+// Rough sizes of what the stand-ins do not model byte for byte
+const uint32_t HTTP_RESPONSE_HEAD = 120;  // status line + server headers
+const uint32_t TCP_HANDSHAKE = 3 * 60;    // SYN/SYN-ACK/ACK incl. IP headers, Connection: close
+const uint32_t MQTT_CONNACK = 4;
+
+Options g_opt;
+
+// ---- per-device process ----
+
+uint16_t g_device;
+uint64_t g_bootUs;
+bool g_backendUp = true;
+std::mt19937 g_rng;
+std::vector<Record> g_records;
+float g_soil, g_light, g_temp, g_ph;
+
+void record(Kind kind, uint32_t up, uint32_t down, bool ok) {
+  g_records.push_back({hal_nowUs() + g_bootUs, up, down, g_device, (uint8_t)kind, (uint8_t)ok});
+}
+
+uint32_t mqttPublishBytes(size_t topicLen, size_t len) {
+  size_t remaining = 2 + topicLen + len;
+  return (uint32_t)(1 + (remaining > 127 ? 2 : 1) + remaining);
+}
+
+HalHttpResponse backend(const HalHttpRequest& req) {
+  HalHttpResponse resp;
+  resp.code = 200;
+  resp.body = "{\"ok\":true}";
+  resp.delayMs = g_opt.httpDelayMs;
+  Kind kind = HTTP_OTHER;
+  if (strstr(req.url, "/status")) {
+    kind = HTTP_STATUS;
+    // retryFailedPayloads() re-sends stored payloads built earlier
+    const char* up = req.body ? strstr((const char*)req.body, "\"uptimeMs\":") : nullptr;
+    if (up && strtoull(up + 11, nullptr, 10) + 1000 < millis()) kind = HTTP_RETRY;
+  }
+  uint32_t bytesUp = (uint32_t)(req.headerBytes + req.len) + TCP_HANDSHAKE;
+  if (!g_backendUp) {
+    resp.code = HTTPC_ERROR_CONNECTION_REFUSED;
+    resp.body.clear();
+    resp.delayMs = 0;
+    record(kind, TCP_HANDSHAKE / 3, TCP_HANDSHAKE / 3, false);
+    return resp;
+  }
+  record(kind, bytesUp, HTTP_RESPONSE_HEAD + (uint32_t)resp.body.size(), true);
+  return resp;
+}
+
+void onPublish(const char* topic, const uint8_t*, size_t len, bool) {
+  const char* leaf = strrchr(topic, '/');
+  Kind kind = MQTT_OTHER;
+  if (leaf && strcmp(leaf, "/telemetry") == 0) kind = MQTT_TELEMETRY;
+  else if (leaf && strcmp(leaf, "/heartbeat") == 0) kind = MQTT_HEARTBEAT;
+  record(kind, mqttPublishBytes(strlen(topic), len), 0, true);
+}
+
+void onMqttConnect(const char* clientId, bool ok) {
+  // CONNECT with client id, will topic/message and credentials, ~60 bytes of framing
+  record(MQTT_CONNECT, (uint32_t)(60 + strlen(clientId)), ok ? MQTT_CONNACK : 0, ok);
+}
+
+int onAnalogRead(uint8_t pin) {
+  std::normal_distribution<float> noise(0.0f, 8.0f);
+  switch (pin) {
+    case SOIL1_PIN: return (int)(3800 - g_soil * 28.0f + noise(g_rng));
+    case SOIL2_PIN: return (int)(3800 - (g_soil + 3.0f) * 28.0f + noise(g_rng));
+    case LDR_PIN: return (int)(4095 * (1.0f - g_light / 100.0f) + noise(g_rng));
+    case PH_PIN: return (int)((2.5f - (g_ph - 7.0f) * 0.18f) / 3.3f * 4095.0f + noise(g_rng));
+  }
+  return 0;
+}
+
+// Write a valid EEPROM image with this device's identity so setup() boots
+// straight into it (fresh devices would all derive the same ID from millis()).
+void provision() {
+  loadSettings();
+  snprintf(settings.deviceID, sizeof(settings.deviceID), "SIM%04u", g_device);
+  snprintf(settings.token, sizeof(settings.token), "%04u", (unsigned)(g_rng() % 10000));
+  saveSettingsNow();
+  char ip[16], mac[18];
+  snprintf(ip, sizeof(ip), "10.0.%u.%u", g_device / 250, g_device % 250 + 2);
+  snprintf(mac, sizeof(mac), "24:6F:28:00:%02X:%02X", g_device >> 8, g_device & 0xFF);
+  hal_setNetIdentity(ip, mac);
+}
+
+void runDevice(uint16_t device, int fd) {
+  g_device = device;
+  g_rng.seed(g_opt.seed * 7919u + device);
+  uint64_t spreadUs = (uint64_t)g_opt.bootSpreadS * 1000000ULL;
+  g_bootUs = spreadUs ? std::uniform_int_distribution<uint64_t>(0, spreadUs)(g_rng) : 0;
+  g_soil = std::uniform_real_distribution<float>(35.0f, 75.0f)(g_rng);
+  g_light = std::uniform_real_distribution<float>(10.0f, 90.0f)(g_rng);
+  g_temp = std::uniform_real_distribution<float>(22.0f, 32.0f)(g_rng);
+  g_ph = std::uniform_real_distribution<float>(6.0f, 7.0f)(g_rng);
+
+  hal_setSerialEcho(false);
+  hal_setWiFiConnected(true);
+  hal_setHttpHandler(backend);
+  hal_setMqttPublishHook(onPublish);
+  hal_setMqttConnectHook(onMqttConnect);
+  hal_setAnalogSource(onAnalogRead);
+  hal_setDht(g_temp, 60.0f);
+  provision();
+
+  uint64_t endUs = (uint64_t)g_opt.minutes * 60000000ULL;
+  uint64_t outageStart = (uint64_t)g_opt.outageStartS * 1000000ULL;
+  uint64_t outageEnd = outageStart + (uint64_t)g_opt.outageLenS * 1000000ULL;
+  startLoopTask();
+  while (hal_nowUs() + g_bootUs < endUs) {
+    uint64_t t = hal_nowUs() + g_bootUs;
+    bool down = g_opt.outageLenS && t >= outageStart && t < outageEnd;
+    g_backendUp = !down;
+    hal_setMqttAvailable(!down);
+    // stop exactly at outage edges, otherwise step a second at a time
+    uint64_t next = t + 1000000ULL;
+    if (g_opt.outageLenS && t < outageStart) next = std::min(next, outageStart);
+    if (g_opt.outageLenS && t < outageEnd) next = std::min(next, outageEnd);
+    next = std::min(next, endUs);
+    hal_runUntil(next - g_bootUs);
+    g_soil -= 0.0002f;
+  }
+
+  const char* p = (const char*)g_records.data();
+  size_t left = g_records.size() * sizeof(Record);
+  while (left) {
+    ssize_t n = write(fd, p, left);
+    if (n <= 0) break;
+    p += n;
+    left -= (size_t)n;
+  }
+}
+
+// ---- aggregation ----
+
+struct Series {
+  std::vector<uint32_t> perSecond;
+  uint64_t count = 0;
+  uint64_t failed = 0;
+  uint64_t bytesUp = 0;
+  uint64_t bytesDown = 0;
+};
+
+void summarize(const char* name, const Series& s, double seconds) {
+  uint32_t peak = s.perSecond.empty() ? 0 : *std::max_element(s.perSecond.begin(), s.perSecond.end());
+  printf("%-15s %9llu %7llu %11.1f %11.1f %8.2f %7u\n", name, (unsigned long long)s.count,
+         (unsigned long long)s.failed, s.bytesUp / 1024.0, s.bytesDown / 1024.0, s.count / seconds, peak);
+}
+
+void burstiness(const std::vector<uint32_t>& perSecond, const std::vector<uint32_t>& per100ms) {
+  double n = (double)perSecond.size();
+  double mean = 0, var = 0;
+  for (uint32_t c : perSecond) mean += c;
+  mean /= n;
+  for (uint32_t c : perSecond) var += (c - mean) * (c - mean);
+  var /= n;
+  std::vector<uint32_t> sorted(perSecond);
+  std::sort(sorted.begin(), sorted.end());
+  uint32_t p99 = sorted[std::min(sorted.size() - 1, (size_t)(0.99 * (sorted.size() - 1) + 0.5))];
+  size_t peakAt = std::max_element(perSecond.begin(), perSecond.end()) - perSecond.begin();
+  uint32_t peak100 = *std::max_element(per100ms.begin(), per100ms.end());
+  printf("\nrequests/s: mean %.2f  p99 %u  peak %u (at t=%zus)  peak in 100 ms: %u\n", mean, p99,
+         perSecond[peakAt], peakAt, peak100);
+  printf("burstiness: peak/mean %.1f  index of dispersion %.2f (1 = Poisson, >1 = herding)\n",
+         mean > 0 ? perSecond[peakAt] / mean : 0.0, mean > 0 ? var / mean : 0.0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    auto next = [&]() { return i + 1 < argc ? (uint32_t)strtoul(argv[++i], nullptr, 10) : 0u; };
+    if (strcmp(argv[i], "--devices") == 0) g_opt.devices = next();
+    else if (strcmp(argv[i], "--minutes") == 0) g_opt.minutes = next();
+    else if (strcmp(argv[i], "--boot-spread") == 0) g_opt.bootSpreadS = next();
+    else if (strcmp(argv[i], "--http-delay") == 0) g_opt.httpDelayMs = next();
+    else if (strcmp(argv[i], "--jobs") == 0) g_opt.jobs = next();
+    else if (strcmp(argv[i], "--seed") == 0) g_opt.seed = next();
+    else if (strcmp(argv[i], "--outage") == 0 && i + 1 < argc) {
+      sscanf(argv[++i], "%u:%u", &g_opt.outageStartS, &g_opt.outageLenS);
+    }
+  }
+  if (!g_opt.devices || g_opt.devices > 65535) g_opt.devices = 100;
+  if (!g_opt.minutes) g_opt.minutes = 30;
+  if (!g_opt.jobs) g_opt.jobs = (uint32_t)std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+
+  // one anonymous temp file per device; children write, parent reads back
+  std::vector<FILE*> files(g_opt.devices);
+  uint32_t started = 0, running = 0;
+  while (started < g_opt.devices || running) {
+    if (started < g_opt.devices && running < g_opt.jobs) {
+      files[started] = tmpfile();
+      if (!files[started]) { perror("tmpfile"); return 1; }
+      fflush(stdout);
+      pid_t pid = fork();
+      if (pid == 0) {
+        runDevice((uint16_t)started, fileno(files[started]));
+        _exit(0);
+      }
+      if (pid < 0) { perror("fork"); return 1; }
+      started++;
+      running++;
+      continue;
+    }
+    int status;
+    if (wait(&status) > 0) running--;
+  }
+
+  double seconds = g_opt.minutes * 60.0;
+  size_t bins = (size_t)seconds;
+  Series byKind[KIND_COUNT];
+  Series total;
+  std::vector<uint32_t> requestsPerSecond(bins), requestsPer100ms(bins * 10);
+  std::vector<uint64_t> bytesPerSecond(bins);
+  for (auto& s : byKind) s.perSecond.assign(bins, 0);
+  total.perSecond.assign(bins, 0);
+  for (FILE* f : files) {
+    rewind(f);
+    Record r;
+    while (fread(&r, sizeof(r), 1, f) == 1) {
+      size_t sec = std::min(bins - 1, (size_t)(r.tUs / 1000000ULL));
+      for (Series* s : {&byKind[r.kind], &total}) {
+        s->count++;
+        s->failed += r.ok ? 0 : 1;
+        s->bytesUp += r.bytesUp;
+        s->bytesDown += r.bytesDown;
+        s->perSecond[sec]++;
+      }
+      requestsPerSecond[sec]++;
+      requestsPer100ms[std::min(bins * 10 - 1, (size_t)(r.tUs / 100000ULL))]++;
+      bytesPerSecond[sec] += r.bytesUp + r.bytesDown;
+    }
+    fclose(f);
+  }
+
+  printf("fleet: %u devices, %u min, boot spread %u s", g_opt.devices, g_opt.minutes, g_opt.bootSpreadS);
+  if (g_opt.outageLenS) printf(", backend+broker outage at %u s for %u s", g_opt.outageStartS, g_opt.outageLenS);
+  printf("\n\n%-15s %9s %7s %11s %11s %8s %7s\n", "kind", "count", "failed", "up KiB", "down KiB", "mean/s", "peak/s");
+  for (int k = 0; k < KIND_COUNT; k++) summarize(kKindNames[k], byKind[k], seconds);
+  summarize("total", total, seconds);
+  burstiness(requestsPerSecond, requestsPer100ms);
+  uint64_t peakBytes = *std::max_element(bytesPerSecond.begin(), bytesPerSecond.end());
+  printf("wire: mean %.1f KiB/s  peak %.1f KiB/s  (%.1f B/device/s)\n",
+         (total.bytesUp + total.bytesDown) / 1024.0 / seconds, peakBytes / 1024.0,
+         (total.bytesUp + total.bytesDown) / seconds / g_opt.devices);
+  return 0;
+}
@@ -0,0 +1,172 @@
+// latency/main.cpp
+// End-to-end latency harness: boots the whole firmware (setup() plus every
+// task) against the in-process MQTT broker and a stub HTTP backend, then
+// measures two paths on the virtual clock:
+//   mqtt->pump     message on devices/<id>/config until digitalWrite(RELAY_PUMP)
+//   sample->status sensor ADC sample until a /status POST carrying it reaches
+//                  the backend (matched through the payload's uptimeMs)
+//
+// Usage: program [--minutes N] [--http-delay MS] [--http-jitter MS]
+//                [--http-error PCT] [--mqtt-interval MS] [--seed N] [-v]
+#include "config.h"
+#include "hal_sim.h"
+#include "../arduino_main.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct Options {
+  uint32_t minutes = 60;
+  uint32_t httpDelayMs = 150;
+  uint32_t httpJitterMs = 100;
+  uint32_t httpErrorPct = 0;
+  uint32_t mqttIntervalMs = 5000;
+  uint32_t seed = 1;
+  bool verbose = false;
+};
+
+Options g_opt;
+std::mt19937 g_rng;
+
+uint32_t uniform(uint32_t lo, uint32_t hi) {
+  return lo >= hi ? lo : std::uniform_int_distribution<uint32_t>(lo, hi)(g_rng);
+}
+
+// ---- mqtt -> pump ----
+bool g_cmdPending = false;
+bool g_cmdLevel = false;
+uint64_t g_cmdSentUs = 0;
+unsigned g_cmdLost = 0;
+std::vector<double> g_mqttLatMs;
+
+void onGpioWrite(uint8_t pin, uint8_t level) {
+  if (pin != RELAY_PUMP || !g_cmdPending || (bool)level != g_cmdLevel) return;
+  g_mqttLatMs.push_back((hal_nowUs() - g_cmdSentUs) / 1000.0);
+  g_cmdPending = false;
+}
+
+// ---- sample -> status ----
+struct Sample {
+  uint64_t startUs;
+  uint64_t endUs;
+};
+std::vector<Sample> g_samples;
+size_t g_firstUndelivered = 0;
+std::vector<double> g_sampleLatMs;
+unsigned g_postsOk = 0;
+unsigned g_postsFailed = 0;
+
+int onAnalogRead(uint8_t pin) {
+  uint64_t now = hal_nowUs();
+  if (pin == SOIL1_PIN) {
+    // an AdcTask burst reads the channels back to back; a gap starts a new batch
+    if (g_samples.empty() || now - g_samples.back().endUs > 100000ULL) g_samples.push_back({now, now});
+    else g_samples.back().endUs = now;
+  }
+  switch (pin) {
+    case SOIL1_PIN:
+    case SOIL2_PIN: return 2400;
+    case LDR_PIN: return 1500;
+    case PH_PIN: return 1900;
+  }
+  return 0;
+}
+
+void recordDelivery(const HalHttpRequest& req) {
+  std::string body(req.body ? (const char*)req.body : "", req.len);
+  size_t at = body.find("\"uptimeMs\":");
+  if (at == std::string::npos) return;
+  uint64_t builtMs = strtoull(body.c_str() + at + 11, nullptr, 10);
+  while (g_firstUndelivered < g_samples.size() && g_samples[g_firstUndelivered].endUs / 1000ULL <= builtMs) {
+    g_sampleLatMs.push_back((hal_nowUs() - g_samples[g_firstUndelivered].startUs) / 1000.0);
+    g_firstUndelivered++;
+  }
+}
+
+HalHttpResponse backend(const HalHttpRequest& req) {
+  HalHttpResponse resp;
+  resp.code = 200;
+  resp.body = "{\"ok\":true}";
+  resp.delayMs = 0;
+  if (!strstr(req.url, "/status")) return resp;
+  resp.delayMs = g_opt.httpDelayMs + uniform(0, g_opt.httpJitterMs);
+  if (uniform(0, 99) < g_opt.httpErrorPct) {
+    // half server errors, half transport failures
+    resp.code = uniform(0, 1) ? 503 : -1;
+    resp.body.clear();
+    g_postsFailed++;
+    return resp;
+  }
+  g_postsOk++;
+  recordDelivery(req);
+  return resp;
+}
+
+double percentile(std::vector<double> v, double p) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  size_t idx = (size_t)(p / 100.0 * (v.size() - 1) + 0.5);
+  return v[std::min(idx, v.size() - 1)];
+}
+
+void report(const char* name, const std::vector<double>& v, unsigned lost) {
+  double mx = v.empty() ? 0 : *std::max_element(v.begin(), v.end());
+  printf("%-16s %6zu %9.1f %9.1f %9.1f %9.1f %6u\n", name, v.size(), percentile(v, 50), percentile(v, 90),
+         percentile(v, 99), mx, lost);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    auto next = [&]() { return i + 1 < argc ? (uint32_t)strtoul(argv[++i], nullptr, 10) : 0u; };
+    if (strcmp(argv[i], "--minutes") == 0) g_opt.minutes = next();
+    else if (strcmp(argv[i], "--http-delay") == 0) g_opt.httpDelayMs = next();
+    else if (strcmp(argv[i], "--http-jitter") == 0) g_opt.httpJitterMs = next();
+    else if (strcmp(argv[i], "--http-error") == 0) g_opt.httpErrorPct = next();
+    else if (strcmp(argv[i], "--mqtt-interval") == 0) g_opt.mqttIntervalMs = next();
+    else if (strcmp(argv[i], "--seed") == 0) g_opt.seed = next();
+    else if (strcmp(argv[i], "-v") == 0) g_opt.verbose = true;
+  }
+  if (!g_opt.minutes) g_opt.minutes = 60;
+  if (!g_opt.mqttIntervalMs) g_opt.mqttIntervalMs = 5000;
+  g_rng.seed(g_opt.seed);
+
+  hal_setSerialEcho(g_opt.verbose);
+  hal_setWiFiConnected(true);
+  hal_setHttpHandler(backend);
+  hal_setGpioWriteHook(onGpioWrite);
+  hal_setAnalogSource(onAnalogRead);
+  hal_setDht(26.0f, 60.0f);
+
+  startLoopTask();
+  // let setup() finish and the tasks settle before measuring
+  hal_runFor(15000);
+  g_mqttLatMs.clear();
+  g_sampleLatMs.clear();
+  g_firstUndelivered = g_samples.size();
+
+  char topic[64];
+  snprintf(topic, sizeof(topic), "devices/%s/config", settings.deviceID);
+  uint64_t endUs = hal_nowUs() + (uint64_t)g_opt.minutes * 60000000ULL;
+  while (hal_nowUs() < endUs) {
+    // inject at an arbitrary phase relative to the firmware's task loops
+    hal_runFor(uniform(g_opt.mqttIntervalMs / 2, g_opt.mqttIntervalMs * 3 / 2));
+    if (g_cmdPending) g_cmdLost++;
+    g_cmdLevel = !g_cmdLevel;
+    g_cmdPending = true;
+    g_cmdSentUs = hal_nowUs();
+    hal_mqttInject(topic, g_cmdLevel ? "{\"pumpAuto\":false,\"pump\":true}" : "{\"pumpAuto\":false,\"pump\":false}");
+  }
+  hal_runFor(5000);
+  if (g_cmdPending) g_cmdLost++;
+
+  printf("simulated %u min, http delay %u+%u ms, http errors %u%%, posts ok=%u failed=%u\n", g_opt.minutes,
+         g_opt.httpDelayMs, g_opt.httpJitterMs, g_opt.httpErrorPct, g_postsOk, g_postsFailed);
+  printf("%-16s %6s %9s %9s %9s %9s %6s\n", "path", "n", "p50 ms", "p90 ms", "p99 ms", "max ms", "lost");
+  report("mqtt->pump", g_mqttLatMs, g_cmdLost);
+  report("sample->status", g_sampleLatMs, (unsigned)(g_samples.size() - g_firstUndelivered));
+  return 0;
+}
@@ -0,0 +1,132 @@
+// week_sim/main.cpp
+// Runs the real SensorTask and ControlTask (samples -> rules -> schedules)
+// against a simple greenhouse model for a simulated week and prints relay
+// activity per day. Usage: program [days] [-v]
+#include "config.h"
+#include "sensors.h"
+#include "relay_control.h"
+#include "eeprom_utils.h"
+#include "hal_sim.h"
+#include <chrono>
+
+namespace {
+
+// Greenhouse model: soil dries continuously and the pump wets it, light and
+// temperature follow the time of day.
+struct Greenhouse {
+  float soil = 55.0f;       // % moisture
+  unsigned long lastUs = 0;
+
+  void step(uint64_t nowUs) {
+    float dt = (nowUs - lastUs) / 1e6f;
+    lastUs = nowUs;
+    soil -= dt * (0.8f / 3600.0f);                    // ~0.8 %/h evaporation
+    if (hal_digitalOutput(RELAY_PUMP)) soil += dt * 0.5f;  // 0.5 %/s while pumping
+    soil = constrain(soil, 0.0f, 100.0f);
+  }
+  float dayFraction() const {
+    return (float)(timeClient.getEpochTime() % 86400UL) / 86400.0f;
+  }
+  // 0..100 % brightness, dark between 18:00 and 06:00
+  float brightness() const {
+    float s = sinf((dayFraction() - 0.25f) * 2.0f * (float)M_PI);
+    return s > 0 ? s * 100.0f : 0.0f;
+  }
+  float temperature() const { return 26.0f + 6.0f * sinf((dayFraction() - 0.375f) * 2.0f * (float)M_PI); }
+};
+
+Greenhouse g_house;
+
+// Inverse of the mappings in readSensors()
+int soilToRaw(float pct) { return (int)(3800 - pct * 28.0f); }
+int lightToRaw(float pct) { return (int)(4095 * (1.0f - pct / 100.0f)); }
+int phToRaw(float ph) { return (int)((2.5f - (ph - 7.0f) * 0.18f) / 3.3f * 4095.0f); }
+
+struct RelayStats {
+  unsigned on = 0;
+  uint64_t onUs = 0;
+  uint64_t sinceUs = 0;
+  bool level = false;
+};
+RelayStats g_relay[3];
+
+int relayIndex(uint8_t pin) {
+  if (pin == RELAY_PUMP) return 0;
+  if (pin == RELAY_FAN) return 1;
+  if (pin == RELAY_LIGHT) return 2;
+  return -1;
+}
+
+void onGpioWrite(uint8_t pin, uint8_t level) {
+  int i = relayIndex(pin);
+  if (i < 0 || (bool)level == g_relay[i].level) return;
+  uint64_t now = hal_nowUs();
+  if (level) {
+    g_relay[i].on++;
+    g_relay[i].sinceUs = now;
+  } else {
+    g_relay[i].onUs += now - g_relay[i].sinceUs;
+  }
+  g_relay[i].level = level;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int days = 7;
+  bool verbose = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-v") == 0) verbose = true;
+    else days = atoi(argv[i]);
+  }
+  if (days <= 0) days = 7;
+
+  hal_setSerialEcho(verbose);
+  // keep the pH alert path off the network; this sim is about local control
+  hal_setWiFiConnected(false);
+  // clock zero is local midnight (NTPClient adds the +7h offset)
+  hal_setEpochBase(1700000000UL - (1700000000UL % 86400UL) - 7 * 3600UL);
+  hal_setGpioWriteHook(onGpioWrite);
+  hal_setAnalogSource([](uint8_t pin) -> int {
+    g_house.step(hal_nowUs());
+    switch (pin) {
+      case SOIL1_PIN: return soilToRaw(g_house.soil);
+      case SOIL2_PIN: return soilToRaw(g_house.soil - 2.0f);
+      case LDR_PIN: return lightToRaw(g_house.brightness());
+      case PH_PIN: return phToRaw(6.5f);
+    }
+    return 0;
+  });
+
+  // the firmware treats millis() == 0 as "never", so boot a little after zero
+  hal_advanceMs(2000);
+  initEEPROM();
+  loadSettings();
+  initRelays();
+  initSensors();
+  ntpSynced = true;
+  startControlTask();
+  startSensorTask();
+
+  printf("day  pump(n/s)   fan(n/s)    light(n/s)  soil%%\n");
+  auto wallStart = std::chrono::steady_clock::now();
+  for (int d = 1; d <= days; d++) {
+    RelayStats before[3];
+    for (int i = 0; i < 3; i++) before[i] = g_relay[i];
+    hal_setDht(g_house.temperature(), 60.0f);
+    // refresh the DHT reading every simulated minute
+    for (int m = 0; m < 24 * 60; m++) {
+      hal_runFor(60000);
+      hal_setDht(g_house.temperature(), 60.0f);
+    }
+    printf("%3d", d);
+    for (int i = 0; i < 3; i++) {
+      uint64_t onUs = g_relay[i].onUs - before[i].onUs;
+      printf("  %4u/%-6llu", g_relay[i].on - before[i].on, (unsigned long long)(onUs / 1000000ULL));
+    }
+    printf("  %5.1f\n", g_house.soil);
+  }
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  printf("simulated %d day(s) in %.2f s wall time, eeprom writes=%lu\n", days, wall, eepromWriteCount);
+  return 0;
+}
@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+"""Compare two bench JSON files (native/bench --json) and flag regressions.
+
+usage: bench_compare.py BASELINE CURRENT [--threshold PCT]
+
+Exits 1 when any benchmark is slower than the baseline by more than the
+threshold (default 15%) or allocates more per op.
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        return {r['name']: r for r in json.load(f)['results']}
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Compare native bench results against a baseline')
+    ap.add_argument('baseline')
+    ap.add_argument('current')
+    ap.add_argument('--threshold', type=float, default=15.0, help='allowed ns/op slowdown in percent')
+    args = ap.parse_args()
+    threshold = args.threshold
+    base, cur = load(args.baseline), load(args.current)
+    failed = False
+    print('%-28s %12s %12s %8s %10s %10s' % ('benchmark', 'base ns/op', 'ns/op', 'delta', 'allocs/op', 'bytes/op'))
+    for name, r in cur.items():
+        b = base.get(name)
+        if not b:
+            print('%-28s %12s %12.1f %8s %10.2f %10.1f  (new)' % (name, '-', r['ns_per_op'], '-', r['allocs_per_op'], r['bytes_per_op']))
+            continue
+        delta = (r['ns_per_op'] - b['ns_per_op']) * 100.0 / b['ns_per_op'] if b['ns_per_op'] else 0.0
+        flags = []
+        if delta > threshold:
+            flags.append('SLOWER')
+        if r['allocs_per_op'] > b['allocs_per_op'] or r['bytes_per_op'] > b['bytes_per_op']:
+            flags.append('MORE ALLOC')
+        failed = failed or bool(flags)
+        print('%-28s %12.1f %12.1f %+7.1f%% %10.2f %10.1f  %s' % (
+            name, b['ns_per_op'], r['ns_per_op'], delta, r['allocs_per_op'], r['bytes_per_op'], ' '.join(flags)))
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
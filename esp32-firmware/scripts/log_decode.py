@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""Decode the firmware's deferred-log frames back into text.
+
+Serial output mixes plain text (boot messages, direct prints) with binary
+frames written by LogTask:
+
+    0x1E, len, payload[len], xor(payload)
+    payload = format id (u16 LE), millis (u32 LE), arguments
+
+Arguments follow the format string from src/log_formats.h: 4-byte integer
+for %d/%i/%u/%x/%X/%c, 4-byte float for %f/%e/%g, length byte + bytes for %s.
+Text passes through unchanged, so the output reads like the old serial log.
+
+Usage:
+    log_decode.py [FILE|-]                 decode a capture (default stdin)
+    log_decode.py --port /dev/ttyUSB0      live from the serial port (pyserial)
+    log_decode.py --udp 5514               live from the UDP sink (logUdpHost)
+Options: -t prefixes decoded lines with the device uptime,
+         --formats PATH points at another log_formats.h.
+"""
+import argparse
+import os
+import re
+import socket
+import struct
+import sys
+
+SYNC = 0x1E
+DEFAULT_FORMATS = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'src', 'log_formats.h')
+ENTRY_RE = re.compile(r'X\(\s*(\w+)\s*,\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+SPEC_RE = re.compile(r'%([-+ #0]*)(\d+)?(?:\.(\d+))?(?:hh|h|ll|l|z|j|t|L)?([diouxXcsfFeEgGp%])')
+
+
+def load_formats(path):
+    with open(path) as f:
+        text = f.read()
+    formats = []
+    for name, _level, fmt in ENTRY_RE.findall(text):
+        fmt = bytes(fmt, 'utf-8').decode('unicode_escape')
+        formats.append((name, fmt))
+    if not formats:
+        sys.exit('no X(id, level, "format") entries in %s' % path)
+    return formats
+
+
+def render(fmt, args):
+    """Format one record; returns None if the arguments do not match."""
+    out = []
+    pos = 0
+    for m in SPEC_RE.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, conv = m.groups()
+        if conv == '%':
+            out.append('%')
+            continue
+        spec = '%' + (flags or '') + (width or '') + ('.' + prec if prec is not None else '')
+        if conv == 's':
+            if not args:
+                return None
+            n = args[0]
+            s = args[1:1 + n].decode('utf-8', 'replace')
+            if len(s) < n:
+                return None
+            args = args[1 + n:]
+            out.append((spec + 's') % s)
+            continue
+        if len(args) < 4:
+            return None
+        raw, args = args[:4], args[4:]
+        if conv in 'fFeEgG':
+            out.append((spec + conv) % struct.unpack('<f', raw)[0])
+        elif conv in 'di':
+            out.append((spec + 'd') % struct.unpack('<i', raw)[0])
+        elif conv == 'c':
+            out.append(chr(struct.unpack('<I', raw)[0] & 0xFF))
+        elif conv == 'p':
+            out.append('0x%08x' % struct.unpack('<I', raw)[0])
+        else:
+            out.append((spec + ('d' if conv == 'u' else conv)) % struct.unpack('<I', raw)[0])
+    out.append(fmt[pos:])
+    return ''.join(out)
+
+
+class Decoder:
+    def __init__(self, formats, timestamps, write):
+        self.formats = formats
+        self.timestamps = timestamps
+        self.write = write
+        self.buf = bytearray()
+
+    def frame_at(self, i):
+        """(line, size) for a valid frame at buf[i], (None, 0) if not a frame,
+        or (None, -1) if more bytes are needed to tell."""
+        b = self.buf
+        if i + 2 > len(b):
+            return None, -1
+        n = b[i + 1]
+        if n < 6:
+            return None, 0
+        if i + 3 + n > len(b):
+            return None, -1
+        payload = bytes(b[i + 2:i + 2 + n])
+        x = 0
+        for c in payload:
+            x ^= c
+        if x != b[i + 2 + n]:
+            return None, 0
+        fid, ms = struct.unpack('<HI', payload[:6])
+        if fid >= len(self.formats):
+            return None, 0
+        text = render(self.formats[fid][1], payload[6:])
+        if text is None:
+            return None, 0
+        if self.timestamps:
+            text = '%10.3f %s' % (ms / 1000.0, text)
+        return text + '\n', 3 + n
+
+    def feed(self, data, final=False):
+        self.buf += data
+        i = 0
+        text_start = 0
+        while i < len(self.buf):
+            if self.buf[i] != SYNC:
+                i += 1
+                continue
+            line, size = self.frame_at(i)
+            if size < 0 and not final:
+                break
+            if size <= 0:
+                i += 1
+                continue
+            self.flush_text(text_start, i)
+            self.write(line)
+            i += size
+            text_start = i
+        self.flush_text(text_start, i)
+        del self.buf[:i]
+
+    def flush_text(self, start, end):
+        if end > start:
+            self.write(self.buf[start:end].decode('utf-8', 'replace'))
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Decode deferred-log frames from the firmware.')
+    ap.add_argument('input', nargs='?', default='-', help='capture file, or - for stdin')
+    ap.add_argument('--port', help='read live from this serial port')
+    ap.add_argument('--baud', type=int, default=115200)
+    ap.add_argument('--udp', type=int, metavar='PORT', help='listen for the UDP log sink')
+    ap.add_argument('--formats', default=DEFAULT_FORMATS, help='path to log_formats.h')
+    ap.add_argument('-t', '--timestamps', action='store_true', help='prefix decoded lines with device uptime')
+    opt = ap.parse_args()
+
+    def write(s):
+        sys.stdout.write(s)
+        sys.stdout.flush()
+
+    dec = Decoder(load_formats(opt.formats), opt.timestamps, write)
+    try:
+        if opt.port:
+            import serial
+            s = serial.Serial(opt.port, opt.baud, timeout=0.1)
+            while True:
+                dec.feed(s.read(256))
+        elif opt.udp:
+            sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+            sock.bind(('', opt.udp))
+            while True:
+                dec.feed(sock.recv(2048), final=True)
+        else:
+            f = sys.stdin.buffer if opt.input == '-' else open(opt.input, 'rb')
+            while True:
+                data = f.read(4096)
+                if not data:
+                    break
+                dec.feed(data)
+            dec.feed(b'', final=True)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
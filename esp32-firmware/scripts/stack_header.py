@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""Turn the [STACK] lines of a soak-run capture into src/task_stacks_gen.h.
+
+Build with -DSTACK_SOAK_REPORT_MS=<ms> (e.g. `pio run -e esp32dev-stacksoak`)
+and the watchdog task logs, for every task:
+
+    [STACK] server size=12288 peak=3660 recommend=4864
+
+Later lines win, so feed the whole capture (decoded text, or the raw serial
+log; frames are decoded with log_decode.py).
+
+Usage:
+    stack_header.py [FILE|-] [-o src/task_stacks_gen.h]
+"""
+import argparse
+import io
+import os
+import re
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import log_decode  # noqa: E402
+
+LINE_RE = re.compile(r'\[STACK\] (\w+) size=(\d+) peak=(\d+) recommend=(\d+)')
+ORDER = ['server', 'sensor', 'lcd', 'button', 'eeprom', 'watchdog', 'log', 'adc', 'control']
+
+
+def decode(data):
+    out = io.StringIO()
+    dec = log_decode.Decoder(log_decode.load_formats(log_decode.DEFAULT_FORMATS), False, out.write)
+    dec.feed(data, final=True)
+    return out.getvalue()
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Generate task_stacks_gen.h from [STACK] log lines.')
+    ap.add_argument('input', nargs='?', default='-', help='capture file, or - for stdin')
+    ap.add_argument('-o', '--output', help='write here instead of stdout')
+    opt = ap.parse_args()
+
+    data = sys.stdin.buffer.read() if opt.input == '-' else open(opt.input, 'rb').read()
+    tasks = {}
+    for m in LINE_RE.finditer(decode(data)):
+        tasks[m.group(1)] = tuple(int(v) for v in m.group(2, 3, 4))
+    if not tasks:
+        sys.exit('no [STACK] lines found (was the firmware built with -DSTACK_SOAK_REPORT_MS?)')
+
+    lines = ['// task_stacks_gen.h - generated by scripts/stack_header.py from %s' % opt.input,
+             '// Code paths that did not run during the soak (OTA, captive portal, ...) are not covered.']
+    for name in sorted(tasks, key=lambda n: ORDER.index(n) if n in ORDER else len(ORDER)):
+        size, peak, rec = tasks[name]
+        macro = 'STACK_%s_TASK' % name.upper()
+        lines += ['#ifndef %s' % macro, '#define %s %d  // peak %d of %d' % (macro, rec, peak, size), '#endif']
+    text = '\n'.join(lines) + '\n'
+    if opt.output:
+        with open(opt.output, 'w') as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,29 @@
+// adc_calibration.cpp
+#include "adc_calibration.h"
+#include <esp_adc_cal.h>
+
+uint16_t adcCalTable[ADC_CAL_ENTRIES];
+static const char* calSource = "none";
+
+void initAdcCalibration() {
+  esp_adc_cal_characteristics_t chars;
+  esp_adc_cal_value_t src =
+      esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, ADC_DEFAULT_VREF_MV, &chars);
+  calSource = src == ESP_ADC_CAL_VAL_EFUSE_TP ? "eFuse two-point"
+            : src == ESP_ADC_CAL_VAL_EFUSE_VREF ? "eFuse Vref" : "default Vref";
+  for (uint16_t i = 0; i < ADC_CAL_ENTRIES; i++) {
+    uint32_t counts = (uint32_t)i << ADC_CAL_SHIFT;
+    // the last entry stands for 4096: extend the top segment to it
+    if (counts > 4095) {
+      uint32_t top = esp_adc_cal_raw_to_voltage(4095, &chars);
+      uint32_t step = (1 << ADC_CAL_SHIFT) - 1;
+      adcCalTable[i] = adcCalTable[i - 1] + ((top - adcCalTable[i - 1]) * (step + 1) + step / 2) / step;
+      break;
+    }
+    adcCalTable[i] = esp_adc_cal_raw_to_voltage(counts, &chars);
+  }
+  Serial.printf("[ADC] calibration: %s, 0 -> %u mV, 4095 -> %u mV\n", calSource, adcCountsToMv(0),
+                adcCountsToMv(4095));
+}
+
+const char* adcCalibrationSource() { return calSource; }
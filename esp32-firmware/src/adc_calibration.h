@@ -0,0 +1,30 @@
+// adc_calibration.h
+#ifndef ADC_CALIBRATION_H
+#define ADC_CALIBRATION_H
+
+#include "config.h"
+
+// ADC1 counts -> millivolts (11 dB, 12 bit) from this chip's eFuse
+// characterisation. The curve is sampled into a table once at boot; after
+// that a conversion is an integer lookup plus interpolation.
+#ifndef ADC_DEFAULT_VREF_MV
+#define ADC_DEFAULT_VREF_MV 1100  // used when the eFuse holds no calibration
+#endif
+#define ADC_CAL_SHIFT 4           // one table entry every 16 counts
+#define ADC_CAL_ENTRIES ((4096 >> ADC_CAL_SHIFT) + 1)
+
+extern uint16_t adcCalTable[ADC_CAL_ENTRIES];
+
+// Build adcCalTable (initSensors, before any reading)
+void initAdcCalibration();
+// "eFuse two-point", "eFuse Vref" or "default Vref"
+const char* adcCalibrationSource();
+
+inline uint16_t adcCountsToMv(uint16_t counts) {
+  if (counts > 4095) counts = 4095;
+  uint16_t i = counts >> ADC_CAL_SHIFT;
+  uint16_t f = counts & ((1 << ADC_CAL_SHIFT) - 1);
+  return adcCalTable[i] + (((adcCalTable[i + 1] - adcCalTable[i]) * f + (1 << (ADC_CAL_SHIFT - 1))) >> ADC_CAL_SHIFT);
+}
+
+#endif
@@ -0,0 +1,185 @@
+// adc_sampler.cpp
+#include "config.h"
+#include "adc_sampler.h"
+#include "sensor_registry.h"
+#include "deferred_log.h"
+#include "stack_monitor.h"
+#include <driver/adc.h>
+
+// DMA frame: one EOF interrupt's worth of conversions
+#define ADC_FRAME_BYTES 256
+
+static int8_t chanInput[8];  // ADC1 channel -> AdcInput, -1 when not scanned
+static uint8_t frame[ADC_FRAME_BYTES];
+
+static AdcReading latest;
+static bool haveLatest = false;
+static bool running = false;
+static uint16_t depth = ADC_DEPTH_MIN;
+static SemaphoreHandle_t burstDone = NULL;     // given after every burst
+static SemaphoreHandle_t burstRequest = NULL;  // starts one ahead of the period
+static portMUX_TYPE adcMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Pick the depth for the next burst from the noisiest channel of this one
+static void adaptDepth(float maxSd) {
+  if (ADC_TARGET_SE <= 0) return;
+  // standard error sd/sqrt(n) <= target  =>  n >= (sd/target)^2
+  float need = (maxSd / ADC_TARGET_SE) * (maxSd / ADC_TARGET_SE);
+  uint16_t want = ADC_DEPTH_MIN;
+  while (want < ADC_DEPTH_MAX && want < need) want <<= 1;
+  uint16_t next = depth;
+  if (want > depth) next = want;
+  else if (need * 2 < depth && depth > ADC_DEPTH_MIN) next = depth / 2;  // settle one step at a time
+  if (next != depth) {
+    DLOG(LF_ADC_DEPTH, depth, next, maxSd);
+    depth = next;
+  }
+}
+
+static void runBurst() {
+  uint32_t sum[ADC_IN_COUNT] = {0};
+  uint64_t sumSq[ADC_IN_COUNT] = {0};
+  uint16_t count[ADC_IN_COUNT] = {0};
+  uint32_t len = 0;
+
+  // drop whatever the ring still holds from the previous burst
+  while (adc_digi_read_bytes(frame, sizeof(frame), &len, 0) == ESP_OK && len) {
+  }
+  uint32_t startMs = millis();
+  adc_digi_start();
+  // the channels are scanned in turn, so a burst takes depth * channels / rate
+  uint32_t budgetMs = (uint32_t)depth * ADC_IN_COUNT * 1000UL / ADC_SCAN_HZ + 100;
+  uint32_t t0 = millis();
+  bool done = false;
+  while (!done && millis() - t0 < budgetMs) {
+    if (adc_digi_read_bytes(frame, sizeof(frame), &len, 20) != ESP_OK) continue;
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES) {
+      const adc_digi_output_data_t* p = (const adc_digi_output_data_t*)&frame[i];
+      uint8_t ch = p->type1.channel;
+      int8_t in = ch < 8 ? chanInput[ch] : -1;
+      if (in < 0 || count[in] >= depth) continue;
+      uint32_t v = p->type1.data;
+      sum[in] += v;
+      sumSq[in] += v * v;
+      count[in]++;
+    }
+    done = true;
+    for (uint8_t in = 0; in < ADC_IN_COUNT; in++) {
+      if (count[in] < depth) done = false;
+    }
+  }
+  adc_digi_stop();
+
+  if (!done) {
+    uint16_t least = depth;
+    for (uint8_t in = 0; in < ADC_IN_COUNT; in++) {
+      if (count[in] < least) least = count[in];
+    }
+    DLOG(LF_ADC_SHORT, least, depth);
+    if (!least) return;
+  }
+
+  AdcReading r;
+  float maxSd = 0;
+  for (uint8_t in = 0; in < ADC_IN_COUNT; in++) {
+    float mean = (float)sum[in] / count[in];
+    float var = (float)((double)sumSq[in] / count[in] - (double)mean * mean);
+    r.mean[in] = mean;
+    r.sd[in] = var > 0 ? sqrtf(var) : 0;
+    if (r.sd[in] > maxSd) maxSd = r.sd[in];
+  }
+  r.depth = depth;
+  r.startMs = startMs;
+  r.atMs = millis();
+
+  portENTER_CRITICAL(&adcMux);
+  latest = r;
+  haveLatest = true;
+  portEXIT_CRITICAL(&adcMux);
+  xSemaphoreGive(burstDone);
+  adaptDepth(maxSd);
+}
+
+static void adcTask(void* pv) {
+  stackTrackSelf(STK_ADC);
+  TickType_t lastWake = xTaskGetTickCount();
+  while (1) {
+    runBurst();
+    // sleep out the period unless adcSamplerFresh() wants a burst now; an
+    // extra burst leaves the periodic schedule where it was
+    TickType_t next = lastWake + pdMS_TO_TICKS(ADC_BURST_PERIOD_MS);
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(next - now) > 0 && xSemaphoreTake(burstRequest, next - now) == pdTRUE) continue;
+    lastWake = next;
+  }
+}
+
+bool initAdcSampler() {
+  adc_digi_pattern_config_t pattern[ADC_IN_COUNT];
+  uint32_t mask = 0;
+  memset(chanInput, -1, sizeof(chanInput));
+  for (uint8_t in = 0; in < ADC_IN_COUNT; in++) {
+    // continuous mode only drives ADC1 (GPIO 32-39)
+    int8_t ch = digitalPinToAnalogChannel(sensorForAnalog(in)->pin);
+    if (ch < 0 || ch > 7) return false;
+    chanInput[ch] = in;
+    mask |= 1UL << ch;
+    pattern[in].atten = ADC_ATTEN_DB_11;
+    pattern[in].channel = ch;
+    pattern[in].unit = 0;
+    pattern[in].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+  }
+
+  adc_digi_init_config_t initCfg = {};
+  initCfg.max_store_buf_size = 16 * ADC_FRAME_BYTES;  // ~100 ms of conversions
+  initCfg.conv_num_each_intr = ADC_FRAME_BYTES;
+  initCfg.adc1_chan_mask = mask;
+  if (adc_digi_initialize(&initCfg) != ESP_OK) return false;
+
+  adc_digi_configuration_t cfg = {};
+  cfg.conv_limit_en = true;  // required on the ESP32
+  cfg.conv_limit_num = 250;
+  cfg.pattern_num = ADC_IN_COUNT;
+  cfg.adc_pattern = pattern;
+  cfg.sample_freq_hz = ADC_SCAN_HZ;
+  cfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  cfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+  if (adc_digi_controller_configure(&cfg) != ESP_OK) {
+    adc_digi_deinitialize();
+    return false;
+  }
+
+  burstDone = xSemaphoreCreateBinary();
+  burstRequest = xSemaphoreCreateBinary();
+  running = true;
+  xTaskCreatePinnedToCore(adcTask, "AdcTask", STACK_ADC_TASK, NULL, 2, NULL, 1);
+  return true;
+}
+
+bool adcSamplerRunning() { return running; }
+
+bool adcSamplerLatest(AdcReading* out, uint32_t waitMs) {
+  if (!running) return false;
+  if (!haveLatest && waitMs) xSemaphoreTake(burstDone, pdMS_TO_TICKS(waitMs));
+  portENTER_CRITICAL(&adcMux);
+  bool ok = haveLatest;
+  if (ok) *out = latest;
+  portEXIT_CRITICAL(&adcMux);
+  return ok;
+}
+
+bool adcSamplerFresh(AdcReading* out, unsigned long sinceMs, uint32_t waitMs) {
+  if (!running) return false;
+  xSemaphoreGive(burstRequest);
+  uint32_t t0 = millis();
+  while (1) {
+    portENTER_CRITICAL(&adcMux);
+    bool ok = haveLatest && (int32_t)(latest.startMs - sinceMs) >= 0;
+    if (ok) *out = latest;
+    portEXIT_CRITICAL(&adcMux);
+    if (ok) return true;
+    uint32_t spent = millis() - t0;
+    if (spent >= waitMs) return false;
+    xSemaphoreTake(burstDone, pdMS_TO_TICKS(waitMs - spent));
+  }
+}
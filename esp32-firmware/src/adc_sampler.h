@@ -0,0 +1,55 @@
+// adc_sampler.h
+#ifndef ADC_SAMPLER_H
+#define ADC_SAMPLER_H
+
+#include "config.h"
+
+// Continuous (DMA) sampling of the analog sensor inputs. AdcTask runs a burst
+// of conversions cycling through soil, light and pH every ADC_BURST_PERIOD_MS,
+// averages `depth` conversions per channel and publishes the result, so
+// readSensors() no longer busy-waits on analogRead().
+#ifndef ADC_SCAN_HZ
+#define ADC_SCAN_HZ 20000  // conversions/s over all channels; the ESP32 minimum
+#endif
+#ifndef ADC_BURST_PERIOD_MS
+#define ADC_BURST_PERIOD_MS 1000
+#endif
+#ifndef ADC_DEPTH_MIN
+#define ADC_DEPTH_MIN 64
+#endif
+#ifndef ADC_DEPTH_MAX
+#define ADC_DEPTH_MAX 1024
+#endif
+// The depth doubles when the noise would leave a standard error of the mean
+// above this many counts and halves again when it settles; 0 keeps it fixed
+// at ADC_DEPTH_MIN.
+#ifndef ADC_TARGET_SE
+#define ADC_TARGET_SE 2
+#endif
+
+enum AdcInput {
+  ADC_IN_SOIL1,
+  ADC_IN_SOIL2,
+  ADC_IN_LIGHT,
+  ADC_IN_PH,
+  ADC_IN_COUNT
+};
+
+struct AdcReading {
+  float mean[ADC_IN_COUNT];  // raw counts, 0..4095
+  float sd[ADC_IN_COUNT];    // spread of the individual conversions
+  uint16_t depth;            // conversions averaged per channel
+  uint32_t startMs;          // first conversion
+  uint32_t atMs;             // last conversion
+};
+
+// Set up the DMA controller and start AdcTask; false leaves the pins to analogRead()
+bool initAdcSampler();
+bool adcSamplerRunning();
+// Latest burst; waits up to waitMs while there is none yet. false on timeout.
+bool adcSamplerLatest(AdcReading* out, uint32_t waitMs);
+// A burst started at or after sinceMs (millis()), asking AdcTask for one right
+// away instead of waiting out ADC_BURST_PERIOD_MS. false on timeout.
+bool adcSamplerFresh(AdcReading* out, unsigned long sinceMs, uint32_t waitMs);
+
+#endif
@@ -0,0 +1,356 @@
+// alerts.cpp
+#include "alerts.h"
+#include "sensor_registry.h"
+#include "relay_control.h"
+#include "mqtt_client.h"
+#include "metrics.h"
+#include <HTTPClient.h>
+#include <WiFi.h>
+
+#define ALERT_KEY_LEN 16
+#define ALERT_DELIVERY_ATTEMPTS 3
+#define ALERT_RETRY_MS 10000
+#define ALERT_HTTP_TIMEOUT_MS 3000
+// keys raised through alertRaise() and not cleared yet
+#define ALERT_ACTIVE_MAX 8
+
+static const char* const SEVERITY_KEYS[] = {"info", "warning", "critical"};
+
+struct AlertEvent {
+  char key[ALERT_KEY_LEN];
+  char text[48];
+  float value;
+  uint32_t atMs;     // first raised
+  uint16_t count;    // raises merged into this event
+  uint8_t severity;
+  bool cleared;
+  bool repeat;       // the key had been raised before
+  uint8_t tries;     // failed deliveries so far
+  uint32_t triedMs;  // millis() of the last one
+};
+
+// ring buffer; producers and serverTask meet under alertMux
+static AlertEvent queue[ALERT_QUEUE_LEN];
+static uint8_t qHead = 0;
+static uint8_t qCount = 0;
+static bool sending = false;  // queue[qHead] is out for delivery, not merged into
+static uint8_t tokens = ALERT_BURST;
+static unsigned long refilledAt = 0;
+static portMUX_TYPE alertMux = portMUX_INITIALIZER_UNLOCKED;
+
+static char activeKeys[ALERT_ACTIVE_MAX][ALERT_KEY_LEN];
+static uint8_t activeCount = 0;
+
+// settings.alerts is replaced whole under alertRulesMux (serverTask), and the
+// sensor task evaluates its own copy, taken under it once alertRulesChanged
+static portMUX_TYPE alertRulesMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool alertRulesChanged = true;
+
+// rule state, sensor task only
+static AlertRule rules[MAX_ALERT_RULES];
+static uint8_t numRules = 0;
+static bool ruleActive[MAX_ALERT_RULES];
+static char ruleKeys[MAX_ALERT_RULES][ALERT_KEY_LEN];  // key each active rule raised
+static unsigned long ruleSentAt[MAX_ALERT_RULES];
+
+static const AlertRule DEFAULT_ALERTS[] = {
+    // sensor     cmp         severity       limit band   repeat
+    {SENSOR_PH, RULE_BELOW, ALERT_WARNING, 0, NAN, 0.2f, 60, {0, 0}},
+    {SENSOR_PH, RULE_ABOVE, ALERT_WARNING, 0, NAN, 0.2f, 60, {0, 0}},
+};
+
+static void publishAlertRules(const AlertRule* src, uint8_t n) {
+  portENTER_CRITICAL(&alertRulesMux);
+  memcpy(settings.alerts, src, n * sizeof(AlertRule));
+  settings.numAlerts = n;
+  alertRulesChanged = true;
+  portEXIT_CRITICAL(&alertRulesMux);
+}
+
+void defaultAlertRules() {
+  publishAlertRules(DEFAULT_ALERTS, sizeof(DEFAULT_ALERTS) / sizeof(DEFAULT_ALERTS[0]));
+}
+
+void applyAlertConfig(JsonArrayConst arr) {
+  AlertRule parsed[MAX_ALERT_RULES];
+  uint8_t n = 0;
+  for (JsonObjectConst o : arr) {
+    if (n >= MAX_ALERT_RULES) break;
+    const char* key = o["sensor"].as<const char*>();
+    int sensor = -1;
+    for (uint8_t i = 0; key && i < SENSOR_COUNT; i++) {
+      if (strcmp(key, sensorChannels[i].key) == 0) sensor = i;
+    }
+    if (sensor < 0) {
+      Serial.printf("[ALERT] rule %u: unknown sensor, skipped\n", n);
+      continue;
+    }
+    AlertRule& r = parsed[n++];
+    memset(&r, 0, sizeof(r));
+    r.sensor = sensor;
+    const char* cmp = o["cmp"].as<const char*>();
+    r.cmp = cmp && strcmp(cmp, ">") == 0 ? RULE_ABOVE : RULE_BELOW;
+    r.severity = ALERT_WARNING;
+    const char* sev = o["severity"].as<const char*>();
+    for (uint8_t s = 0; sev && s < sizeof(SEVERITY_KEYS) / sizeof(SEVERITY_KEYS[0]); s++) {
+      if (strcmp(sev, SEVERITY_KEYS[s]) == 0) r.severity = s;
+    }
+    r.limit = o.containsKey("limit") && !o["limit"].isNull() ? o["limit"].as<float>() : NAN;
+    r.band = fabsf(o["band"].as<float>());
+    r.repeatSec = constrain(o["repeat"].as<long>(), 0L, 65535L);
+  }
+  publishAlertRules(parsed, n);
+  Serial.printf("[ALERT] %u rule(s)\n", n);
+}
+
+// strncpy that always terminates; used under alertMux
+static void copyText(char* dst, const char* src, size_t size) {
+  strncpy(dst, src, size - 1);
+  dst[size - 1] = '\0';
+}
+
+// Drop queue entry i (0 = head); caller holds alertMux
+static void removeAt(uint8_t i) {
+  for (; i + 1 < qCount; i++) {
+    queue[(qHead + i) % ALERT_QUEUE_LEN] = queue[(qHead + i + 1) % ALERT_QUEUE_LEN];
+  }
+  qCount--;
+}
+
+// Merge into a queued event with the same key, or append one. Returns false
+// when the event was rate limited or the queue had no room for it.
+static bool enqueue(const char* key, AlertSeverity severity, float value, const char* text, bool cleared,
+                    bool repeat) {
+  unsigned long now = millis();
+  bool ok = true;
+  portENTER_CRITICAL(&alertMux);
+  // an entry already being delivered is left alone
+  for (uint8_t i = sending ? 1 : 0; i < qCount; i++) {
+    AlertEvent& e = queue[(qHead + i) % ALERT_QUEUE_LEN];
+    if (strcmp(e.key, key) != 0 || e.cleared) continue;
+    if (cleared && !e.repeat) {
+      // raised and cleared before it went out: nothing to report
+      removeAt(i);
+    } else if (cleared) {
+      // the backend saw the raise; a pending repeat becomes the clear
+      e.value = value;
+      copyText(e.text, text, sizeof(e.text));
+      e.severity = ALERT_INFO;
+      e.cleared = true;
+    } else {
+      e.value = value;
+      copyText(e.text, text, sizeof(e.text));
+      if (severity > e.severity) e.severity = severity;
+      e.count++;
+    }
+    portEXIT_CRITICAL(&alertMux);
+    return true;
+  }
+  if (!cleared && severity < ALERT_CRITICAL) {
+    uint32_t refill = (now - refilledAt) / ALERT_REFILL_MS;
+    if (refill) {
+      tokens = tokens + refill < ALERT_BURST ? tokens + refill : ALERT_BURST;
+      refilledAt += refill * ALERT_REFILL_MS;
+    }
+    if (tokens) tokens--;
+    else ok = false;
+  }
+  bool evicted = false;
+  if (ok && qCount == ALERT_QUEUE_LEN) {
+    // make room by dropping the oldest event less severe than this one
+    ok = false;
+    for (uint8_t i = sending ? 1 : 0; i < qCount; i++) {
+      if (queue[(qHead + i) % ALERT_QUEUE_LEN].severity < severity) {
+        removeAt(i);
+        evicted = ok = true;
+        break;
+      }
+    }
+  }
+  if (ok) {
+    AlertEvent& e = queue[(qHead + qCount++) % ALERT_QUEUE_LEN];
+    copyText(e.key, key, sizeof(e.key));
+    copyText(e.text, text, sizeof(e.text));
+    e.value = value;
+    e.atMs = now;
+    e.count = 1;
+    e.severity = severity;
+    e.cleared = cleared;
+    e.repeat = repeat;
+    e.tries = 0;
+  }
+  portEXIT_CRITICAL(&alertMux);
+  if (evicted || !ok) metricsInc(metrics.alertsDropped);
+  if (!ok) Serial.printf("[ALERT] %s dropped (rate limit or queue full)\n", key);
+  return ok;
+}
+
+static bool isActive(const char* key) {
+  for (uint8_t i = 0; i < activeCount; i++) {
+    if (strcmp(activeKeys[i], key) == 0) return true;
+  }
+  return false;
+}
+
+void alertRaise(const char* key, AlertSeverity severity, float value, const char* text) {
+  portENTER_CRITICAL(&alertMux);
+  bool known = isActive(key);
+  portEXIT_CRITICAL(&alertMux);
+  // a raise that was rate limited or dropped never reached the backend, so
+  // it is not listed as active and no clear follows it
+  if (!enqueue(key, severity, value, text, false, known) || known) return;
+  portENTER_CRITICAL(&alertMux);
+  if (!isActive(key) && activeCount < ALERT_ACTIVE_MAX) copyText(activeKeys[activeCount++], key, ALERT_KEY_LEN);
+  portEXIT_CRITICAL(&alertMux);
+}
+
+void alertClear(const char* key, float value, const char* text) {
+  portENTER_CRITICAL(&alertMux);
+  bool known = false;
+  for (uint8_t i = 0; i < activeCount; i++) {
+    if (strcmp(activeKeys[i], key) != 0) continue;
+    memmove(activeKeys[i], activeKeys[i + 1], (activeCount - i - 1) * ALERT_KEY_LEN);
+    activeCount--;
+    known = true;
+    break;
+  }
+  portEXIT_CRITICAL(&alertMux);
+  if (known) enqueue(key, ALERT_INFO, value, text, true, false);
+}
+
+// "ph_low" / "ph_high"
+static void ruleKey(const AlertRule& r, char* out) {
+  snprintf(out, ALERT_KEY_LEN, "%s_%s", sensorChannels[r.sensor].key, r.cmp == RULE_ABOVE ? "high" : "low");
+}
+
+static float ruleLimit(const AlertRule& r) {
+  if (!isnan(r.limit)) return r.limit;
+  SensorKind kind = sensorChannels[r.sensor].kind;
+  return kind == KIND_PH && r.cmp == RULE_BELOW ? settings.phThreshMin : sensorThreshold(kind);
+}
+
+void alertsEvaluate(uint8_t sensorMask, unsigned long now) {
+  if (alertRulesChanged) {
+    portENTER_CRITICAL(&alertRulesMux);
+    numRules = settings.numAlerts < MAX_ALERT_RULES ? settings.numAlerts : MAX_ALERT_RULES;
+    memcpy(rules, settings.alerts, numRules * sizeof(AlertRule));
+    alertRulesChanged = false;
+    portEXIT_CRITICAL(&alertRulesMux);
+    // the new rules start from scratch; anything still wrong raises again
+    for (uint8_t i = 0; i < MAX_ALERT_RULES; i++) {
+      if (ruleActive[i]) alertClear(ruleKeys[i], NAN, "alert rule changed");
+      ruleActive[i] = false;
+    }
+  }
+  for (uint8_t i = 0; i < numRules; i++) {
+    const AlertRule& r = rules[i];
+    if (r.sensor >= SENSOR_COUNT || !(sensorMask & (1u << r.sensor))) continue;
+    float v = sensorValues[r.sensor];
+    if (isnan(v)) continue;
+    float limit = ruleLimit(r);
+    float sign = r.cmp == RULE_ABOVE ? 1.0f : -1.0f;
+    char text[48];
+    const char* label = sensorChannels[r.sensor].label;
+    if (!ruleActive[i]) {
+      if (sign * v <= sign * limit) continue;
+      ruleKey(r, ruleKeys[i]);
+    } else if (sign * v <= sign * limit - r.band) {
+      ruleActive[i] = false;
+      snprintf(text, sizeof(text), "%s back in range: %.2f", label, v);
+      alertClear(ruleKeys[i], v, text);
+      continue;
+    } else if (!r.repeatSec || now - ruleSentAt[i] < r.repeatSec * 1000UL) {
+      continue;
+    }
+    ruleActive[i] = true;
+    ruleSentAt[i] = now;
+    snprintf(text, sizeof(text), "%s %s %.2f: %.2f", label, r.cmp == RULE_ABOVE ? "above" : "below", limit, v);
+    uint8_t severity = r.severity < ALERT_CRITICAL ? r.severity : (uint8_t)ALERT_CRITICAL;
+    alertRaise(ruleKeys[i], (AlertSeverity)severity, v, text);
+  }
+}
+
+static size_t alertPayload(const AlertEvent& e, char* buf, size_t size) {
+  StaticJsonDocument<384> doc;
+  doc["id"] = (const char*)settings.deviceID;
+  doc["alert"] = (const char*)e.text;
+  doc["key"] = (const char*)e.key;
+  doc["severity"] = SEVERITY_KEYS[e.severity];
+  doc["state"] = e.cleared ? "cleared" : "raised";
+  if (!isnan(e.value)) doc["value"] = e.value;
+  doc["count"] = e.count;
+  doc["ageMs"] = (uint32_t)(millis() - e.atMs);
+  return serializeJson(doc, buf, size);
+}
+
+static bool postAlert(const char* payload, size_t len) {
+  HTTPClient http;
+  char url[128];
+  snprintf(url, sizeof(url), "http://%s:%d/alert", SERVER_IP, SERVER_PORT);
+  http.begin(url);
+  http.addHeader("Content-Type", "application/json");
+  http.addHeader("Connection", "close");
+  http.addHeader("X-Device-Token", settings.token);
+  http.setTimeout(ALERT_HTTP_TIMEOUT_MS);
+  uint32_t t0 = micros();
+  int code = http.POST((uint8_t*)payload, len);
+  metricsObserve(metrics.httpPost, micros() - t0);
+  metricsCountHttpResult(code);
+  if (code <= 0) Serial.printf("[ALERT] POST failed code=%d err=%s\n", code, http.errorToString(code).c_str());
+  http.end();
+  return code >= 200 && code < 300;
+}
+
+void alertsDeliver() {
+  if (WiFi.status() != WL_CONNECTED) return;
+  AlertEvent e;
+  portENTER_CRITICAL(&alertMux);
+  // the retry state travels with the event, so a head removed by a merge
+  // or an eviction does not pass its backoff to the next one
+  const AlertEvent& head = queue[qHead];
+  bool any = qCount > 0 && (!head.tries || millis() - head.triedMs >= ALERT_RETRY_MS);
+  if (any) {
+    e = queue[qHead];
+    sending = true;
+  }
+  portEXIT_CRITICAL(&alertMux);
+  if (!any) return;
+
+  char payload[320];
+  size_t len = alertPayload(e, payload, sizeof(payload));
+  // MQTT when the broker is up, the HTTP endpoint otherwise
+  bool ok = mqtt_publishAlert(payload, len) || postAlert(payload, len);
+  bool done = ok || e.tries + 1 >= ALERT_DELIVERY_ATTEMPTS;
+  portENTER_CRITICAL(&alertMux);
+  // the head stays put while sending is set
+  sending = false;
+  if (done) {
+    qHead = (qHead + 1) % ALERT_QUEUE_LEN;
+    qCount--;
+  } else {
+    queue[qHead].tries = e.tries + 1;
+    queue[qHead].triedMs = millis();
+  }
+  portEXIT_CRITICAL(&alertMux);
+  if (done && !ok) metricsInc(metrics.alertsDropped);
+  if (ok) {
+    metricsInc(metrics.alertsSent);
+    Serial.printf("[ALERT] sent %s (%s)\n", e.key, e.cleared ? "cleared" : SEVERITY_KEYS[e.severity]);
+  } else if (done) {
+    Serial.printf("[ALERT] %s dropped after %u attempts\n", e.key, ALERT_DELIVERY_ATTEMPTS);
+  }
+}
+
+void alertsToJson(JsonObject obj) {
+  JsonObject a = obj.createNestedObject("alerts");
+  JsonArray active = a.createNestedArray("active");
+  char keys[ALERT_ACTIVE_MAX][ALERT_KEY_LEN];
+  portENTER_CRITICAL(&alertMux);
+  uint8_t n = activeCount;
+  uint8_t queued = qCount;
+  memcpy(keys, activeKeys, sizeof(keys));
+  portEXIT_CRITICAL(&alertMux);
+  for (uint8_t i = 0; i < n; i++) active.add(keys[i]);
+  a["queued"] = queued;
+  a["dropped"] = metrics.alertsDropped;
+}
@@ -0,0 +1,49 @@
+// alerts.h
+#ifndef ALERTS_H
+#define ALERTS_H
+
+#include "config.h"
+
+// Alert engine. Producers (the sensor task after sampling, or any module
+// through alertRaise) only put events into a small bounded queue; serverTask
+// delivers them with alertsDeliver(), over MQTT (devices/<id>/alert) when
+// connected and HTTP POST /alert otherwise. A slow or absent backend only
+// delays the queue, never a sampling pass or a relay deadline.
+//
+// settings.alerts holds one rule per watched limit: a channel below/above a
+// limit raises an alert, which clears once the value is back past the limit
+// by `band`. While active it is sent again every repeatSec. An event still
+// queued under the same key is updated in place rather than queued twice, and
+// a clear cancels a raise that was never sent. Besides the per-rule repeat,
+// non-critical raises draw from a shared bucket of ALERT_BURST tokens that
+// refills one every ALERT_REFILL_MS.
+#ifndef ALERT_QUEUE_LEN
+#define ALERT_QUEUE_LEN 8
+#endif
+#define ALERT_BURST 5
+#define ALERT_REFILL_MS 60000UL
+
+enum AlertSeverity : uint8_t { ALERT_INFO, ALERT_WARNING, ALERT_CRITICAL };
+
+void defaultAlertRules();
+// Replace the rules from a remote "alerts" array:
+// [{"sensor": "ph", "cmp": "<", "limit": 5.5, "band": 0.2,
+//   "severity": "warning", "repeat": 60}, ...]
+// "limit" left out follows the threshold settings (pH: phThreshMin below,
+// phThreshMax above).
+void applyAlertConfig(JsonArrayConst arr);
+
+// Sensor task, after sampling: check the rules reading the sensors in
+// sensorMask (bit per SensorId). Queues events only, no I/O.
+void alertsEvaluate(uint8_t sensorMask, unsigned long nowMs);
+// Queue an alert from any module; key (up to 15 chars) identifies it for
+// dedupe and alertClear()
+void alertRaise(const char* key, AlertSeverity severity, float value, const char* text);
+void alertClear(const char* key, float value, const char* text);
+
+// serverTask: send the oldest queued event; dropped after 3 failed attempts
+void alertsDeliver();
+// Add "alerts": {"active": [keys], "queued": n, "dropped": n} (telemetry)
+void alertsToJson(JsonObject obj);
+
+#endif
@@ -0,0 +1,27 @@
+// boot_timeline.cpp
+#include "config.h"
+#include "boot_timeline.h"
+
+static const char* const phaseNames[BOOT_PHASE_COUNT] = {
+  "eeprom", "fs", "settings", "lcd", "io", "tasks", "control", "wifi", "mqtt", "telemetry"
+};
+
+// 0 = not reached; a phase reached at millis() == 0 is stored as 1
+static volatile uint32_t phaseMs[BOOT_PHASE_COUNT];
+static volatile bool delivered = false;
+
+void bootMark(BootPhase phase) {
+  if (phaseMs[phase]) return;
+  uint32_t now = millis();
+  phaseMs[phase] = now ? now : 1;
+}
+
+void bootTimelineToJson(JsonObject obj) {
+  if (delivered) return;
+  JsonObject boot = obj.createNestedObject("boot");
+  for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+    if (phaseMs[i]) boot[phaseNames[i]] = (uint32_t)phaseMs[i];
+  }
+}
+
+void bootTimelineDelivered() { delivered = true; }
@@ -0,0 +1,30 @@
+// boot_timeline.h
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include "config.h"
+
+// Boot phases in the order they normally complete. The network phases are
+// reached from serverTask after control and UI are already running.
+enum BootPhase {
+  BOOT_EEPROM,     // EEPROM emulation ready
+  BOOT_FS,         // LittleFS mounted (or given up)
+  BOOT_SETTINGS,   // settings loaded
+  BOOT_LCD,        // display initialised
+  BOOT_IO,         // buttons, relays, sensors configured
+  BOOT_TASKS,      // UI and sensor tasks created
+  BOOT_CONTROL,    // first sensor read and relay evaluation done
+  BOOT_WIFI,       // station joined
+  BOOT_MQTT,       // broker connected
+  BOOT_TELEMETRY,  // first status POST built
+  BOOT_PHASE_COUNT
+};
+
+// Record millis() for a phase; only the first call per phase counts
+void bootMark(BootPhase phase);
+// Add {"boot": {"eeprom": ms, ...}} until the timeline has been delivered
+void bootTimelineToJson(JsonObject obj);
+// The backend acknowledged a payload carrying the timeline
+void bootTimelineDelivered();
+
+#endif
@@ -0,0 +1,198 @@
+// burst_capture.cpp
+#include "burst_capture.h"
+#include "sensors.h"
+#include "sensor_power.h"
+#include "adc_sampler.h"
+#include "adc_calibration.h"
+#include "metrics.h"
+#include <HTTPClient.h>
+#include <WiFi.h>
+
+#define BURST_CHANNEL_MASK ((1u << FILTER_CHANNEL_COUNT) - 1)
+#define BURST_UPLOAD_ATTEMPTS 3
+#define BURST_RETRY_MS 10000
+
+enum BurstState : uint8_t { BURST_IDLE, BURST_CAPTURING, BURST_READY };
+
+// header and samples back to back, POSTed as they are
+static struct {
+  BurstHeader h;
+  uint16_t data[BURST_MAX_VALUES];
+} blob;
+
+static volatile uint8_t captureState = BURST_IDLE;
+static volatile bool triggerPending = false;
+static volatile uint8_t pendingTrigger;
+static uint8_t channelCount;
+static uint16_t nextFrame;
+// which side of its threshold each analog channel was last on
+static bool wasAbove[FILTER_CHANNEL_COUNT];
+static bool observed[FILTER_CHANNEL_COUNT];
+static uint8_t uploadAttempts;
+static unsigned long lastAttempt;
+
+void defaultBurstConfig() {
+  settings.burst.hz = 5;
+  settings.burst.onPump = 1;
+  settings.burst.seconds = 60;
+  settings.burst.channels = (1u << FILTER_SOIL1) | (1u << FILTER_SOIL2) | (1u << FILTER_PH);
+  settings.burst.onCross = 0;
+}
+
+// ["soil1", "ph"] -> bit per FilterChannel
+static uint8_t channelMask(JsonArrayConst keys) {
+  uint8_t mask = 0;
+  for (JsonVariantConst k : keys) {
+    const char* key = k.as<const char*>();
+    if (!key) continue;
+    for (uint8_t a = 0; a < FILTER_CHANNEL_COUNT; a++) {
+      if (strcmp(key, sensorForAnalog(a)->key) == 0) mask |= 1u << a;
+    }
+  }
+  return mask;
+}
+
+void applyBurstConfig(JsonObjectConst obj) {
+  BurstConfig& b = settings.burst;
+  if (obj.containsKey("hz")) b.hz = constrain(obj["hz"].as<int>(), 1, BURST_HZ_MAX);
+  if (obj.containsKey("seconds")) b.seconds = constrain(obj["seconds"].as<int>(), 1, BURST_SECONDS_MAX);
+  if (obj.containsKey("onPump")) b.onPump = obj["onPump"].as<bool>() ? 1 : 0;
+  if (obj.containsKey("channels")) {
+    uint8_t mask = channelMask(obj["channels"].as<JsonArrayConst>());
+    if (mask) b.channels = mask;
+  }
+  if (obj.containsKey("onCross")) b.onCross = channelMask(obj["onCross"].as<JsonArrayConst>());
+  Serial.printf("[BURST] %u Hz for %u s, channels 0x%02x, on pump %u, on crossing 0x%02x\n", b.hz, b.seconds,
+                b.channels, b.onPump, b.onCross);
+  if (obj["trigger"].as<bool>()) burstTrigger(BURST_TRIG_MANUAL);
+}
+
+void burstTrigger(uint8_t trigger) {
+  if (captureState != BURST_IDLE || triggerPending) {
+    Serial.printf("[BURST] trigger 0x%02x ignored, capture in progress\n", trigger);
+    return;
+  }
+  pendingTrigger = trigger;
+  triggerPending = true;
+  wakeSensorTask();
+}
+
+void burstObserve(uint8_t analog, float value) {
+  if (isnan(value)) return;
+  bool above = value > sensorThreshold(sensorForAnalog(analog)->kind);
+  bool crossed = observed[analog] && above != wasAbove[analog];
+  wasAbove[analog] = above;
+  observed[analog] = true;
+  if (crossed && (settings.burst.onCross & (1u << analog))) burstTrigger(BURST_TRIG_CROSS + analog);
+}
+
+static void startCapture(uint8_t trigger) {
+  uint8_t mask = settings.burst.channels & BURST_CHANNEL_MASK;
+  channelCount = 0;
+  for (uint8_t a = 0; a < FILTER_CHANNEL_COUNT; a++) {
+    if (mask & (1u << a)) channelCount++;
+  }
+  if (!channelCount) return;
+  uint8_t hz = constrain(settings.burst.hz, 1, BURST_HZ_MAX);
+  uint32_t frames = (uint32_t)hz * constrain(settings.burst.seconds, 1, BURST_SECONDS_MAX);
+  if (frames > BURST_MAX_VALUES / channelCount) frames = BURST_MAX_VALUES / channelCount;
+
+  // the supplies stay on for the whole capture instead of cycling per frame
+  uint8_t rails = sensorRailsFor(mask);
+  sensorPowerHold(rails);
+  unsigned long start = rails ? sensorPowerUp(rails) : millis();
+
+  memcpy(blob.h.magic, "BRST", 4);
+  blob.h.version = 1;
+  blob.h.trigger = trigger;
+  blob.h.channels = mask;
+  blob.h.hz = hz;
+  blob.h.startMs = start;
+  blob.h.periodMs = 1000 / hz;
+  blob.h.frames = frames;
+  nextFrame = 0;
+  captureState = BURST_CAPTURING;
+  Serial.printf("[BURST] trigger 0x%02x: %u frames of %u channels at %u Hz\n", trigger, (unsigned)frames,
+                channelCount, hz);
+}
+
+static void sampleFrame(uint16_t frame, unsigned long now) {
+  uint16_t* out = &blob.data[frame * channelCount];
+  uint8_t mask = blob.h.channels;
+  if (adcSamplerRunning()) {
+    // a burst started now, so the frame is not an older average
+    AdcReading adc;
+    bool ok = adcSamplerFresh(&adc, now, 200);
+    for (uint8_t a = 0; a < FILTER_CHANNEL_COUNT; a++) {
+      if (mask & (1u << a)) *out++ = ok ? adcCountsToMv((uint16_t)lroundf(adc.mean[a])) : BURST_MISSING;
+    }
+    return;
+  }
+  const int SAMPLES = 4;
+  for (uint8_t a = 0; a < FILTER_CHANNEL_COUNT; a++) {
+    if (!(mask & (1u << a))) continue;
+    uint32_t sum = 0;
+    for (int n = 0; n < SAMPLES; n++) sum += analogRead(sensorForAnalog(a)->pin);
+    *out++ = adcCountsToMv((sum + SAMPLES / 2) / SAMPLES);
+  }
+}
+
+static void finishCapture() {
+  sensorPowerHold(0);
+  sensorPowerDown();
+  uploadAttempts = 0;
+  captureState = BURST_READY;
+  Serial.printf("[BURST] captured %u frames\n", blob.h.frames);
+}
+
+uint32_t burstPoll(unsigned long now) {
+  if (triggerPending && captureState == BURST_IDLE) {
+    triggerPending = false;
+    startCapture(pendingTrigger);
+    now = millis();
+  }
+  while (captureState == BURST_CAPTURING) {
+    uint32_t period = blob.h.periodMs;
+    uint32_t due = blob.h.startMs + (uint32_t)nextFrame * period;
+    if ((long)(now - due) < 0) return due - now;
+    // frames whose slot passed while the task was busy stay empty
+    uint32_t slot = (now - blob.h.startMs) / period;
+    if (slot > blob.h.frames) slot = blob.h.frames;
+    for (; nextFrame < slot; nextFrame++) {
+      for (uint8_t c = 0; c < channelCount; c++) blob.data[nextFrame * channelCount + c] = BURST_MISSING;
+    }
+    if (nextFrame >= blob.h.frames) {
+      finishCapture();
+      break;
+    }
+    sampleFrame(nextFrame++, now);
+    now = millis();
+  }
+  return UINT32_MAX;  // nothing scheduled
+}
+
+void uploadBurstCapture() {
+  if (captureState != BURST_READY || WiFi.status() != WL_CONNECTED) return;
+  if (uploadAttempts && millis() - lastAttempt < BURST_RETRY_MS) return;
+  HTTPClient http;
+  char url[128];
+  snprintf(url, sizeof(url), "http://%s:%d/api/v1/agents/%s/burst", SERVER_IP, SERVER_PORT, settings.deviceID);
+  http.begin(url);
+  http.addHeader("Content-Type", "application/octet-stream");
+  http.addHeader("Connection", "close");
+  http.addHeader("X-Device-Token", settings.token);
+  size_t len = sizeof(BurstHeader) + (size_t)blob.h.frames * channelCount * sizeof(uint16_t);
+  uint32_t t0 = micros();
+  int code = http.POST((uint8_t*)&blob, len);
+  metricsObserve(metrics.httpPost, micros() - t0);
+  metricsCountHttpResult(code);
+  http.end();
+  lastAttempt = millis();
+  if (code >= 200 && code < 300) {
+    Serial.printf("[BURST] uploaded %u bytes\n", (unsigned)len);
+    captureState = BURST_IDLE;
+  } else if (++uploadAttempts >= BURST_UPLOAD_ATTEMPTS) {
+    Serial.printf("[BURST] upload failed code=%d, capture dropped\n", code);
+    captureState = BURST_IDLE;
+  }
+}
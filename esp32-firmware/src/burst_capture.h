@@ -0,0 +1,57 @@
+// burst_capture.h
+#ifndef BURST_CAPTURE_H
+#define BURST_CAPTURE_H
+
+#include "config.h"
+
+// Burst capture: after a trigger (the pump switching on, a channel crossing
+// its threshold, or a remote request) the sensor task records the channels in
+// settings.burst.channels at settings.burst.hz for settings.burst.seconds into
+// a static buffer, with their probe supplies held on. serverTask then POSTs
+// the whole capture as one binary blob to /api/v1/agents/<id>/burst.
+//
+// Blob (little-endian): BurstHeader, then frames x channels uint16 mV, frame
+// by frame, channels in FilterChannel order; BURST_MISSING where a frame was
+// not sampled in time. The rate is bounded by the AdcTask burst length.
+#ifndef BURST_MAX_VALUES
+#define BURST_MAX_VALUES 1800  // 3.6 KB: 60 s of three channels at 10 Hz
+#endif
+#define BURST_HZ_MAX 10
+#define BURST_SECONDS_MAX 600
+#define BURST_MISSING 0xFFFF
+
+enum BurstTrigger : uint8_t {
+  BURST_TRIG_MANUAL = 0,
+  BURST_TRIG_PUMP = 1,
+  BURST_TRIG_CROSS = 0x10,  // + FilterChannel that crossed
+};
+
+struct __attribute__((packed)) BurstHeader {
+  char magic[4];       // "BRST"
+  uint8_t version;     // 1
+  uint8_t trigger;     // BurstTrigger
+  uint8_t channels;    // bit per FilterChannel recorded
+  uint8_t hz;
+  uint32_t startMs;    // millis() of frame 0
+  uint16_t periodMs;
+  uint16_t frames;
+};
+
+void defaultBurstConfig();
+// Apply a remote "burst" object ({"hz": 5, "seconds": 60, "channels":
+// ["soil1", "ph"], "onPump": true, "onCross": ["soil1"], "trigger": true})
+void applyBurstConfig(JsonObjectConst obj);
+// Start a capture on the next burstPoll() (the control task calls it when
+// the pump switches on); ignored while one is in progress
+void burstTrigger(uint8_t trigger);
+
+// Sensor task only: a new filtered value of an analog channel (threshold
+// crossings), and the capture step. burstPoll() returns the ms until it
+// next needs to run.
+void burstObserve(uint8_t analog, float value);
+uint32_t burstPoll(unsigned long nowMs);
+
+// serverTask: POST a finished capture; it is dropped after 3 failed attempts
+void uploadBurstCapture();
+
+#endif
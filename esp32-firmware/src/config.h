@@ -33,6 +33,9 @@
 #define SOIL2_PIN 35
 #define LDR_PIN 32
 #define PH_PIN 39
+// switched supplies for the soil probes and the pH board (sensor_power.h)
+#define SOIL_PWR_PIN 23
+#define PH_PWR_PIN 16
 
 #define RELAY_PUMP 18
 #define RELAY_FAN 21
@@ -45,12 +48,14 @@
 #define BTN_UP 26
 #define BTN_DOWN 13
 
-#define EEPROM_SIZE 512
+#define EEPROM_SIZE 1024
 #define FIRMWARE_VERSION "1.2.3"
 #define SERVER_IP "192.168.31.44"
 
 #define SERVER_PORT 80
 #define MAX_SCHEDULES 10
+#define MAX_RULES 8
+#define MAX_ALERT_RULES 6
 #define MAX_WIFI_NETWORKS 10
 
 extern const char* DEFAULT_SSID;
@@ -84,6 +89,69 @@ struct Schedule {
   bool forLight;
 };
 
+// Per-channel filter parameters (sensor_filter.h): millivolts -> units.
+// Outputs are integers: % for soil and light, 0.001 pH for pH.
+struct ChannelFilter {
+  uint8_t median;   // median-of-N window, 1 = off
+  uint8_t emaPct;   // EMA weight of the new sample in percent, 100 = off
+  int16_t mvLo;     // calibration point: millivolts that read as outLo
+  int16_t mvHi;     // calibration point: millivolts that read as outHi
+  uint8_t clamp;    // limit the output to outLo..outHi
+  uint8_t reserved;
+  int32_t outLo;
+  int32_t outHi;
+};
+enum FilterChannel { FILTER_SOIL1, FILTER_SOIL2, FILTER_LIGHT, FILTER_PH, FILTER_CHANNEL_COUNT };
+
+// windowed statistics (sensor_stats.h): 1 min and 15 min by default
+#define STATS_WINDOW_COUNT 2
+
+// sensorTask sampling period per channel group, in ms
+struct SamplePeriods {
+  uint32_t dhtMs;
+  uint32_t soilMs;
+  uint32_t soilPumpMs;  // soil while the pump runs
+  uint32_t lightMs;
+  uint32_t phMs;
+};
+
+// Burst capture (burst_capture.h): high-rate recording after a trigger
+struct BurstConfig {
+  uint8_t hz;         // samples per second while capturing, 1..10
+  uint8_t onPump;     // start when the pump switches on
+  uint16_t seconds;   // capture length
+  uint8_t channels;   // bit per FilterChannel recorded
+  uint8_t onCross;    // bit per FilterChannel whose threshold crossing starts one
+  uint8_t reserved[2];
+};
+
+// Relay rule (relay_control.h): a sensor against a hysteresis band, with
+// timing limits in seconds (0 = none)
+struct RelayRule {
+  uint8_t relay;      // RelayId switched
+  uint8_t kind;       // SensorKind compared, averaged over the zone
+  uint8_t zone;
+  uint8_t cmp;        // RuleCmp: on below / above the threshold
+  float threshold;    // NAN: the kind's threshold (settings.soilThresh, ...)
+  float band;         // off once back past threshold -/+ band
+  uint16_t minOnSec;
+  uint16_t minOffSec;
+  uint16_t maxRunSec;
+  uint16_t cooldownSec;  // off time after a maxRun cut-off
+};
+
+// Alert rule (alerts.h): a channel past a limit, cleared with hysteresis
+struct AlertRule {
+  uint8_t sensor;     // SensorId watched
+  uint8_t cmp;        // RuleCmp: alert below / above the limit
+  uint8_t severity;   // AlertSeverity
+  uint8_t reserved;
+  float limit;        // NAN: the threshold settings (pH: phThreshMin below)
+  float band;         // cleared once back past limit -/+ band
+  uint16_t repeatSec; // sent again this often while active, 0 = once
+  uint8_t reserved2[2];
+};
+
 struct Settings {
   char ssid[32];
   char pass[64];
@@ -110,10 +178,20 @@ struct Settings {
   char mqttUser[32];
   char mqttPass[64];
   bool mqttUseTLS;
+  // appended fields: loadSettings() migrates images written before they existed
+  ChannelFilter filters[FILTER_CHANNEL_COUNT];
+  SamplePeriods sampling;
+  uint16_t statsWindowSec[STATS_WINDOW_COUNT];
+  BurstConfig burst;
+  RelayRule rules[MAX_RULES];
+  uint8_t numRules;
+  AlertRule alerts[MAX_ALERT_RULES];
+  uint8_t numAlerts;
 };
+static_assert(sizeof(Settings) + 4 <= EEPROM_SIZE, "Settings + CRC exceed EEPROM_SIZE");
 extern Settings settings;
 
-enum MenuState { MAIN_SCREEN, MAIN_MENU, SCHEDULE_MENU, EDIT_SCHEDULE, THRESHOLD_MENU, EDIT_TEMP, EDIT_HUM, EDIT_SOIL, EDIT_LIGHT, EDIT_PH_MIN, EDIT_PH_MAX, LIGHT_SET_MENU, VERSION_MENU, INFO_MENU, MANUAL_CONTROL, WIFI_SETUP, AUTO_CONTROL_MENU };
+enum MenuState { MAIN_SCREEN, MAIN_MENU, SCHEDULE_MENU, EDIT_SCHEDULE, THRESHOLD_MENU, EDIT_TEMP, EDIT_HUM, EDIT_SOIL, EDIT_LIGHT, EDIT_PH_MIN, EDIT_PH_MAX, LIGHT_SET_MENU, VERSION_MENU, INFO_MENU, MANUAL_CONTROL, WIFI_SETUP, AUTO_CONTROL_MENU, STATS_MENU };
 extern MenuState menuState;
 
 extern int menuIndex, subIndex, editIndex;
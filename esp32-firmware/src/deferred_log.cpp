@@ -0,0 +1,194 @@
+// deferred_log.cpp
+#include "config.h"
+#include "deferred_log.h"
+#include "stack_monitor.h"
+#include <WiFiUdp.h>
+#include <atomic>
+
+volatile uint8_t logLevel = LOG_LVL_DEBUG;
+
+// Bounded MPMC ring (one sequence number per slot): producers on either core
+// claim a slot with a CAS on logHead and publish it by bumping its sequence,
+// so DLOG never takes a lock or waits; the single drainer follows logTail.
+struct LogSlot {
+  std::atomic<uint32_t> seq;
+  uint8_t len;
+  uint8_t data[LOG_RECORD_BYTES];
+};
+
+static LogSlot ring[LOG_RING_SLOTS];
+static std::atomic<uint32_t> logHead(0);
+static uint32_t logTail = 0;
+static std::atomic<uint32_t> dropped(0);
+static uint32_t droppedReported = 0;
+
+static struct RingInit {
+  RingInit() {
+    for (uint32_t i = 0; i < LOG_RING_SLOTS; i++) ring[i].seq.store(i, std::memory_order_relaxed);
+  }
+} ringInit;
+
+uint8_t* logReserve(uint32_t* ticket) {
+  uint32_t pos = logHead.load(std::memory_order_relaxed);
+  while (true) {
+    LogSlot& s = ring[pos & (LOG_RING_SLOTS - 1)];
+    int32_t diff = (int32_t)(s.seq.load(std::memory_order_acquire) - pos);
+    if (diff == 0) {
+      if (logHead.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (diff < 0) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return NULL;
+    } else {
+      pos = logHead.load(std::memory_order_relaxed);
+    }
+  }
+  *ticket = pos;
+  return ring[pos & (LOG_RING_SLOTS - 1)].data;
+}
+
+void logCommit(uint32_t ticket, uint8_t len) {
+  LogSlot& s = ring[ticket & (LOG_RING_SLOTS - 1)];
+  s.len = len;
+  s.seq.store(ticket + 1, std::memory_order_release);
+}
+
+uint32_t logDroppedCount() { return dropped.load(std::memory_order_relaxed); }
+
+// ---- output ----
+static WiFiUDP logUdp;
+static char udpHost[64] = "";
+static volatile uint16_t udpPort = 0;
+
+void logSetUdp(const char* host, uint16_t port) {
+  udpPort = 0;
+  strncpy(udpHost, host ? host : "", sizeof(udpHost) - 1);
+  udpHost[sizeof(udpHost) - 1] = '\0';
+  udpPort = udpHost[0] ? port : 0;
+}
+
+static uint8_t outBuf[256];
+static size_t outLen = 0;
+
+static void outFlush() {
+  if (!outLen) return;
+  Serial.write(outBuf, outLen);
+  uint16_t port = udpPort;
+  if (port && WiFi.status() == WL_CONNECTED) {
+    logUdp.beginPacket(udpHost, port);
+    logUdp.write(outBuf, outLen);
+    logUdp.endPacket();
+  }
+  outLen = 0;
+}
+
+static void outReserve(size_t n) {
+  if (outLen + n > sizeof(outBuf)) outFlush();
+}
+
+#ifdef LOG_TEXT_OUTPUT
+#define LOG_X_TEXT(id, level, fmt) fmt,
+static const char* const formatText[LOG_FORMAT_COUNT] = {LOG_FORMATS(LOG_X_TEXT)};
+
+// Render one record with its format string; same walk as log_decode.py
+static void emitRecord(const uint8_t* rec, uint8_t len) {
+  uint16_t id;
+  memcpy(&id, rec, 2);
+  if (id >= LOG_FORMAT_COUNT) return;
+  char line[200];
+  size_t n = 0;
+  const uint8_t* arg = rec + 6;
+  const uint8_t* end = rec + len;
+  for (const char* f = formatText[id]; *f && n < sizeof(line) - 1;) {
+    if (*f != '%') {
+      line[n++] = *f++;
+      continue;
+    }
+    // copy one conversion spec, dropping length modifiers
+    char spec[16];
+    size_t sl = 0;
+    spec[sl++] = *f++;
+    while (*f && strchr("-+ #0123456789.", *f) && sl < sizeof(spec) - 3) spec[sl++] = *f++;
+    while (*f && strchr("hlzjtL", *f)) f++;
+    char conv = *f ? *f++ : '%';
+    spec[sl++] = conv;
+    spec[sl] = '\0';
+    size_t room = sizeof(line) - n;
+    int w = 0;
+    if (conv == '%') {
+      line[n++] = '%';
+    } else if (conv == 's') {
+      uint8_t sl8 = arg < end ? *arg++ : 0;
+      if (arg + sl8 > end) sl8 = 0;
+      w = snprintf(line + n, room, "%.*s", (int)sl8, (const char*)arg);
+      arg += sl8;
+    } else if (arg + 4 <= end) {
+      if (strchr("fFeEgG", conv)) {
+        float v;
+        memcpy(&v, arg, 4);
+        w = snprintf(line + n, room, spec, (double)v);
+      } else {
+        uint32_t v;
+        memcpy(&v, arg, 4);
+        w = snprintf(line + n, room, spec, v);
+      }
+      arg += 4;
+    }
+    if (w > 0) n += (size_t)w < room ? (size_t)w : room - 1;
+  }
+  line[n++] = '\n';
+  outReserve(n);
+  memcpy(outBuf + outLen, line, n);
+  outLen += n;
+}
+#else
+// Frame: 0x1E, payload length, payload (id u16, ms u32, args), XOR of payload
+static void emitRecord(const uint8_t* rec, uint8_t len) {
+  outReserve((size_t)len + 3);
+  uint8_t x = 0;
+  for (uint8_t i = 0; i < len; i++) x ^= rec[i];
+  outBuf[outLen++] = 0x1E;
+  outBuf[outLen++] = len;
+  memcpy(outBuf + outLen, rec, len);
+  outLen += len;
+  outBuf[outLen++] = x;
+}
+#endif
+
+static void reportDropped() {
+  uint32_t d = dropped.load(std::memory_order_relaxed);
+  if (d == droppedReported) return;
+  uint8_t rec[10];
+  uint16_t id = LF_LOG_DROPPED;
+  uint32_t ts = millis();
+  uint32_t count = d - droppedReported;
+  memcpy(rec, &id, 2);
+  memcpy(rec + 2, &ts, 4);
+  memcpy(rec + 6, &count, 4);
+  emitRecord(rec, sizeof(rec));
+  droppedReported = d;
+}
+
+void logFlush() {
+  while (true) {
+    LogSlot& s = ring[logTail & (LOG_RING_SLOTS - 1)];
+    if (s.seq.load(std::memory_order_acquire) != logTail + 1) break;
+    emitRecord(s.data, s.len);
+    s.seq.store(logTail + LOG_RING_SLOTS, std::memory_order_release);
+    logTail++;
+  }
+  reportDropped();
+  outFlush();
+}
+
+static void logTask(void* pv) {
+  stackTrackSelf(STK_LOG);
+  while (1) {
+    logFlush();
+    vTaskDelay(pdMS_TO_TICKS(20));
+  }
+}
+
+void initLogging() {
+  // lowest application priority; UART waits happen here instead of in callers
+  xTaskCreatePinnedToCore(logTask, "LogTask", STACK_LOG_TASK, NULL, 1, NULL, 1);
+}
@@ -0,0 +1,132 @@
+// deferred_log.h
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+#include "config.h"
+#include "log_formats.h"
+#include <type_traits>
+
+// Deferred logging: DLOG() copies a format id, a timestamp and the binary
+// arguments into a lock-free ring and returns; LogTask drains the ring to
+// Serial (and optionally UDP) at low priority, so the UART never stalls the
+// sensor or network tasks. Frames are decoded on the host by
+// scripts/log_decode.py; build with -DLOG_TEXT_OUTPUT to have LogTask format
+// plain text instead (the native envs do).
+enum LogLevel {
+  LOG_LVL_DEBUG,
+  LOG_LVL_INFO,
+  LOG_LVL_WARN,
+  LOG_LVL_ERROR,
+  LOG_LVL_NONE
+};
+
+// messages below this level are compiled out
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LVL_DEBUG
+#endif
+#ifndef LOG_RING_SLOTS
+#define LOG_RING_SLOTS 64  // power of two
+#endif
+#ifndef LOG_RECORD_BYTES
+#define LOG_RECORD_BYTES 80  // id + timestamp + arguments
+#endif
+
+#define LOG_X_ID(id, level, fmt) id,
+#define LOG_X_LEVEL(id, level, fmt) id##_LEVEL = level,
+enum LogFormatId : uint16_t { LOG_FORMATS(LOG_X_ID) LOG_FORMAT_COUNT };
+enum { LOG_FORMATS(LOG_X_LEVEL) };
+
+// run-time filter, set from /apply_config ("logLevel")
+extern volatile uint8_t logLevel;
+
+#define DLOG(id, ...)                                                       \
+  do {                                                                      \
+    if ((int)id##_LEVEL >= (int)LOG_COMPILE_LEVEL && (int)id##_LEVEL >= logLevel) \
+      logWrite(id, ##__VA_ARGS__);                                          \
+  } while (0)
+
+// Start LogTask (call once from setup(); messages logged before it are kept)
+void initLogging();
+// Drain the ring on the calling task. Only one drainer may run at a time:
+// LogTask, or a host harness that does not start it.
+void logFlush();
+// Also send frames as UDP datagrams to host:port; port 0 turns this off
+void logSetUdp(const char* host, uint16_t port);
+// messages lost because the ring was full
+uint32_t logDroppedCount();
+
+// ---- record encoding ----
+struct LogWriter {
+  uint8_t* buf;
+  uint8_t len;
+  bool ok;
+
+  void put(const void* p, uint8_t n) {
+    if (!ok || len + n > LOG_RECORD_BYTES) {
+      ok = false;
+      return;
+    }
+    memcpy(buf + len, p, n);
+    len += n;
+  }
+};
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type logArg(LogWriter& w, T v) {
+  uint32_t u = (uint32_t)v;
+  w.put(&u, 4);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value>::type logArg(LogWriter& w, T v) {
+  float f = (float)v;
+  w.put(&f, 4);
+}
+
+// length byte + bytes, cut to what is left of the record
+inline void logArg(LogWriter& w, const char* s) {
+  if (!s) s = "";
+  size_t n = strlen(s);
+  size_t room = w.ok && w.len < LOG_RECORD_BYTES ? LOG_RECORD_BYTES - w.len - 1 : 0;
+  uint8_t len = (uint8_t)(n < room ? n : room);
+  w.put(&len, 1);
+  w.put(s, len);
+}
+
+inline void logEncode(LogWriter&) {}
+
+template <typename T, typename... Rest>
+inline void logEncode(LogWriter& w, T v, Rest... rest) {
+  logArg(w, v);
+  logEncode(w, rest...);
+}
+
+// Reserve a ring slot (NULL when full) and publish it once filled
+uint8_t* logReserve(uint32_t* ticket);
+void logCommit(uint32_t ticket, uint8_t len);
+
+template <typename... Args>
+void logWrite(LogFormatId id, Args... args) {
+  uint32_t ticket;
+  uint8_t* buf = logReserve(&ticket);
+  if (!buf) return;
+  LogWriter w = {buf, 0, true};
+  uint16_t fid = id;
+  uint32_t ts = millis();
+  w.put(&fid, 2);
+  w.put(&ts, 4);
+  logEncode(w, args...);
+  if (!w.ok) {
+    // replace with a marker rather than publish a record that will not decode
+    LogWriter m = {buf, 0, true};
+    uint16_t mid = LF_LOG_OVERSIZE;
+    uint32_t orig = id;
+    m.put(&mid, 2);
+    m.put(&ts, 4);
+    m.put(&orig, 4);
+    w = m;
+  }
+  logCommit(ticket, w.len);
+}
+
+#endif
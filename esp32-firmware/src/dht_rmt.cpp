@@ -0,0 +1,141 @@
+// dht_rmt.cpp
+#include "config.h"
+#include "dht_rmt.h"
+#include "sensors.h"
+#include "metrics.h"
+#include "deferred_log.h"
+
+// DHT11 wants the line held low for at least 18 ms, DHT22 for 1 ms (the
+// library's DHTxx constants are not preprocessor macros in every version)
+static const uint32_t DHT_START_MS = DHT_TYPE == DHT11 ? 20 : 2;
+#define DHT_BIT_ONE_US 48  // highs are ~26 us for a 0 and ~70 us for a 1
+
+static rmt_obj_t* rx = NULL;
+static volatile bool pending = false;
+static volatile bool haveReading = false;
+static SemaphoreHandle_t firstReading = NULL;
+
+// What the callback decoded since the sensor task last collected. Only the
+// sensor task writes sensorValues, so a frame cannot land mid-publish.
+static portMUX_TYPE frameMux = portMUX_INITIALIZER_UNLOCKED;
+static float frameT = NAN, frameH = NAN;
+static bool frameFresh = false;  // a good frame since the last collect
+static uint8_t frameFails = 0;   // failed transactions after it
+
+static void frameFailed(bool checksum) {
+  portENTER_CRITICAL(&frameMux);
+  if (frameFails < 255) frameFails++;
+  portEXIT_CRITICAL(&frameMux);
+  metricsInc(checksum ? metrics.dhtChecksumErrors : metrics.dhtTimeouts);
+}
+
+// RMT receive callback (core RMT task): the bits are the last 40 high pulses
+static void onFrame(uint32_t* data, size_t len, void* arg) {
+  if (!pending) return;  // our own start pulse, or noise between reads
+  pending = false;
+  const rmt_data_t* items = (const rmt_data_t*)data;
+  uint8_t highs[40];
+  uint8_t count = 0;
+  for (size_t i = 0; i < len; i++) {
+    uint16_t d[2] = {(uint16_t)items[i].duration0, (uint16_t)items[i].duration1};
+    uint8_t lv[2] = {(uint8_t)items[i].level0, (uint8_t)items[i].level1};
+    for (uint8_t k = 0; k < 2; k++) {
+      if (!d[k]) break;  // idle: end of frame
+      if (!lv[k]) continue;
+      highs[count % 40] = d[k] > 255 ? 255 : (uint8_t)d[k];
+      count++;
+    }
+  }
+  if (count < 41) {  // response high + 40 bits
+    DLOG(LF_DHT_SHORT_FRAME, count);
+    frameFailed(false);
+    return;
+  }
+  uint8_t b[5] = {0};
+  for (uint8_t i = 0; i < 40; i++) {
+    // oldest of the last 40 entries first
+    if (highs[(count + i) % 40] > DHT_BIT_ONE_US) b[i / 8] |= 0x80 >> (i % 8);
+  }
+  if ((uint8_t)(b[0] + b[1] + b[2] + b[3]) != b[4]) {
+    DLOG(LF_DHT_CHECKSUM, b[0], b[1], b[2], b[3], b[4]);
+    frameFailed(true);
+    return;
+  }
+  // same conversions as the Adafruit DHT library
+  float t, h;
+  if (DHT_TYPE == DHT11) {
+    h = b[0] + b[1] * 0.1f;
+    t = b[2];
+    if (b[3] & 0x80) t = -1 - t;
+    t += (b[3] & 0x0f) * 0.1f;
+  } else {
+    h = ((b[0] << 8) | b[1]) * 0.1f;
+    t = (((b[2] & 0x7F) << 8) | b[3]) * 0.1f;
+    if (b[2] & 0x80) t = -t;
+  }
+  portENTER_CRITICAL(&frameMux);
+  frameT = t;
+  frameH = h;
+  frameFresh = true;
+  frameFails = 0;
+  portEXIT_CRITICAL(&frameMux);
+  if (!haveReading) {
+    haveReading = true;
+    xSemaphoreGive(firstReading);
+  }
+}
+
+bool dhtRmtBegin() {
+  rx = rmtInit(DHT_PIN, RMT_RX_MODE, RMT_MEM_64);
+  if (!rx) return false;
+  rmtSetTick(rx, 1000);           // 1 us ticks
+  rmtSetRxThreshold(rx, 200);     // 200 us without an edge ends the frame
+  rmtSetFilter(rx, true, 100);    // ignore glitches under ~1.25 us (APB ticks)
+  firstReading = xSemaphoreCreateBinary();
+  pinMode(DHT_PIN, INPUT_PULLUP);
+  if (!rmtRead(rx, onFrame, NULL)) {
+    rmtEnd(rx);
+    rx = NULL;
+    return false;
+  }
+  return true;
+}
+
+bool dhtRmtActive() { return rx != NULL; }
+
+void dhtRmtStart() {
+  if (pending) {
+    // the previous transaction never produced a frame
+    pending = false;
+    DLOG(LF_DHT_NO_RESPONSE, DHT_PIN);
+    frameFailed(false);
+  }
+  pinMode(DHT_PIN, OUTPUT);
+  digitalWrite(DHT_PIN, LOW);
+  vTaskDelay(pdMS_TO_TICKS(DHT_START_MS));
+  pending = true;
+  // releasing the line starts the reply; the pull-up holds it high meanwhile
+  pinMode(DHT_PIN, INPUT_PULLUP);
+}
+
+bool dhtRmtWaitFirst(uint32_t ms) {
+  if (!haveReading && firstReading) xSemaphoreTake(firstReading, pdMS_TO_TICKS(ms));
+  return haveReading;
+}
+
+bool dhtRmtCollect() {
+  portENTER_CRITICAL(&frameMux);
+  bool fresh = frameFresh;
+  float t = frameT, h = frameH;
+  uint8_t fails = frameFails;
+  frameFresh = false;
+  frameFails = 0;
+  portEXIT_CRITICAL(&frameMux);
+  if (fresh) {
+    sensorValues[SENSOR_TEMP] = t;
+    sensorValues[SENSOR_HUM] = h;
+    dhtFailCount = 0;
+  }
+  dhtFailCount = dhtFailCount + fails < 255 ? dhtFailCount + fails : 255;
+  return fresh;
+}
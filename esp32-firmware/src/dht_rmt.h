@@ -0,0 +1,24 @@
+// dht_rmt.h
+#ifndef DHT_RMT_H
+#define DHT_RMT_H
+
+#include "config.h"
+
+// DHT11/22 reads without bit-banging: the caller only sends the start pulse
+// (a vTaskDelay, so the core stays free), the RMT peripheral times the reply
+// and its receive callback decodes it into a pending frame. The sensor task
+// moves that into sensorValues with dhtRmtCollect(); failed frames and silent
+// sensors count up dhtFailCount there as before.
+
+// Claim an RMT receiver on DHT_PIN; false keeps the DHT library path
+bool dhtRmtBegin();
+bool dhtRmtActive();
+// Start a transaction; returns after the ~20 ms start pulse, before the reply
+void dhtRmtStart();
+// Wait up to ms for the first decoded reading (boot only); true once there is one
+bool dhtRmtWaitFirst(uint32_t ms);
+// Sensor task: apply the frames decoded since the last call to
+// sensorValues[SENSOR_TEMP/HUM] and dhtFailCount; true if a good one came in
+bool dhtRmtCollect();
+
+#endif
@@ -1,5 +1,14 @@
 // eeprom_utils.cpp
 #include "eeprom_utils.h"
+#include "metrics.h"
+#include "trace.h"
+#include "task_monitor.h"
+#include "stack_monitor.h"
+#include "sensors.h"
+#include "sensor_stats.h"
+#include "burst_capture.h"
+#include "relay_control.h"
+#include "alerts.h"
 #include <LittleFS.h>
 #include <ArduinoJson.h>
 
@@ -34,7 +43,7 @@ unsigned long eepromWriteCount = 0;
 static const unsigned long EEPROM_COMMIT_DEBOUNCE_MS = 5000; // 5s debounce
 
 // CRC32 helper
-static uint32_t crc32(const uint8_t *data, size_t len) {
+uint32_t crc32(const uint8_t *data, size_t len) {
   uint32_t crc = 0xFFFFFFFF;
   while (len--) {
     uint8_t byte = *data++;
@@ -44,12 +53,55 @@ static uint32_t crc32(const uint8_t *data, size_t len) {
   return ~crc;
 }
 
+// EEPROM.commit() rewrites the flash sector; time it for /metrics
+static void commitEEPROM() {
+  uint32_t t0 = micros();
+  EEPROM.commit();
+  metricsObserve(metrics.eepromCommit, micros() - t0);
+}
+
+// One LittleFS mount per boot, shared by settings, identity and the failed
+// payload queue. Never formats: that would erase identity.json, so a broken
+// filesystem needs an explicit admin action.
+static bool littlefsTried = false;
+static bool littlefsAvailable = false;
+
+bool ensureLittleFS() {
+  if (littlefsTried) return littlefsAvailable;
+  littlefsTried = true;
+  littlefsAvailable = LittleFS.begin();
+  if (!littlefsAvailable) Serial.println("LittleFS mount failed; not formatting automatically.");
+  return littlefsAvailable;
+}
+
+// Write /identity.json when deviceID/token differ from what was last written.
+// It is rewritten on every settings save otherwise, costing a flash write and
+// a LittleFS file handle per save for data that never changes.
+static void persistIdentity() {
+  static char written[sizeof(settings.deviceID) + sizeof(settings.token)] = "";
+  char cur[sizeof(written)];
+  snprintf(cur, sizeof(cur), "%s:%s", settings.deviceID, settings.token);
+  if (strcmp(cur, written) == 0) return;
+  if (!ensureLittleFS()) return;
+  StaticJsonDocument<128> iddoc;
+  iddoc["deviceID"] = (const char*)settings.deviceID;
+  iddoc["token"] = (const char*)settings.token;
+  File f = LittleFS.open("/identity.json", "w");
+  if (f) {
+    serializeJson(iddoc, f);
+    f.close();
+    memcpy(written, cur, sizeof(written));
+  }
+}
+
 void initEEPROM() {
   EEPROM.begin(EEPROM_SIZE);
   // start eeprom writer task
   xTaskCreatePinnedToCore([](void*){
     const TickType_t delay = pdMS_TO_TICKS(500);
+    stackTrackSelf(STK_EEPROM);
     while (1) {
+      taskLoopHead(MON_EEPROM);
       if (eepromPending) {
         if (millis() - eepromPendingSince >= EEPROM_COMMIT_DEBOUNCE_MS) {
           // perform immediate write
@@ -57,7 +109,7 @@ void initEEPROM() {
           uint32_t crc = crc32((uint8_t*)&settings, sizeof(Settings));
           EEPROM.put(0, crc);
           EEPROM.put(4, settings);
-          EEPROM.commit();
+          commitEEPROM();
           lastEepromWrite = millis();
           eepromWriteCount++;
           eepromPending = false;
@@ -65,7 +117,7 @@ void initEEPROM() {
       }
       vTaskDelay(delay);
     }
-  }, "EEPROMTask", 4096, NULL, 1, NULL, 1);
+  }, "EEPROMTask", STACK_EEPROM_TASK, NULL, 1, NULL, 1);
 }
 
 void loadSettings() {
@@ -78,12 +130,32 @@ void loadSettings() {
   settings.pass[63] = '\0';
 
   uint32_t calc = crc32((uint8_t*)&settings, sizeof(Settings));
+  // images from older firmware end where the first field it lacked starts
+  bool migrated = false;
   if (storedCrc != calc) {
+    bool noFilters = storedCrc == crc32((uint8_t*)&settings, offsetof(Settings, filters));
+    bool noSampling = noFilters || storedCrc == crc32((uint8_t*)&settings, offsetof(Settings, sampling));
+    bool noStats = noSampling || storedCrc == crc32((uint8_t*)&settings, offsetof(Settings, statsWindowSec));
+    bool noBurst = noStats || storedCrc == crc32((uint8_t*)&settings, offsetof(Settings, burst));
+    bool noRules = noBurst || storedCrc == crc32((uint8_t*)&settings, offsetof(Settings, rules));
+    if (noRules || storedCrc == crc32((uint8_t*)&settings, offsetof(Settings, alerts))) {
+      Serial.println("[EEPROM] settings from older firmware, adding defaults for new fields");
+      if (noFilters) defaultFilterSettings();
+      if (noSampling) defaultSamplePeriods();
+      if (noStats) defaultStatsWindows();
+      if (noBurst) defaultBurstConfig();
+      if (noRules) defaultRelayRules();
+      defaultAlertRules();
+      saveSettingsNow();
+      migrated = true;
+    }
+  }
+  if (storedCrc != calc && !migrated) {
     // EEPROM invalid — try to recover device identity from LittleFS first
     memset(&settings, 0x00, sizeof(Settings));
     // attempt to mount LittleFS and read identity file
     bool gotIdentity = false;
-    if (LittleFS.begin()) {
+    if (ensureLittleFS()) {
       if (LittleFS.exists("/identity.json")) {
         File f = LittleFS.open("/identity.json", "r");
         if (f) {
@@ -121,6 +193,12 @@ void loadSettings() {
         settings.numSchedules = 1;
         settings.schedules[0] = {2, 50, true, false};
       }
+      defaultFilterSettings();
+      defaultSamplePeriods();
+      defaultStatsWindows();
+      defaultBurstConfig();
+      defaultRelayRules();
+      defaultAlertRules();
       // Persist immediately so CRC and EEPROM are consistent
       saveSettingsNow();
     }
@@ -162,18 +240,15 @@ void loadSettings() {
     strncpy(settings.mqttPass, "", sizeof(settings.mqttPass)-1);
     settings.mqttPass[sizeof(settings.mqttPass)-1] = '\0';
     settings.mqttUseTLS = false;
+    defaultFilterSettings();
+    defaultSamplePeriods();
+    defaultStatsWindows();
+    defaultBurstConfig();
+    defaultRelayRules();
+    defaultAlertRules();
     saveSettings();
     // persist identity to LittleFS so future flashes can recover stable ID/token
-    if (LittleFS.begin()) {
-      DynamicJsonDocument iddoc(256);
-      iddoc["deviceID"] = String(settings.deviceID);
-      iddoc["token"] = String(settings.token);
-      File f = LittleFS.open("/identity.json", "w");
-      if (f) {
-        serializeJson(iddoc, f);
-        f.close();
-      }
-    }
+    persistIdentity();
   }
 
   // Sửa: Nếu SSID rỗng hoặc không hợp lệ → dùng mặc định
@@ -199,6 +274,9 @@ void loadSettings() {
     saveSettings();
   }
 
+  // calibration from an older layout (raw counts) or corrupted values
+  if (validateFilterSettings()) saveSettings();
+
   // Ensure mqtt strings are NUL-terminated and valid after load
   settings.mqttBroker[sizeof(settings.mqttBroker)-1] = '\0';
   settings.mqttUser[sizeof(settings.mqttUser)-1] = '\0';
@@ -213,31 +291,23 @@ void saveSettings() {
 }
 
 void saveSettingsNow() {
+  TRACE_SPAN("saveSettingsNow");
   // immediate write to EEPROM (compute CRC and commit)
   uint32_t crc = crc32((uint8_t*)&settings, sizeof(Settings));
   EEPROM.put(0, crc);
   EEPROM.put(4, settings);
-  EEPROM.commit();
+  commitEEPROM();
   lastEepromWrite = millis();
   eepromWriteCount++;
   eepromPending = false;
   // Also persist identity to LittleFS (best-effort, does not format)
-  if (LittleFS.begin()) {
-    DynamicJsonDocument iddoc(256);
-    iddoc["deviceID"] = String(settings.deviceID);
-    iddoc["token"] = String(settings.token);
-    File f = LittleFS.open("/identity.json", "w");
-    if (f) {
-      serializeJson(iddoc, f);
-      f.close();
-    }
-  }
+  persistIdentity();
 }
 
 void clearEEPROM() {
   for (int i = 0; i < EEPROM_SIZE; i++) {
     EEPROM.write(i, 0xFF);
   }
-  EEPROM.commit();
+  commitEEPROM();
   Serial.println("EEPROM cleared - will use default WiFi on restart");
 }
\ No newline at end of file
@@ -8,6 +8,10 @@ void loadSettings();
 void saveSettings();
 void saveSettingsNow();
 void clearEEPROM(); 
+// Mount LittleFS on first use (no auto-format); false if unavailable
+bool ensureLittleFS();
+// CRC32 (reflected, poly 0xEDB88320) used to validate the stored Settings
+uint32_t crc32(const uint8_t *data, size_t len);
 extern unsigned long eepromWriteCount;
 
 #endif
\ No newline at end of file
@@ -1,9 +1,14 @@
 #include "lcd_menu.h"
 #include "config.h"
 #include "sensors.h"
+#include "sensor_stats.h"
+#include "relay_control.h"
 #include "ota_update.h"
 #include "eeprom_utils.h"
 #include "wifi_server.h"
+#include "trace.h"
+#include "task_monitor.h"
+#include "task_stacks.h"
 #include <esp_sleep.h>
 
 extern hd44780_I2Cexp lcd;
@@ -88,6 +93,7 @@ static void lcdWriteLineIfChanged(int row, const char* text) {
   desired[20] = '\0';
 
   if (memcmp(desired, lcd_last[row], 20) != 0) {
+    TRACE_SPAN("lcdWriteLine");
     if (lcdMutex && xSemaphoreTake(lcdMutex, pdMS_TO_TICKS(200)) == pdTRUE) {
       // NOTE: do NOT automatically turn on backlight for background/automatic
       // updates (to avoid waking the display and causing flicker). Only
@@ -163,10 +169,20 @@ void drawMainScreen() {
   char line1[21];
   char line2[21];
   char line3[21];
-  snprintf(line0, sizeof(line0), "T:%4.1fC H:%02d%% pH:%3.1f", state.temp, (int)state.hum, state.ph);
-  snprintf(line1, sizeof(line1), "S1:%3d%% S2:%3d%%", state.soil1, state.soil2);
-  snprintf(line2, sizeof(line2), "Light:%3d%% WiFi:%s", state.light, WiFi.status()==WL_CONNECTED?"ON":"OFF");
-  snprintf(line3, sizeof(line3), "P:%s F:%s L:%s", state.pump?"ON":"OFF", state.fan?"ON":"OFF", state.lightOn?"ON":"OFF");
+  SensorSnapshot snap;
+  snapshotSensorState(&snap);
+  const float* v = snap.values;
+  snprintf(line0, sizeof(line0), "T:%4.1fC H:%02d%% pH:%3.1f", v[SENSOR_TEMP], (int)v[SENSOR_HUM], v[SENSOR_PH]);
+  // one "S1:nn%" per soil probe, as many as fit
+  int n = 0;
+  line1[0] = '\0';
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    if (sensorChannels[i].kind != KIND_SOIL || n >= (int)sizeof(line1) - 1) continue;
+    n += snprintf(line1 + n, sizeof(line1) - n, "%s%s:%3d%%", n ? " " : "", sensorChannels[i].label, (int)lroundf(v[i]));
+  }
+  snprintf(line2, sizeof(line2), "Light:%3d%% WiFi:%s", (int)lroundf(v[SENSOR_LIGHT]), WiFi.status()==WL_CONNECTED?"ON":"OFF");
+  const SensorState& r = snap.relays;
+  snprintf(line3, sizeof(line3), "P:%s F:%s L:%s", r.pump?"ON":"OFF", r.fan?"ON":"OFF", r.lightOn?"ON":"OFF");
   lcdWriteLineIfChanged(0, line0);
   lcdWriteLineIfChanged(1, line1);
   lcdWriteLineIfChanged(2, line2);
@@ -182,7 +198,8 @@ void drawMainMenu() {
     "Version   ",
     "Info      ",
     "Manual    ",
-    "WiFi      "
+    "WiFi      ",
+    "Stats     "
   };
   char line[4][21];
   for (int r = 0; r < 4; r++) {
@@ -190,10 +207,10 @@ void drawMainMenu() {
     int rightIdx = r * 2 + 1;
     char tmp[21];
     // always show selection marker '>' so user can see current focus
-    snprintf(tmp, sizeof(tmp), "%s%s", (leftIdx < 7 && menuIndex == leftIdx) ? ">" : " ", (leftIdx < 7) ? items[leftIdx] : "                    ");
+    snprintf(tmp, sizeof(tmp), "%s%s", (leftIdx < 8 && menuIndex == leftIdx) ? ">" : " ", (leftIdx < 8) ? items[leftIdx] : "                    ");
     // right part
     char rightPart[11] = "          ";
-    if (rightIdx < 7) {
+    if (rightIdx < 8) {
       snprintf(rightPart, sizeof(rightPart), "%s%s", (menuIndex == rightIdx) ? ">" : " ", items[rightIdx]);
     }
     snprintf(line[r], sizeof(line[r]), "%s%s", tmp, rightPart);
@@ -201,6 +218,31 @@ void drawMainMenu() {
   }
 }
 
+// one channel (subIndex, up/down) over one window (editIndex, left/right),
+// from the last completed window
+void drawStatsMenu() {
+  const SensorChannel& ch = sensorChannels[subIndex];
+  uint16_t sec = statsWindowSec(editIndex);
+  char win[8];
+  if (sec % 60 == 0) snprintf(win, sizeof(win), "%um", sec / 60);
+  else snprintf(win, sizeof(win), "%us", sec);
+  char line[4][21];
+  StatsSummary s;
+  bool ok = statsSummary(editIndex, (SensorId)subIndex, &s) && s.count;
+  snprintf(line[0], sizeof(line[0]), "%-5s %4s n:%u", ch.key, win, ok ? s.count : 0);
+  if (!ok) {
+    snprintf(line[1], sizeof(line[1]), "collecting...");
+    line[2][0] = '\0';
+    line[3][0] = '\0';
+  } else {
+    snprintf(line[1], sizeof(line[1]), "min%6.1f max%6.1f", s.min, s.max);
+    snprintf(line[2], sizeof(line[2]), "avg%6.1f sd %6.2f", s.mean, s.sd);
+    unsigned pct = s.spanMs ? (unsigned)((uint64_t)s.aboveMs * 100 / s.spanMs) : 0;
+    snprintf(line[3], sizeof(line[3]), "above thr:%3u%%", pct);
+  }
+  for (int r = 0; r < 4; r++) lcdWriteLineIfChanged(r, line[r]);
+}
+
 void drawAutoControlMenu() {
   char l0[21], l1[21], l2[21];
   snprintf(l0, sizeof(l0), "%sPump Auto: %s", (menuIndex == 0 && blinkState) ? ">" : " ", settings.pumpAuto ? "ON" : "OFF");
@@ -334,13 +376,16 @@ void drawManualControl() {
   // build 3 lines to avoid direct lcd.clear()/print which cause race conditions
   const char* labels[] = {"Pump","Fan","Light"};
   char ln[4][21];
+  SensorSnapshot snap;
+  snapshotSensorState(&snap);
+  const SensorState& r = snap.relays;
   for (int i = 0; i < 3; i++) {
     // If auto-mode for this relay is enabled, show AUTO and disable manual toggle
     const char* status;
     if (i == 0 && settings.pumpAuto) status = "AUTO";
     else if (i == 1 && settings.fanAuto) status = "AUTO";
     else if (i == 2 && settings.lightAuto) status = "AUTO";
-    else status = (i==0? (state.pump?"ON":"OFF") : (i==1? (state.fan?"ON":"OFF") : (state.lightOn?"ON":"OFF")));
+    else status = (i==0? (r.pump?"ON":"OFF") : (i==1? (r.fan?"ON":"OFF") : (r.lightOn?"ON":"OFF")));
     snprintf(ln[i], sizeof(ln[i]), "%s%-7s: %s", (menuIndex==i)?">":" ", labels[i], status);
     lcdWriteLineIfChanged(i, ln[i]);
   }
@@ -411,6 +456,7 @@ void handleOK() {
         case 4: menuState = INFO_MENU; drawInfoMenu(); break;
         case 5: menuState = MANUAL_CONTROL; menuIndex = 0; drawManualControl(); break;
         case 6: menuState = WIFI_SETUP; editingPass = false; strncpy(inputBuffer, settings.ssid, sizeof(inputBuffer)-1); inputBuffer[sizeof(inputBuffer)-1] = '\0'; inputPos = strlen(inputBuffer); drawWiFiSetup(); break;
+        case 7: menuState = STATS_MENU; subIndex = 0; editIndex = 0; drawStatsMenu(); break;
       }
       break;
     case SCHEDULE_MENU:
@@ -432,6 +478,7 @@ void handleOK() {
           settings.schedules[settings.numSchedules++] = tempSchedule;
         }
           saveSettingsNow();
+          controlNotifyConfig();
           // suppress remote updates longer so backend has time to persist
           suppressRemoteUntil = millis() + 30000;
           requestTelemetrySendPersist();
@@ -447,6 +494,7 @@ void handleOK() {
       if (menuIndex == 2) { settings.lightAuto = !settings.lightAuto; if (settings.lightAuto) settings.relayOverride = false; }
       // Persist immediately and notify backend so the device state is authoritative
       saveSettingsNow();
+      controlNotifyConfig();
       // suppress remote updates longer so backend has time to persist
       suppressRemoteUntil = millis() + 30000;
       requestTelemetrySendPersist();
@@ -472,6 +520,7 @@ void handleOK() {
       else if (menuState == EDIT_PH_MIN) settings.phThreshMin = tempEditVal;
       else if (menuState == EDIT_PH_MAX) settings.phThreshMax = tempEditVal;
       saveSettingsNow();
+      controlNotifyConfig();
       // suppress remote updates longer to allow server to persist
       suppressRemoteUntil = millis() + 30000;
       requestTelemetrySendPersist();
@@ -482,6 +531,7 @@ void handleOK() {
       settings.lightAuto = !settings.lightAuto;
       if (settings.lightAuto) settings.relayOverride = false;
       saveSettingsNow();
+      controlNotifyConfig();
       suppressRemoteUntil = millis() + 30000;
       requestTelemetrySendPersist();
       menuState = MAIN_SCREEN;
@@ -521,6 +571,8 @@ void handleOK() {
           saveSettingsNow(); suppressRemoteUntil = millis() + 30000; requestTelemetrySendPersist();
         }
       }
+      publishSensorState();
+      controlNotifyConfig();
       if (ignored) {
         lcdWriteLineIfChanged(3, "Manual disabled: AUTO");
         vTaskDelay(pdMS_TO_TICKS(800));
@@ -551,7 +603,7 @@ void handleOK() {
 void handleBack() {
   if (menuState == MAIN_MENU || menuState == SCHEDULE_MENU || menuState == THRESHOLD_MENU ||
       menuState == LIGHT_SET_MENU || menuState == VERSION_MENU || menuState == INFO_MENU ||
-      menuState == MANUAL_CONTROL || menuState == WIFI_SETUP) {
+      menuState == MANUAL_CONTROL || menuState == WIFI_SETUP || menuState == STATS_MENU) {
     menuState = MAIN_SCREEN;
     drawMainScreen();
   } else if (menuState == EDIT_SCHEDULE) {
@@ -570,7 +622,7 @@ void handleUp() {
   switch (menuState) {
     case MAIN_MENU:
       if (menuIndex >= 2) menuIndex -= 2;
-      else menuIndex = (menuIndex % 2 == 0) ? 6 : 5;
+      else menuIndex = (menuIndex % 2 == 0) ? 6 : 7;
       drawMainMenu(); break;
     case THRESHOLD_MENU:
       if (menuIndex >= 2) menuIndex -= 2;
@@ -582,6 +634,9 @@ void handleUp() {
     case MANUAL_CONTROL:
       menuIndex = (menuIndex == 0) ? 2 : menuIndex - 1;
       drawManualControl(); break;
+    case STATS_MENU:
+      subIndex = (subIndex == 0) ? SENSOR_COUNT - 1 : subIndex - 1;
+      drawStatsMenu(); break;
     case AUTO_CONTROL_MENU:  // Thêm case này để lên giảm menuIndex
       menuIndex = (menuIndex == 0) ? 2 : menuIndex - 1;
       drawAutoControlMenu(); break;
@@ -615,7 +670,7 @@ void handleUp() {
 void handleDown() {
   switch (menuState) {
     case MAIN_MENU:
-      if (menuIndex <= 4) menuIndex += 2;
+      if (menuIndex <= 5) menuIndex += 2;
       else menuIndex = (menuIndex % 2 == 0) ? 0 : 1;
       drawMainMenu(); break;
     case THRESHOLD_MENU:
@@ -628,6 +683,9 @@ void handleDown() {
     case MANUAL_CONTROL:
       menuIndex = (menuIndex + 1) % 3;
       drawManualControl(); break;
+    case STATS_MENU:
+      subIndex = (subIndex + 1) % SENSOR_COUNT;
+      drawStatsMenu(); break;
     case AUTO_CONTROL_MENU:
       menuIndex = (menuIndex + 1) % 3;
       drawAutoControlMenu(); break;
@@ -671,6 +729,9 @@ void handleLeft() {
     case EDIT_SCHEDULE:
       editIndex = (editIndex == 0) ? 3 : editIndex - 1;
       drawEditSchedule(); break;
+    case STATS_MENU:
+      editIndex = (editIndex == 0) ? STATS_WINDOW_COUNT - 1 : editIndex - 1;
+      drawStatsMenu(); break;
     case WIFI_SETUP:
       {
         size_t iblen = strlen(inputBuffer);
@@ -685,8 +746,8 @@ void handleLeft() {
 void handleRight() {
   switch (menuState) {
     case MAIN_MENU:
-      if (menuIndex % 2 == 0 && menuIndex < 6) menuIndex++;
-      else if (menuIndex <= 4) menuIndex += 2;
+      if (menuIndex % 2 == 0 && menuIndex < 7) menuIndex++;
+      else if (menuIndex <= 5) menuIndex += 2;
       drawMainMenu(); break;
     case THRESHOLD_MENU:
       if (menuIndex % 2 == 0 && menuIndex < 5) menuIndex++;
@@ -695,6 +756,9 @@ void handleRight() {
     case EDIT_SCHEDULE:
       editIndex = (editIndex + 1) % 4;
       drawEditSchedule(); break;
+    case STATS_MENU:
+      editIndex = (editIndex + 1) % STATS_WINDOW_COUNT;
+      drawStatsMenu(); break;
     case WIFI_SETUP:
       {
         size_t iblen = strlen(inputBuffer);
@@ -734,6 +798,7 @@ void updateMenu() {
       case INFO_MENU: drawInfoMenu(); break;
       case MANUAL_CONTROL: drawManualControl(); break;
       case WIFI_SETUP: drawWiFiSetup(); break;
+      case STATS_MENU: drawStatsMenu(); break;
       case EDIT_TEMP: case EDIT_HUM: case EDIT_SOIL:
       case EDIT_LIGHT: case EDIT_PH_MIN: case EDIT_PH_MAX:
         // sẽ redraw trong handleUp/Down/OK
@@ -753,6 +818,8 @@ void updateMenu() {
       case AUTO_CONTROL_MENU: drawAutoControlMenu(); break;
       case VERSION_MENU: drawVersionMenu(); break;
       case MANUAL_CONTROL: drawManualControl(); break;
+      // picks up a window that closed while it is shown
+      case STATS_MENU: drawStatsMenu(); break;
       case EDIT_TEMP: case EDIT_HUM: case EDIT_SOIL:
       case EDIT_LIGHT: case EDIT_PH_MIN: case EDIT_PH_MAX:
         // redraw giá trị đang edit: pass both current (settings) and in-progress edit value
@@ -812,6 +879,7 @@ void buttonTask(void *param) {
 
   unsigned long lastDebounce = 0;
   while (1) {
+    taskLoopHead(MON_BUTTON);
     feedWatchdog();
     unsigned long now = millis();
     if (now - lastDebounce > 10) { // poll every ~10ms
@@ -845,6 +913,7 @@ void lcdTask(void *param) {
   const TickType_t tick = pdMS_TO_TICKS(250);
   ButtonEvent ev;
   while (1) {
+    taskLoopHead(MON_LCD);
     feedWatchdog();
     // process incoming LCD messages (from other tasks)
     if (lcdQueue) {
@@ -891,6 +960,6 @@ void startUITasks() {
   lastActivityMillis = millis();
   backlightOn = true;
   // create tasks pinned to core 1
-  xTaskCreatePinnedToCore(buttonTask, "ButtonTask", 4096, NULL, 3, &buttonTaskHandle, 1);
-  xTaskCreatePinnedToCore(lcdTask, "LCDTask", 8192, NULL, 2, &lcdTaskHandle, 1);
+  xTaskCreatePinnedToCore(buttonTask, "ButtonTask", STACK_BUTTON_TASK, NULL, 3, &buttonTaskHandle, 1);
+  xTaskCreatePinnedToCore(lcdTask, "LCDTask", STACK_LCD_TASK, NULL, 2, &lcdTaskHandle, 1);
 }
\ No newline at end of file
@@ -27,6 +27,7 @@ void drawVersionMenu();
 void drawInfoMenu();
 void drawManualControl();
 void drawWiFiSetup();
+void drawStatsMenu();
 
 void handleOK();
 void handleBack();
@@ -0,0 +1,42 @@
+// log_formats.h
+// Every deferred log message as X(id, level, format). On the wire a message is
+// only its index in this list plus binary arguments; scripts/log_decode.py
+// reads this file to turn them back into text. Append new entries at the end
+// and do not reorder or reuse old ones while captures still need decoding.
+//
+// Arguments are 32-bit: %d %i %u %x %X %c take any integer, %f %e %g take a
+// float, %s a string (truncated to fit the record).
+#ifndef LOG_FORMATS_H
+#define LOG_FORMATS_H
+
+#define LOG_FORMATS(X) \
+  X(LF_LOG_DROPPED,         LOG_LVL_WARN,  "[LOG] %u messages dropped (ring full)") \
+  X(LF_LOG_OVERSIZE,        LOG_LVL_WARN,  "[LOG] message %u did not fit a record") \
+  X(LF_SENSORS_DHT,         LOG_LVL_DEBUG, "[SENSORS] DHT t=%.2f h=%.2f dhtFail=%u") \
+  X(LF_SENSORS_RAW,         LOG_LVL_DEBUG, "[SENSORS] RAW soil1=%d soil2=%d") \
+  X(LF_SENSORS_RAW_LIGHT,   LOG_LVL_DEBUG, "[SENSORS] rawLight=%d rawPHraw=%0.1f") \
+  X(LF_SENSORS_RESULT,      LOG_LVL_DEBUG, "[SENSORS] light=%d ph=%.2f voltage=%.3f") \
+  X(LF_RELAY_PUMP,          LOG_LVL_INFO,  "[RELAY] pump -> %s") \
+  X(LF_RELAY_FAN,           LOG_LVL_INFO,  "[RELAY] fan -> %s") \
+  X(LF_RELAY_LIGHT,         LOG_LVL_INFO,  "[RELAY] light -> %s") \
+  X(LF_HTTP_POST,           LOG_LVL_INFO,  "[HTTP] POST %s") \
+  X(LF_HTTP_PAYLOAD,        LOG_LVL_DEBUG, "[HTTP] payload len=%u") \
+  X(LF_HTTP_ATTEMPT_FAILED, LOG_LVL_WARN,  "[HTTP] attempt %d failed, code=%d, err=%s") \
+  X(LF_HTTP_POST_FAILED,    LOG_LVL_WARN,  "HTTP POST failed, code: %d, err=%s") \
+  X(LF_SERVER_RESP,         LOG_LVL_DEBUG, "[SERVER_RESP] response (%u bytes): %s") \
+  X(LF_SERVER_PENDING,      LOG_LVL_INFO,  "[SERVER_RESP] pending config received") \
+  X(LF_SERVER_PENDING_FLAG, LOG_LVL_DEBUG, "[SERVER_RESP] pending.%s=%d") \
+  X(LF_MQTT_CONNECTED,      LOG_LVL_INFO,  "[MQTT] connected") \
+  X(LF_MQTT_CONNECT_FAILED, LOG_LVL_WARN,  "[MQTT] connect failed") \
+  X(LF_MQTT_CONFIG,         LOG_LVL_INFO,  "[MQTT] config message received") \
+  X(LF_WATCHDOG_STACKS,     LOG_LVL_INFO,  "[WATCHDOG] stacks: server=%u lcd=%u btn=%u sensor=%u freeHeap=%u") \
+  X(LF_WATCHDOG_CPU,        LOG_LVL_INFO,  "[WATCHDOG] cpu: core0=%d%% core1=%d%% loop gaps ms: server=%u sensor=%u lcd=%u btn=%u eeprom=%u") \
+  X(LF_BOOT_TASKS,          LOG_LVL_INFO,  "[BOOT] control and UI tasks running at %u ms") \
+  X(LF_STACK_PEAK,          LOG_LVL_INFO,  "[STACK] %s size=%u peak=%u recommend=%u") \
+  X(LF_ADC_DEPTH,           LOG_LVL_DEBUG, "[ADC] oversampling depth %u -> %u (max sd %.1f)") \
+  X(LF_ADC_SHORT,           LOG_LVL_WARN,  "[ADC] burst ended short: %u of %u conversions per channel") \
+  X(LF_DHT_CHECKSUM,        LOG_LVL_WARN,  "[DHT] checksum mismatch: %02x %02x %02x %02x sum %02x") \
+  X(LF_DHT_SHORT_FRAME,     LOG_LVL_WARN,  "[DHT] frame cut short: %u high pulses") \
+  X(LF_DHT_NO_RESPONSE,     LOG_LVL_WARN,  "[DHT] no reply on GPIO %u")
+
+#endif
@@ -6,6 +6,14 @@
 #include "wifi_server.h"
 #include "eeprom_utils.h"
 #include "ota_update.h"
+#include "metrics.h"
+#include "trace.h"
+#include "task_monitor.h"
+#include "deferred_log.h"
+#include "boot_timeline.h"
+#include "task_stacks.h"
+#include "burst_capture.h"
+#include "alerts.h"
 // #define CLEAR_EEPROM_ONCE   // clear EEPROM
 hd44780_I2Cexp lcd;
 
@@ -14,11 +22,13 @@ static bool ntpInitialized = false;
 bool lcdAvailable = false;
 
 void setup() {
+  // no settle delay: output before a monitor attaches is simply missed
   Serial.begin(115200);
-  delay(1000);
   Serial.println("=== BOOT START ===");
   Serial.printf("FIRMWARE_VERSION=%s\n", FIRMWARE_VERSION);
+  initLogging();
   initEEPROM();
+  bootMark(BOOT_EEPROM);
 
 //clear EEPROM
 #ifdef CLEAR_EEPROM_ONCE
@@ -31,12 +41,11 @@ void setup() {
 
 
   Wire.begin(SDA_PIN, SCL_PIN);
-  // Init filesystem for persistent payload queue
-  if (!LittleFS.begin()) {
-    Serial.println("LittleFS failed to mount");
-  } else {
-    Serial.println("LittleFS mounted");
-  }
+  // Mount the filesystem once for settings recovery, identity and the payload queue
+  if (ensureLittleFS()) Serial.println("LittleFS mounted");
+  bootMark(BOOT_FS);
+  loadSettings();
+  bootMark(BOOT_SETTINGS);
 
   int status = lcd.begin(20, 4);
   if (status) {
@@ -53,40 +62,64 @@ void setup() {
     Serial.println("LCD khoi tao thanh cong voi hd44780");
     lcdAvailable = true;
   }
+  bootMark(BOOT_LCD);
 
-  loadSettings();
   initButtons();
   initRelays();
   initSensors();
-  connectWiFi();
-  // initialize MQTT client (will attempt connect if WiFi available)
-  mqtt_init();
-  // start network/server task pinned to core 0
+  bootMark(BOOT_IO);
+  initTelemetryQueue();
+  // load any persisted failed telemetry payloads before serverTask uses the queue
+  loadFailedQueueFromFS();
+
+  // start UI and sensor tasks first (core 1) so relays and the LCD are live
+  // without waiting for the network
+  startUITasks();
+  startControlTask();
+  startSensorTask();
+  bootMark(BOOT_TASKS);
+  DLOG(LF_BOOT_TASKS, millis());
+
+  // network/server task pinned to core 0; it joins WiFi and MQTT itself
   xTaskCreatePinnedToCore(
     serverTask,
     "ServerTask",
-    12288,
+    STACK_SERVER_TASK,
     NULL,
     1,
     &serverTaskHandle,
     0   // core 0
   );
-
-  // init telemetry queue and start watchdog task on core 0
-  initTelemetryQueue();
-  xTaskCreatePinnedToCore(watchdogTask, "WatchdogTask", 4096, NULL, 4, NULL, 0);
-  // load any persisted failed telemetry payloads
-  loadFailedQueueFromFS();
-
-  // start UI and sensor tasks (they run on core 1)
-  startUITasks();
-  startSensorTask();
+  // watchdog task on core 0
+  xTaskCreatePinnedToCore(watchdogTask, "WatchdogTask", STACK_WATCHDOG_TASK, NULL, 4, NULL, 0);
 }
 
 void serverTask(void *param) {
+  // WiFi join (up to ~15 s) and MQTT connect happen here, in the background
+  connectWiFi();
+  // initialize MQTT client (will attempt connect if WiFi available)
+  mqtt_init();
   uint32_t req;
+  unsigned long lastWiFiCheck = millis();
+  bool wasConnected = (WiFi.status() == WL_CONNECTED);
   while (1) {
+    taskLoopHead(MON_SERVER);
     feedWatchdog();
+    // Retry WiFi mỗi 30 giây nếu mất kết nối
+    if (millis() - lastWiFiCheck > 30000) {
+      if (WiFi.status() != WL_CONNECTED) {
+        Serial.println("WiFi mat ket noi, thu lai...");
+        metricsInc(metrics.wifiReconnects);
+        WiFi.disconnect(true);
+        delay(1000);
+        connectWiFi();
+      }
+      lastWiFiCheck = millis();
+    }
+    // the core may rejoin on its own, possibly with a new DHCP lease
+    bool connected = (WiFi.status() == WL_CONNECTED);
+    if (connected && !wasConnected) refreshNetIdentity();
+    wasConnected = connected;
     // wait for telemetry requests (1s timeout) and process when arrived
     if (telemetryQueue && xQueueReceive(telemetryQueue, &req, pdMS_TO_TICKS(1000)) == pdPASS) {
       // mark pending; serverTask will honor throttle and send when allowed
@@ -102,6 +135,10 @@ void serverTask(void *param) {
       lastTelemetrySent = millis();
       telemetryPending = false;
     }
+    // a finished burst capture goes up as one POST
+    uploadBurstCapture();
+    // queued alerts, one per pass so telemetry and MQTT keep running
+    alertsDeliver();
     // If OTA was requested by server response, perform it here so download runs in serverTask context
     // Only call performOTA when a request flag is set to avoid noisy polling logs
     if (otaRequested) performOTA();
@@ -110,20 +147,15 @@ void serverTask(void *param) {
 }
 
 void loop() {
-  // Main loop now minimal - perform light housekeeping such as NTP and WiFi retry
+  // Main loop now minimal - perform light housekeeping such as NTP (WiFi retry lives in serverTask)
   feedWatchdog();
   unsigned long now = millis();
 
-  // Retry WiFi mỗi 30 giây nếu mất kết nối
-  static unsigned long lastWiFiCheck = 0;
-  if (now - lastWiFiCheck > 30000) {
-    if (WiFi.status() != WL_CONNECTED) {
-      Serial.println("WiFi mat ket noi, thu lai...");
-      WiFi.disconnect(true);
-      delay(1000);
-      connectWiFi();
+  // 'T' on the serial console dumps the trace buffer
+  if (Serial.available() && Serial.read() == 'T') {
+    if (!traceDump([](const char* data, size_t len) { Serial.write((const uint8_t*)data, len); })) {
+      Serial.println("[TRACE] dump already running");
     }
-    lastWiFiCheck = now;
   }
 
   // NTP handling remains here
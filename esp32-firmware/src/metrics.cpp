@@ -0,0 +1,136 @@
+// metrics.cpp
+#include "config.h"
+#include "metrics.h"
+#include "wifi_server.h"
+#include <stdarg.h>
+
+// network round trips (HTTP POST, MQTT publish/connect): 10 ms .. 10 s
+static const uint32_t NET_BOUNDS_US[METRICS_BUCKETS] = {
+  10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000
+};
+// local work (sensor read, EEPROM commit): 1 ms .. 1 s
+static const uint32_t LOCAL_BOUNDS_US[METRICS_BUCKETS] = {
+  1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000
+};
+
+Metrics metrics = {
+  {NET_BOUNDS_US}, {0},
+  {NET_BOUNDS_US}, 0,
+  {NET_BOUNDS_US}, 0,
+  {LOCAL_BOUNDS_US},
+  {LOCAL_BOUNDS_US},
+  0
+};
+
+// updated from serverTask (core 0) and sensor/UI tasks (core 1)
+static portMUX_TYPE metricsMux = portMUX_INITIALIZER_UNLOCKED;
+
+void metricsObserve(LatencyHistogram& h, uint32_t us) {
+  uint8_t i = 0;
+  while (i < METRICS_BUCKETS && us > h.bounds[i]) i++;
+  portENTER_CRITICAL(&metricsMux);
+  h.counts[i]++;
+  h.count++;
+  h.sumUs += us;
+  portEXIT_CRITICAL(&metricsMux);
+}
+
+void metricsInc(uint32_t& counter) {
+  portENTER_CRITICAL(&metricsMux);
+  counter++;
+  portEXIT_CRITICAL(&metricsMux);
+}
+
+void metricsCountHttpResult(int code) {
+  int cls = HTTP_RESULT_ERROR;
+  if (code >= 200 && code < 600) cls = HTTP_RESULT_2XX + (code / 100 - 2);
+  metricsInc(metrics.httpPostResults[cls]);
+}
+
+// ---- exposition ----
+// Output is buffered in a small chunk and flushed with sendContent so the
+// full text (~4 KB) never sits in RAM or on the serverTask stack.
+static WebServer* outServer = NULL;
+static char outBuf[256];
+static size_t outLen = 0;
+
+static void outFlush() {
+  if (outLen) outServer->sendContent(outBuf, outLen);
+  outLen = 0;
+}
+
+// each call must stay under one chunk (256 bytes)
+static void outf(const char* fmt, ...) {
+  for (int pass = 0; pass < 2; pass++) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(outBuf + outLen, sizeof(outBuf) - outLen, fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if (outLen + n < sizeof(outBuf)) {
+      outLen += n;
+      return;
+    }
+    outFlush();  // did not fit: retry into an empty buffer
+  }
+  outLen = sizeof(outBuf) - 1;
+}
+
+static void writeHistogram(const char* name, const char* help, const LatencyHistogram& h) {
+  outf("# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+  uint32_t cumulative = 0;
+  for (uint8_t i = 0; i < METRICS_BUCKETS; i++) {
+    cumulative += h.counts[i];
+    outf("%s_bucket{le=\"%g\"} %u\n", name, h.bounds[i] / 1e6, cumulative);
+  }
+  outf("%s_bucket{le=\"+Inf\"} %u\n", name, h.count);
+  outf("%s_sum %.6f\n%s_count %u\n", name, h.sumUs / 1e6, name, h.count);
+}
+
+static void writeCounter(const char* name, const char* help, uint32_t value) {
+  outf("# HELP %s %s\n# TYPE %s counter\n%s %u\n", name, help, name, name, value);
+}
+
+static void writeGauge(const char* name, const char* help, uint32_t value) {
+  outf("# HELP %s %s\n# TYPE %s gauge\n%s %u\n", name, help, name, name, value);
+}
+
+void metricsHandleRequest(WebServer& server) {
+  // consistent snapshot; rendering happens outside the critical section
+  Metrics m;
+  portENTER_CRITICAL(&metricsMux);
+  m = metrics;
+  portEXIT_CRITICAL(&metricsMux);
+
+  outServer = &server;
+  outLen = 0;
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/plain; version=0.0.4", "");
+
+  writeHistogram("smartfarm_http_post_duration_seconds", "Telemetry POST latency per attempt", m.httpPost);
+  static const char* const classes[HTTP_RESULT_CLASSES] = {"2xx", "3xx", "4xx", "5xx", "error"};
+  outf("# HELP smartfarm_http_post_results_total Telemetry POST results by status class\n"
+       "# TYPE smartfarm_http_post_results_total counter\n");
+  for (int i = 0; i < HTTP_RESULT_CLASSES; i++) {
+    outf("smartfarm_http_post_results_total{class=\"%s\"} %u\n", classes[i], m.httpPostResults[i]);
+  }
+  writeHistogram("smartfarm_mqtt_publish_duration_seconds", "MQTT publish latency", m.mqttPublish);
+  writeCounter("smartfarm_mqtt_publish_failures_total", "MQTT publishes rejected by the client", m.mqttPublishFailed);
+  writeHistogram("smartfarm_mqtt_connect_duration_seconds", "MQTT connect latency", m.mqttConnect);
+  writeCounter("smartfarm_mqtt_connect_failures_total", "Failed MQTT connect attempts", m.mqttConnectFailed);
+  writeHistogram("smartfarm_read_sensors_duration_seconds", "readSensors() duration", m.readSensors);
+  writeHistogram("smartfarm_eeprom_commit_duration_seconds", "EEPROM commit duration", m.eepromCommit);
+  writeCounter("smartfarm_wifi_reconnects_total", "WiFi reconnect attempts after a lost link", m.wifiReconnects);
+  writeCounter("smartfarm_dht_checksum_errors_total", "DHT frames with a bad checksum", m.dhtChecksumErrors);
+  writeCounter("smartfarm_dht_timeouts_total", "DHT reads with no or a truncated reply", m.dhtTimeouts);
+  writeCounter("smartfarm_alerts_sent_total", "Alerts delivered over MQTT or HTTP", m.alertsSent);
+  writeCounter("smartfarm_alerts_dropped_total", "Alerts rate limited, evicted or undeliverable", m.alertsDropped);
+  writeGauge("smartfarm_telemetry_queue_depth", "Pending telemetry requests",
+             telemetryQueue ? (uint32_t)uxQueueMessagesWaiting(telemetryQueue) : 0);
+  writeGauge("smartfarm_failed_payload_queue", "Payloads waiting for retry", (uint32_t)failedPayloadCount());
+  writeGauge("smartfarm_free_heap_bytes", "Free heap", (uint32_t)ESP.getFreeHeap());
+  writeGauge("smartfarm_uptime_seconds", "Seconds since boot", (uint32_t)(millis() / 1000));
+  outFlush();
+  server.sendContent("", 0);  // terminating chunk
+  outServer = NULL;
+}
@@ -0,0 +1,53 @@
+// metrics.h
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "config.h"
+#include <WebServer.h>
+
+#define METRICS_BUCKETS 10
+
+// Fixed-bucket latency histogram; bounds are in microseconds and the last
+// slot of counts is the +Inf bucket
+struct LatencyHistogram {
+  const uint32_t* bounds;
+  uint32_t counts[METRICS_BUCKETS + 1];
+  uint32_t count;
+  uint64_t sumUs;
+};
+
+enum HttpResultClass {
+  HTTP_RESULT_2XX,
+  HTTP_RESULT_3XX,
+  HTTP_RESULT_4XX,
+  HTTP_RESULT_5XX,
+  HTTP_RESULT_ERROR,  // negative HTTPC_ERROR_* (transport failures)
+  HTTP_RESULT_CLASSES
+};
+
+struct Metrics {
+  LatencyHistogram httpPost;
+  uint32_t httpPostResults[HTTP_RESULT_CLASSES];
+  LatencyHistogram mqttPublish;
+  uint32_t mqttPublishFailed;
+  LatencyHistogram mqttConnect;
+  uint32_t mqttConnectFailed;
+  LatencyHistogram readSensors;
+  LatencyHistogram eepromCommit;
+  uint32_t wifiReconnects;
+  uint32_t dhtChecksumErrors;
+  uint32_t dhtTimeouts;  // no reply, or a frame cut short
+  uint32_t alertsSent;
+  uint32_t alertsDropped;  // rate limited, evicted or undeliverable
+};
+extern Metrics metrics;
+
+// record one sample (microseconds) / bump one counter; safe from any task
+void metricsObserve(LatencyHistogram& h, uint32_t us);
+void metricsInc(uint32_t& counter);
+void metricsCountHttpResult(int code);
+
+// GET /metrics: Prometheus text exposition, streamed in small chunks
+void metricsHandleRequest(WebServer& server);
+
+#endif
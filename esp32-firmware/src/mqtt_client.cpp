@@ -5,6 +5,14 @@
 #include "lcd_menu.h"
 #include "sensors.h"
 #include "wifi_server.h"
+#include "metrics.h"
+#include "trace.h"
+#include "deferred_log.h"
+#include "boot_timeline.h"
+#include "sensor_power.h"
+#include "sensor_stats.h"
+#include "burst_capture.h"
+#include "alerts.h"
 #include <PubSubClient.h>
 #include <WiFi.h>
 #include <WiFiClientSecure.h>
@@ -15,9 +23,13 @@ static WiFiClient wifiClient;
 static WiFiClientSecure wifiClientSecure;
 static PubSubClient mqttClient(wifiClient);
 
-static String topicConfig;
-static String topicTelemetry;
-static String topicHeartbeat;
+// "devices/<id>/..." topics, formatted once per connect attempt
+static char topicConfig[48];
+static char topicTelemetry[48];
+static char topicHeartbeat[48];
+static char topicStatus[48];
+static char topicStats[48];
+static char topicAlert[48];
 
 void applyConfigFromJson(JsonObjectConst obj) {
   // If user is actively editing thresholds on-device, avoid applying remote
@@ -72,6 +84,12 @@ void applyConfigFromJson(JsonObjectConst obj) {
       }
     }
   }
+  if (obj.containsKey("filters")) applyFilterConfig(obj["filters"].as<JsonObjectConst>());
+  if (obj.containsKey("sampling")) applySamplingConfig(obj["sampling"].as<JsonObjectConst>());
+  if (obj.containsKey("stats")) applyStatsConfig(obj["stats"].as<JsonObjectConst>());
+  if (obj.containsKey("burst")) applyBurstConfig(obj["burst"].as<JsonObjectConst>());
+  if (obj.containsKey("rules")) applyRuleConfig(obj["rules"].as<JsonArrayConst>());
+  if (obj.containsKey("alerts")) applyAlertConfig(obj["alerts"].as<JsonArrayConst>());
   // persist and apply
   saveSettingsNow();
   // Apply manual relay commands from MQTT payload (mirror HTTP /apply_config behavior)
@@ -90,13 +108,22 @@ void applyConfigFromJson(JsonObjectConst obj) {
     if (!settings.lightAuto) { state.lightOn = l; digitalWrite(RELAY_LIGHT, state.lightOn); }
     else Serial.println("[MQTT] Ignoring remote light command because lightAuto is enabled");
   }
-  controlRelays();
+  controlNotifyConfig();
   // Request UI refresh only if main screen active; otherwise mark for refresh
   if (menuState == MAIN_SCREEN) drawMainScreen(); else needMainRefresh = true;
   // notify backend immediately so web reflects new values
   requestTelemetrySend();
 }
 
+// publish and record latency/failures for /metrics
+static bool mqttPublish(const char* topic, const uint8_t* payload, size_t len, bool retained = false) {
+  uint32_t t0 = micros();
+  bool ok = mqttClient.publish(topic, payload, len, retained);
+  metricsObserve(metrics.mqttPublish, micros() - t0);
+  if (!ok) metricsInc(metrics.mqttPublishFailed);
+  return ok;
+}
+
 static void mqttCallback(char* topic, byte* payload, unsigned int length) {
   // parse JSON payload
   StaticJsonDocument<2048> doc;
@@ -106,39 +133,47 @@ static void mqttCallback(char* topic, byte* payload, unsigned int length) {
     return;
   }
   JsonObject obj = doc.as<JsonObject>();
-  Serial.println("[MQTT] config message received");
+  DLOG(LF_MQTT_CONFIG);
   applyConfigFromJson(obj);
 }
 
 static bool mqttConnect() {
   if (mqttClient.connected()) return true;
   mqttClient.setCallback(mqttCallback);
-  String clientId = String(settings.deviceID) + "-" + String((uint32_t)ESP.getEfuseMac());
+  char clientId[40];
+  snprintf(clientId, sizeof(clientId), "%s-%u", settings.deviceID, (uint32_t)ESP.getEfuseMac());
+  snprintf(topicConfig, sizeof(topicConfig), "devices/%s/config", settings.deviceID);
+  snprintf(topicTelemetry, sizeof(topicTelemetry), "devices/%s/telemetry", settings.deviceID);
+  snprintf(topicHeartbeat, sizeof(topicHeartbeat), "devices/%s/heartbeat", settings.deviceID);
+  snprintf(topicStatus, sizeof(topicStatus), "devices/%s/status", settings.deviceID);
+  snprintf(topicStats, sizeof(topicStats), "devices/%s/stats", settings.deviceID);
+  snprintf(topicAlert, sizeof(topicAlert), "devices/%s/alert", settings.deviceID);
   bool ok = false;
   const char* broker = settings.mqttBroker[0] ? settings.mqttBroker : MQTT_BROKER;
   uint16_t port = settings.mqttPort ? settings.mqttPort : MQTT_PORT;
   const char* user = settings.mqttUser[0] ? settings.mqttUser : MQTT_USER;
   const char* pass = settings.mqttPass[0] ? settings.mqttPass : MQTT_PASS;
   mqttClient.setServer(broker, port);
+  uint32_t t0 = micros();
   if (user && strlen(user) > 0) {
-    ok = mqttClient.connect(clientId.c_str(), user, pass, (String("devices/") + settings.deviceID + "/status").c_str(), 1, true, "offline");
+    ok = mqttClient.connect(clientId, user, pass, topicStatus, 1, true, "offline");
   } else {
-    ok = mqttClient.connect(clientId.c_str());
+    ok = mqttClient.connect(clientId);
   }
+  metricsObserve(metrics.mqttConnect, micros() - t0);
+  if (!ok) metricsInc(metrics.mqttConnectFailed);
     if (ok) {
-    Serial.println("[MQTT] connected");
-    topicConfig = String("devices/") + settings.deviceID + "/config";
-    topicTelemetry = String("devices/") + settings.deviceID + "/telemetry";
-    topicHeartbeat = String("devices/") + settings.deviceID + "/heartbeat";
-    mqttClient.subscribe(topicConfig.c_str());
+    DLOG(LF_MQTT_CONNECTED);
+    bootMark(BOOT_MQTT);
+    mqttClient.subscribe(topicConfig);
     // publish online status retained
     StaticJsonDocument<128> s;
     s["online"] = true;
     char buf[128]; size_t n = serializeJson(s, buf);
-    mqttClient.publish((String("devices/") + settings.deviceID + "/status").c_str(), (const uint8_t*)buf, n, true);
+    mqttPublish(topicStatus, (const uint8_t*)buf, n, true);
     return true;
   } else {
-    Serial.println("[MQTT] connect failed");
+    DLOG(LF_MQTT_CONNECT_FAILED);
     return false;
   }
 }
@@ -155,11 +190,14 @@ void mqtt_init() {
   } else {
     mqttClient.setClient(wifiClient);
   }
+  // telemetry and stats messages are larger than the library's 256-byte default
+  mqttClient.setBufferSize(1024);
   mqttClient.setServer(broker, port);
   mqttConnect();
 }
 
 void mqtt_loop() {
+  TRACE_SPAN("mqtt_loop");
   if (!mqttClient.connected()) {
     mqttConnect();
   }
@@ -171,42 +209,61 @@ void mqtt_loop() {
     mqtt_publishHeartbeat();
     lastHeartbeatMs = now;
   }
+  mqtt_publishStats();
 }
 
 void mqtt_publishTelemetry() {
   if (!mqttClient.connected()) return;
   StaticJsonDocument<512> doc;
-  doc["id"] = settings.deviceID;
-  doc["temp"] = state.temp;
-  doc["hum"] = state.hum;
-  doc["soil1"] = state.soil1;
-  doc["soil2"] = state.soil2;
-  doc["light"] = state.light;
-  doc["ph"] = state.ph;
-  doc["ip"] = WiFi.localIP().toString();
-  doc["mac"] = WiFi.macAddress();
+  SensorSnapshot snap;
+  snapshotSensorState(&snap);
+  doc["id"] = (const char*)settings.deviceID;
+  sensorsToJson(doc.as<JsonObject>(), snap.values);
+  doc["ip"] = (const char*)deviceIP;
+  doc["mac"] = (const char*)deviceMAC;
   doc["fw"] = FIRMWARE_VERSION;
   doc["freeHeap"] = (unsigned)ESP.getFreeHeap();
   doc["uptimeMs"] = millis();
+  sensorPowerToJson(doc.as<JsonObject>());
   doc["pumpAuto"] = settings.pumpAuto;
   doc["fanAuto"] = settings.fanAuto;
   doc["lightAuto"] = settings.lightAuto;
   doc["relay_override"] = settings.relayOverride;
   char buf[512]; size_t n = serializeJson(doc, buf);
-  mqttClient.publish(topicTelemetry.c_str(), (const uint8_t*)buf, n);
+  mqttPublish(topicTelemetry, (const uint8_t*)buf, n);
+}
+
+void mqtt_publishStats() {
+  static uint32_t sent[STATS_WINDOW_COUNT];
+  if (!mqttClient.connected()) return;
+  for (uint8_t w = 0; w < STATS_WINDOW_COUNT; w++) {
+    uint32_t closed = statsClosed(w);
+    if (closed == sent[w]) continue;
+    StaticJsonDocument<1024> doc;
+    doc["id"] = (const char*)settings.deviceID;
+    statsWindowToJson(doc.as<JsonObject>(), w);
+    char buf[640]; size_t n = serializeJson(doc, buf);
+    mqttPublish(topicStats, (const uint8_t*)buf, n);
+    sent[w] = closed;
+  }
+}
+
+bool mqtt_publishAlert(const char* payload, size_t len) {
+  if (!mqttClient.connected()) return false;
+  return mqttPublish(topicAlert, (const uint8_t*)payload, len);
 }
 
 void mqtt_publishHeartbeat() {
   if (!mqttClient.connected()) return;
   StaticJsonDocument<256> doc;
-  doc["id"] = settings.deviceID;
+  doc["id"] = (const char*)settings.deviceID;
   // use NTP epoch if available, otherwise millis-based seconds
   if (ntpSynced) doc["ts"] = (uint32_t)timeClient.getEpochTime();
   else doc["ts"] = (uint32_t)(millis() / 1000UL);
-  doc["ip"] = WiFi.localIP().toString();
-  doc["mac"] = WiFi.macAddress();
+  doc["ip"] = (const char*)deviceIP;
+  doc["mac"] = (const char*)deviceMAC;
   doc["freeHeap"] = (unsigned)ESP.getFreeHeap();
   doc["uptimeMs"] = millis();
   char buf[256]; size_t n = serializeJson(doc, buf);
-  mqttClient.publish(topicHeartbeat.c_str(), (const uint8_t*)buf, n);
+  mqttPublish(topicHeartbeat, (const uint8_t*)buf, n);
 }
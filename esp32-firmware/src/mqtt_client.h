@@ -2,10 +2,17 @@
 #define MQTT_CLIENT_H
 
 #include <Arduino.h>
+#include <ArduinoJson.h>
 
 void mqtt_init();
 void mqtt_loop();
 void mqtt_publishTelemetry();
 void mqtt_publishHeartbeat();
+// devices/<id>/stats, once per closed statistics window (from mqtt_loop)
+void mqtt_publishStats();
+// devices/<id>/alert from the alert engine; false when not connected
+bool mqtt_publishAlert(const char* payload, size_t len);
+// Apply a config object (MQTT devices/<id>/config payload) to settings/relays
+void applyConfigFromJson(JsonObjectConst obj);
 
 #endif
@@ -1,5 +1,6 @@
 #include "ota_update.h"
 #include "config.h"
+#include "trace.h"
 #include <HTTPClient.h>
 #include <HTTPUpdate.h>
 #include <WiFi.h>
@@ -132,6 +133,7 @@ void performOTA() {
 
     size_t available = stream->available();
     if (available) {
+      TRACE_SPAN("ota_chunk");
       size_t toRead = available;
       if (toRead > buffSize) toRead = buffSize;
       int r = stream->readBytes(buff, toRead);
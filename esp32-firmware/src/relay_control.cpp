@@ -3,167 +3,386 @@
 #include "sensors.h"
 #include "relay_control.h"
 #include "wifi_server.h"
+#include "trace.h"
+#include "deferred_log.h"
+#include "boot_timeline.h"
+#include "stack_monitor.h"
+#include "burst_capture.h"
 
-unsigned long pumpStartTime = 0;
-unsigned long fanStartTime = 0;
-unsigned long lightStartTime = 0;
-// Use 10 seconds as requested for pump/fan on-duration
-const unsigned long RELAY_DURATION = 10000;   // 10 giây
-const unsigned long FAN_COOLDOWN = 30000;    // 30 giây cooldown cho quạt
-unsigned long fanCooldownEnd = 0;
-const unsigned long RELAY_MIN_TOGGLE_MS = 5000; // minimal interval between toggles for any relay
-static unsigned long lastPumpToggle = 0; 
-static unsigned long lastFanToggle = 0;
-static unsigned long lastLightToggle = 0;
+// without NTP time the schedules are looked at again this often
+#define CONTROL_NTP_POLL_MS 10000
+// a run started outside the rules (schedule, button, remote command) is not
+// released by a rule before this, the fixed run length those had before
+#define EXTERNAL_RUN_MS 10000UL
 
-void initRelays() {
-  pinMode(RELAY_PUMP, OUTPUT);
-  pinMode(RELAY_FAN, OUTPUT);
-  pinMode(RELAY_LIGHT, OUTPUT);
-  digitalWrite(RELAY_PUMP, LOW);
-  digitalWrite(RELAY_FAN, LOW);
-  digitalWrite(RELAY_LIGHT, LOW);
+struct RelayOutput {
+  const char* key;
+  uint8_t pin;
+  bool SensorState::*on;
+  bool Settings::*autoMode;  // rules only drive the relay while this is set
+};
+
+static const RelayOutput relays[RELAY_COUNT] = {
+    {"pump",  RELAY_PUMP,  &SensorState::pump,    &Settings::pumpAuto},
+    {"fan",   RELAY_FAN,   &SensorState::fan,     &Settings::fanAuto},
+    {"light", RELAY_LIGHT, &SensorState::lightOn, &Settings::lightAuto},
+};
+
+// SensorKind order
+static const char* const KIND_KEYS[] = {"temp", "hum", "soil", "light", "ph"};
+
+// A rule resolved for evaluation. Values are multiplied by sign, so every
+// rule switches on at x > threshold and off at x <= threshold - band.
+struct CompiledRule {
+  const float* setting;    // the kind's threshold in Settings, NULL: own
+  float own;               // the rule's threshold, copied at compile time
+  float sign;
+  float band;
+  uint8_t channels;        // sensorChannels rows averaged, bit per SensorId
+  uint8_t relay;
+  uint32_t minOnMs;
+  uint32_t minOffMs;
+  uint32_t maxRunMs;
+  uint32_t cooldownMs;
+};
+
+static CompiledRule table[MAX_RULES];
+static uint8_t tableSize = 0;
+// settings.rules is replaced whole under rulesMux (serverTask) and copied out
+// under it by compileRules(), so neither side sees a half-written rule. The
+// control task recompiles before evaluating once rulesChanged is set.
+static portMUX_TYPE rulesMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool rulesChanged = true;
+static bool latched[MAX_RULES];
+static unsigned long coolUntil[MAX_RULES];
+static unsigned long ruleDue[MAX_RULES];  // next timer deadline, see ruleDeadline()
+static bool hasDue[MAX_RULES];
+
+// events for the control task: sensors with new readings (0xFF: everything)
+static SemaphoreHandle_t controlWake = NULL;
+static uint8_t pendingSensors = 0;
+// sensors the sensor task has delivered a reading for; sensorValues holds
+// placeholders (0) before that, which must not switch anything at boot
+static uint8_t sampledSensors = 0;
+static portMUX_TYPE controlMux = portMUX_INITIALIZER_UNLOCKED;
+
+// relay states as the engine last saw them
+static bool relayOn[RELAY_COUNT];
+static bool relayToggled[RELAY_COUNT];  // switched at least once since boot
+static unsigned long relaySince[RELAY_COUNT];
+static bool relayExternal[RELAY_COUNT];  // the current run was started elsewhere
+
+static const RelayRule DEFAULT_RULES[] = {
+    // relay          kind        zone cmp         threshold band  minOn minOff maxRun cooldown
+    {RELAY_ID_PUMP,  KIND_SOIL,  0,   RULE_BELOW, NAN,      5.0f, 5,    5,     10,    0},
+    {RELAY_ID_FAN,   KIND_TEMP,  0,   RULE_ABOVE, NAN,      1.0f, 5,    5,     10,    30},
+    {RELAY_ID_LIGHT, KIND_LIGHT, 0,   RULE_BELOW, NAN,      5.0f, 5,    5,     0,     0},
+};
+
+static void publishRules(const RelayRule* rules, uint8_t n) {
+  portENTER_CRITICAL(&rulesMux);
+  memcpy(settings.rules, rules, n * sizeof(RelayRule));
+  settings.numRules = n;
+  rulesChanged = true;
+  portEXIT_CRITICAL(&rulesMux);
 }
 
-void controlRelays() {
-  unsigned long now = millis();
-  static unsigned long lastAlert = 0;
-  if (millis() - lastAlert > 60000) {lastAlert = millis();}
-
-  // Snapshot previous relay states to detect changes
-  bool prevPump = state.pump;
-  bool prevFan = state.fan;
-  bool prevLight = state.lightOn;
-
-  // Bơm (auto hoặc manual).
-  // Use average of two soil sensors for decision when in auto mode.
-  float avgSoil = ((state.soil1 + state.soil2) / 2.0);
-  bool needPump = (!settings.relayOverride) && settings.pumpAuto && (avgSoil < settings.soilThresh);
-  // Turn on pump when auto needs it (respect minimal toggle interval)
-  if (needPump && !state.pump) {
-    if (now - lastPumpToggle >= RELAY_MIN_TOGGLE_MS) {
-      state.pump = true;
-      digitalWrite(RELAY_PUMP, HIGH);
-      lastPumpToggle = now;
-      pumpStartTime = now;
+void defaultRelayRules() {
+  publishRules(DEFAULT_RULES, sizeof(DEFAULT_RULES) / sizeof(DEFAULT_RULES[0]));
+}
+
+static int keyIndex(const char* key, const char* const* keys, uint8_t n) {
+  for (uint8_t i = 0; key && i < n; i++) {
+    if (strcmp(key, keys[i]) == 0) return i;
+  }
+  return -1;
+}
+
+void applyRuleConfig(JsonArrayConst arr) {
+  const char* relayKeys[RELAY_COUNT];
+  for (uint8_t r = 0; r < RELAY_COUNT; r++) relayKeys[r] = relays[r].key;
+  RelayRule rules[MAX_RULES];
+  uint8_t n = 0;
+  for (JsonObjectConst o : arr) {
+    if (n >= MAX_RULES) break;
+    int relay = keyIndex(o["relay"].as<const char*>(), relayKeys, RELAY_COUNT);
+    int kind = keyIndex(o["sensor"].as<const char*>(), KIND_KEYS, sizeof(KIND_KEYS) / sizeof(KIND_KEYS[0]));
+    if (relay < 0 || kind < 0) {
+      Serial.printf("[RULES] rule %u: unknown relay or sensor, skipped\n", n);
+      continue;
     }
+    RelayRule& r = rules[n++];
+    r.relay = relay;
+    r.kind = kind;
+    r.zone = o["zone"].as<uint8_t>();
+    const char* cmp = o["cmp"].as<const char*>();
+    r.cmp = cmp && strcmp(cmp, ">") == 0 ? RULE_ABOVE : RULE_BELOW;
+    r.threshold = o.containsKey("threshold") && !o["threshold"].isNull() ? o["threshold"].as<float>() : NAN;
+    r.band = fabsf(o["band"].as<float>());
+    // seconds; missing keys read as 0 (no limit)
+    r.minOnSec = constrain(o["minOn"].as<long>(), 0L, 65535L);
+    r.minOffSec = constrain(o["minOff"].as<long>(), 0L, 65535L);
+    r.maxRunSec = constrain(o["maxRun"].as<long>(), 0L, 65535L);
+    r.cooldownSec = constrain(o["cooldown"].as<long>(), 0L, 65535L);
   }
-  // Auto-off pump after RELAY_DURATION when in auto mode
-  if (settings.pumpAuto && state.pump && pumpStartTime != 0 && now - pumpStartTime >= RELAY_DURATION) {
-    if (now - lastPumpToggle >= RELAY_MIN_TOGGLE_MS) {
-      state.pump = false;
-      digitalWrite(RELAY_PUMP, LOW);
-      lastPumpToggle = now;
+  publishRules(rules, n);
+  Serial.printf("[RULES] %u rule(s)\n", n);
+}
+
+static void compileRules() {
+  RelayRule rules[MAX_RULES];
+  portENTER_CRITICAL(&rulesMux);
+  uint8_t n = settings.numRules < MAX_RULES ? settings.numRules : MAX_RULES;
+  memcpy(rules, settings.rules, n * sizeof(RelayRule));
+  rulesChanged = false;
+  portEXIT_CRITICAL(&rulesMux);
+
+  tableSize = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    const RelayRule& r = rules[i];
+    if (r.relay >= RELAY_COUNT || r.kind > KIND_PH) continue;
+    CompiledRule& c = table[tableSize];
+    c.channels = 0;
+    for (uint8_t s = 0; s < SENSOR_COUNT; s++) {
+      if (sensorChannels[s].kind == r.kind && sensorChannels[s].zone == r.zone) c.channels |= 1u << s;
     }
-    pumpStartTime = 0;
+    if (!c.channels) continue;
+    c.setting = isnan(r.threshold) ? sensorThresholdRef((SensorKind)r.kind) : NULL;
+    c.own = r.threshold;
+    c.sign = r.cmp == RULE_ABOVE ? 1.0f : -1.0f;
+    c.band = r.band > 0 ? r.band : 0;
+    c.relay = r.relay;
+    c.minOnMs = r.minOnSec * 1000UL;
+    c.minOffMs = r.minOffSec * 1000UL;
+    c.maxRunMs = r.maxRunSec * 1000UL;
+    c.cooldownMs = r.cooldownSec * 1000UL;
+    // a relay already on keeps its new rules latched
+    latched[tableSize] = relayOn[r.relay];
+    coolUntil[tableSize] = 0;
+    tableSize++;
   }
+}
 
-  // If pump state changed, notify server immediately and log
-  if (state.pump != prevPump) {
-    Serial.printf("[RELAY] pump -> %s\n", state.pump ? "ON" : "OFF");
-    requestTelemetrySend();
+static void logRelay(uint8_t relay, bool on) {
+  switch (relay) {
+    case RELAY_ID_PUMP: DLOG(LF_RELAY_PUMP, on ? "ON" : "OFF"); break;
+    case RELAY_ID_FAN: DLOG(LF_RELAY_FAN, on ? "ON" : "OFF"); break;
+    default: DLOG(LF_RELAY_LIGHT, on ? "ON" : "OFF"); break;
   }
+}
 
-  bool needFan = (!settings.relayOverride) && settings.fanAuto && (state.temp > settings.tempThresh);
-  // Turn on fan when needed (respect cooldown and minimal toggle interval)
-  if (needFan && !state.fan && now > fanCooldownEnd) {
-    if (now - lastFanToggle >= RELAY_MIN_TOGGLE_MS) {
-      state.fan = true;
-      digitalWrite(RELAY_FAN, HIGH);
-      lastFanToggle = now;
-      fanStartTime = now;
-    }
+void initRelays() {
+  for (uint8_t r = 0; r < RELAY_COUNT; r++) {
+    pinMode(relays[r].pin, OUTPUT);
+    digitalWrite(relays[r].pin, LOW);
   }
-  // Auto-off fan after RELAY_DURATION when in auto mode
-  if (settings.fanAuto && state.fan && fanStartTime != 0 && now - fanStartTime >= RELAY_DURATION) {
-    if (now - lastFanToggle >= RELAY_MIN_TOGGLE_MS) {
-      state.fan = false;
-      digitalWrite(RELAY_FAN, LOW);
-      lastFanToggle = now;
+}
+
+// the sensor task samples soil faster while watering, and may start a burst
+static void pumpSwitched(bool on) {
+  if (on && settings.burst.onPump) burstTrigger(BURST_TRIG_PUMP);
+  wakeSensorTask();
+}
+
+static float ruleThreshold(const CompiledRule& c) { return c.sign * (c.setting ? *c.setting : c.own); }
+
+// sign * zone average of the rule's channels, NAN without a reading
+static float ruleInput(const CompiledRule& c, const float* values) {
+  float sum = 0;
+  uint8_t n = 0;
+  for (uint8_t s = 0; s < SENSOR_COUNT; s++) {
+    if ((c.channels & (1u << s)) && !isnan(values[s])) {
+      sum += values[s];
+      n++;
     }
-    fanStartTime = 0;
-    fanCooldownEnd = now + FAN_COOLDOWN;
   }
+  return n ? c.sign * sum / n : NAN;
+}
 
-  if (state.fan != prevFan) {
-    Serial.printf("[RELAY] fan -> %s\n", state.fan ? "ON" : "OFF");
-    requestTelemetrySend();
+static uint32_t ruleMinOn(const CompiledRule& c) {
+  return relayExternal[c.relay] && c.minOnMs < EXTERNAL_RUN_MS ? EXTERNAL_RUN_MS : c.minOnMs;
+}
+
+// When rule i next changes without a new reading: maxRun, a release held
+// back by minOn, or a switch-on held back by minOff / cooldown
+static void ruleDeadline(uint8_t i, float x, unsigned long now) {
+  const CompiledRule& c = table[i];
+  float t = ruleThreshold(c);
+  unsigned long since = relaySince[c.relay];
+  bool on = relayOn[c.relay];
+  uint32_t best = UINT32_MAX;
+  auto consider = [&](unsigned long at) {
+    long left = (long)(at - now);
+    if (left > 0 && (uint32_t)left < best) best = left;
+  };
+  if (latched[i]) {
+    if (on && c.maxRunMs) consider(since + c.maxRunMs);
+    if (on && x <= t - c.band) consider(since + ruleMinOn(c));
+  } else if (x > t && !settings.relayOverride) {
+    consider(coolUntil[i]);
+    if (!on && relayToggled[c.relay]) consider(since + c.minOffMs);
   }
+  ruleDue[i] = best == UINT32_MAX ? 0 : now + best;
+  hasDue[i] = best != UINT32_MAX;
+}
 
-  // Light auto control
-  bool needLight = (!settings.relayOverride) && settings.lightAuto && (state.light < settings.lightThresh);
-  if (needLight && !state.lightOn) {
-    // allow immediate turn-ON for light (no minimal toggle cooldown when turning on)
-    state.lightOn = true;
-    digitalWrite(RELAY_LIGHT, HIGH);
-    lastLightToggle = now;
-    lightStartTime = now;
+uint32_t evaluateRules(const float* values, uint8_t sensorMask, unsigned long now) {
+  uint8_t relayDirty = 0;  // bit per RelayId: every rule of the relay runs
+  if (rulesChanged) {
+    compileRules();
+    sensorMask = 0xFF;
   }
-  // Auto-off light: prefer turning off only when a NEW sensor measurement exceeds threshold
-  if (settings.lightAuto && state.lightOn) {
-    // If we have a new light measurement taken after the light was started
-    if (lastLightMeasured > lightStartTime && state.light > settings.lightThresh) {
-      if (now - lastLightToggle >= RELAY_MIN_TOGGLE_MS) {
-        state.lightOn = false;
-        digitalWrite(RELAY_LIGHT, LOW);
-        lastLightToggle = now;
-      }
-      lightStartTime = 0;
-    } else if (lightStartTime != 0 && now - lightStartTime >= RELAY_DURATION) {
-      // fallback: if duration elapsed without a new crossing, still allow auto-off
-      if (now - lastLightToggle >= RELAY_MIN_TOGGLE_MS) {
-        state.lightOn = false;
-        digitalWrite(RELAY_LIGHT, LOW);
-        lastLightToggle = now;
+  // relays switched elsewhere (buttons, schedules, remote commands): their
+  // rules follow, so an automatic relay turned on still gets its maxRun
+  for (uint8_t r = 0; r < RELAY_COUNT; r++) {
+    bool on = state.*relays[r].on;
+    if (on == relayOn[r]) continue;
+    relayOn[r] = on;
+    relaySince[r] = now;
+    relayToggled[r] = true;
+    relayExternal[r] = on;
+    relayDirty |= 1u << r;
+    if (r == RELAY_ID_PUMP) pumpSwitched(on);
+    for (uint8_t i = 0; i < tableSize; i++) {
+      if (table[i].relay == r) latched[i] = on;
+    }
+  }
+
+  // only the rules a reading, a relay change or an expired timer touches
+  uint8_t driven = 0, want = 0;  // bit per RelayId
+  uint8_t evaluated = 0;         // bit per rule
+  float input[MAX_RULES];
+  for (uint8_t i = 0; i < tableSize; i++) {
+    const CompiledRule& c = table[i];
+    if (!(settings.*relays[c.relay].autoMode)) continue;
+    driven |= 1u << c.relay;
+    if ((c.channels & sensorMask) || (relayDirty & (1u << c.relay)) ||
+        (hasDue[i] && (long)(now - ruleDue[i]) >= 0)) {
+      evaluated |= 1u << i;
+      bool on = relayOn[c.relay];
+      uint32_t held = now - relaySince[c.relay];
+      float x = input[i] = ruleInput(c, values);
+      float t = ruleThreshold(c);
+      if (!latched[i]) {
+        latched[i] = !settings.relayOverride && x > t && (long)(now - coolUntil[i]) >= 0 &&
+                     (on || !relayToggled[c.relay] || held >= c.minOffMs);
+      } else if (c.maxRunMs && on && held >= c.maxRunMs) {
+        latched[i] = false;
+        coolUntil[i] = now + c.cooldownMs;
+      } else if (x <= t - c.band && (!on || held >= ruleMinOn(c))) {
+        latched[i] = false;
       }
-      lightStartTime = 0;
     }
+    if (latched[i]) want |= 1u << c.relay;
   }
 
-  if (state.lightOn != prevLight) {
-    Serial.printf("[RELAY] light -> %s\n", state.lightOn ? "ON" : "OFF");
+  uint8_t switched = 0;
+  for (uint8_t r = 0; r < RELAY_COUNT; r++) {
+    bool on = want & (1u << r);
+    if (!(driven & (1u << r)) || on == relayOn[r]) continue;
+    state.*relays[r].on = on;
+    digitalWrite(relays[r].pin, on ? HIGH : LOW);
+    relayOn[r] = on;
+    relaySince[r] = now;
+    relayToggled[r] = true;
+    relayExternal[r] = false;
+    switched |= 1u << r;
+    logRelay(r, on);
     requestTelemetrySend();
+    if (r == RELAY_ID_PUMP) pumpSwitched(on);
   }
 
-  // Warning alert for pH out of range every 60 seconds
-  if (WiFi.status() == WL_CONNECTED &&
-      (state.ph < settings.phThreshMin || state.ph > settings.phThreshMax)) {
-
-    HTTPClient http;
-    char url[128];
-    snprintf(url, sizeof(url), "http://%s:%d/alert", SERVER_IP, SERVER_PORT);
-    http.begin(url);
-    http.addHeader("Content-Type", "application/json");
-    // close connection explicitly to avoid keep-alive reuse issues
-    http.addHeader("Connection", "close");
-    // include device token if available (backend will ignore if not required)
-    http.addHeader("X-Device-Token", settings.token);
-
-    StaticJsonDocument<256> doc;
-    doc["id"] = settings.deviceID;
-    char alertMsg[64];
-    snprintf(alertMsg, sizeof(alertMsg), "pH out of range: %.1f", state.ph);
-    doc["alert"] = alertMsg;
-
-    char payload[256];
-    size_t plen = serializeJson(doc, payload, sizeof(payload));
-    http.setTimeout(6000); // slighty larger timeout
-    int code = http.POST((uint8_t*)payload, plen);
-    feedWatchdog();
-    yield();
-    if (code <= 0) {
-      Serial.printf("[ALERT] POST failed code=%d err=%s\n", code, http.errorToString(code).c_str());
+  // deadlines of the rules that ran or whose relay just moved
+  uint32_t wait = UINT32_MAX;
+  for (uint8_t i = 0; i < tableSize; i++) {
+    const CompiledRule& c = table[i];
+    if (!(settings.*relays[c.relay].autoMode)) {
+      hasDue[i] = false;
+      continue;
+    }
+    if ((evaluated & (1u << i)) || (switched & (1u << c.relay))) {
+      ruleDeadline(i, (evaluated & (1u << i)) ? input[i] : ruleInput(c, values), now);
+    }
+    if (hasDue[i]) {
+      long left = (long)(ruleDue[i] - now);
+      uint32_t ms = left > 0 ? left : 0;
+      if (ms < wait) wait = ms;
     }
-    http.end();
   }
-  
+  return wait;
+}
+
+// Schedules fire once, at the start of their minute; ms until the next
+// minute boundary while there are any
+static uint32_t runSchedules() {
+  if (!settings.numSchedules) return UINT32_MAX;
+  if (!ntpSynced) return CONTROL_NTP_POLL_MS;
   checkSchedules();
+  return (60 - timeClient.getSeconds()) * 1000UL;
+}
+
+static uint32_t controlPass(uint8_t sensorMask) {
+  TRACE_SPAN("controlRelays");
+  uint32_t scheduleWait = runSchedules();
+  SensorSnapshot snap;
+  snapshotSensorState(&snap);
+  for (uint8_t s = 0; s < SENSOR_COUNT; s++) {
+    if (!(sampledSensors & (1u << s))) snap.values[s] = NAN;
+  }
+  uint32_t wait = evaluateRules(snap.values, sensorMask, millis());
+  publishSensorState();
+  return wait < scheduleWait ? wait : scheduleWait;
+}
+
+// host harnesses set sensorValues themselves and run passes without the task
+void controlRelays() {
+  sampledSensors = 0xFF;
+  controlPass(0xFF);
+}
+
+static void postEvent(uint8_t sensorMask) {
+  portENTER_CRITICAL(&controlMux);
+  pendingSensors |= sensorMask;
+  portEXIT_CRITICAL(&controlMux);
+  if (controlWake) xSemaphoreGive(controlWake);
+}
+
+void controlNotifySample(uint8_t sensorMask) {
+  portENTER_CRITICAL(&controlMux);
+  sampledSensors |= sensorMask;
+  portEXIT_CRITICAL(&controlMux);
+  postEvent(sensorMask);
+}
+void controlNotifyConfig() { postEvent(0xFF); }
+
+// Control task: sleeps until an event or the next rule / schedule deadline,
+// then runs the rules that event affects
+static void controlTask(void* param) {
+  stackTrackSelf(STK_CONTROL);
+  uint32_t wait = controlPass(0xFF);
+  while (1) {
+    xSemaphoreTake(controlWake, wait == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(wait));
+    portENTER_CRITICAL(&controlMux);
+    uint8_t mask = pendingSensors;
+    pendingSensors = 0;
+    portEXIT_CRITICAL(&controlMux);
+    wait = controlPass(mask);
+    if (mask) bootMark(BOOT_CONTROL);
+  }
+}
+
+void startControlTask() {
+  controlWake = xSemaphoreCreateBinary();
+  xTaskCreatePinnedToCore(controlTask, "ControlTask", STACK_CONTROL_TASK, NULL, 4, NULL, 1);
 }
 
 void checkSchedules() {
   if (!ntpSynced) return;
   uint8_t h = timeClient.getHours();
   uint8_t m = timeClient.getMinutes();
+  static int lastMinute = -1;
+  if (h * 60 + m == lastMinute) return;
+  lastMinute = h * 60 + m;
 
   for (uint8_t i = 0; i < settings.numSchedules; i++) {
     Schedule s = settings.schedules[i];
@@ -171,13 +390,12 @@ void checkSchedules() {
       if (s.forPump && !state.pump) {
         state.pump = true;
         digitalWrite(RELAY_PUMP, HIGH);
-        pumpStartTime = millis();
       }
       if (s.forLight && !state.lightOn) {
         state.lightOn = true;
         digitalWrite(RELAY_LIGHT, HIGH);
-        lightStartTime = millis();
       }
+      publishSensorState();
     }
   }
 }
\ No newline at end of file
@@ -2,8 +2,43 @@
 #ifndef RELAY_CONTROL_H
 #define RELAY_CONTROL_H
 
+#include "config.h"
+
+// Automatic relay control is a table of rules (settings.rules). A rule
+// latches on when its sensor goes past the threshold and off only once the
+// value is back past the threshold by `band`, so a reading hovering at the
+// threshold no longer toggles the relay. A relay whose auto mode is set is on
+// while any of its rules is latched. Rules are compiled into an evaluation
+// table when they change; adding one is data, not code. A relay switched on
+// elsewhere (schedule, button, remote command) latches its rules too, but
+// they do not release it for the first 10 s.
+enum RelayId : uint8_t { RELAY_ID_PUMP, RELAY_ID_FAN, RELAY_ID_LIGHT, RELAY_COUNT };
+enum RuleCmp : uint8_t { RULE_BELOW, RULE_ABOVE };
+
 void initRelays();
+// Control runs on its own task, woken by events instead of polling: new
+// readings, config changes, and the next rule timer (maxRun, minOn, minOff,
+// cooldown) or schedule minute, so a relay switches when its deadline falls.
+void startControlTask();
+// New readings of the sensors in sensorMask (bit per SensorId); only the
+// rules reading them run
+void controlNotifySample(uint8_t sensorMask);
+// Settings, rules, thresholds or relays changed elsewhere: every rule runs
+void controlNotifyConfig();
+// One full pass on the calling task (host harnesses without the task)
 void controlRelays();
 void checkSchedules();
 
-#endif
\ No newline at end of file
+// Pump on dry soil, fan on heat, light on dark (settings.rules)
+void defaultRelayRules();
+// Replace the rules from a remote "rules" array:
+// [{"relay": "pump", "sensor": "soil", "zone": 0, "cmp": "<", "threshold": 35,
+//   "band": 5, "minOn": 5, "minOff": 5, "maxRun": 10, "cooldown": 0}, ...]
+// "threshold" left out follows the sensor kind's threshold setting.
+void applyRuleConfig(JsonArrayConst arr);
+// Run the rules reading sensorMask (plus those with an expired timer or a
+// relay switched elsewhere) against values[SENSOR_COUNT]. Returns ms until
+// the next timer deadline, UINT32_MAX when none is pending.
+uint32_t evaluateRules(const float* values, uint8_t sensorMask, unsigned long nowMs);
+
+#endif
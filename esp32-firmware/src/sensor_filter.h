@@ -0,0 +1,145 @@
+// sensor_filter.h
+// Per-channel sample filters composed at compile time:
+//
+//   typedef FilterPipeline<int, FilterAdcMv<int>, FilterMedian<int, 5>, FilterMap<int>> SoilFilter;
+//   sensorValues[SENSOR_SOIL1] = soil1Filter.process(counts, settings.filters[FILTER_SOIL1]);
+//
+// Each stage is a small functor `T operator()(T x, const ChannelFilter&)`
+// plus reset() and seed(); the pipeline calls them in order and everything
+// inlines, so a channel costs only the stages it lists. Runtime parameters come from
+// Settings::filters. Oversampling happens before this (AdcTask burst mean or
+// the polled analogRead average in sampleSensors).
+#ifndef SENSOR_FILTER_H
+#define SENSOR_FILTER_H
+
+#include "config.h"
+#include "adc_calibration.h"
+
+// largest median window a stage can be built with
+#define FILTER_MEDIAN_MAX 7
+
+// ADC counts -> millivolts through the boot-time calibration table
+template <typename T>
+class FilterAdcMv {
+ public:
+  T operator()(T x, const ChannelFilter&) { return (T)adcCountsToMv(x < 0 ? 0 : (uint16_t)x); }
+  void reset() {}
+  void seed(T) {}
+};
+
+// Median of the last cfg.median samples (clamped to 1..MaxN): drops single
+// spikes that an EMA would smear over several cycles.
+template <typename T, uint8_t MaxN>
+class FilterMedian {
+ public:
+  T operator()(T x, const ChannelFilter& cfg) {
+    uint8_t n = cfg.median < 1 ? 1 : (cfg.median > MaxN ? MaxN : cfg.median);
+    if (n != window) { window = n; count = 0; head = 0; }
+    if (n == 1) return x;
+    buf[head] = x;
+    if (++head == n) head = 0;
+    if (count < n) count++;
+    if (count == 3) {
+      // the default window: three compares, no copy
+      T a = buf[0], b = buf[1], c = buf[2];
+      if (a > b) { T t = a; a = b; b = t; }
+      return c < a ? a : (c > b ? b : c);
+    }
+    T sorted[MaxN];
+    for (uint8_t i = 0; i < count; i++) {
+      T v = buf[i];
+      uint8_t j = i;
+      for (; j > 0 && sorted[j - 1] > v; j--) sorted[j] = sorted[j - 1];
+      sorted[j] = v;
+    }
+    return sorted[(count - 1) / 2];
+  }
+  void reset() { count = 0; head = 0; }
+  // the window holds inputs, not outputs: it starts empty
+  void seed(T) { reset(); }
+ private:
+  T buf[MaxN];
+  uint8_t window = 0;
+  uint8_t count = 0;
+  uint8_t head = 0;
+};
+
+// Straight line through (mvLo, outLo) and (mvHi, outHi) in fixed point,
+// extrapolated beyond the points unless cfg.clamp is set. The Q16 slope is
+// worked out on the first sample after reset(), so there is no per-sample
+// division.
+template <typename T>
+class FilterMap {
+ public:
+  T operator()(T x, const ChannelFilter& cfg) {
+    if (cfg.mvHi == cfg.mvLo) return x;
+    if (!ready) {
+      slope = ((int64_t)(cfg.outHi - cfg.outLo) << 16) / (cfg.mvHi - cfg.mvLo);
+      ready = true;
+    }
+    T y = (T)(cfg.outLo + ((((int64_t)x - cfg.mvLo) * slope + 0x8000) >> 16));
+    if (!cfg.clamp) return y;
+    T lo = (T)(cfg.outLo < cfg.outHi ? cfg.outLo : cfg.outHi);
+    T hi = (T)(cfg.outLo < cfg.outHi ? cfg.outHi : cfg.outLo);
+    return y < lo ? lo : (y > hi ? hi : y);
+  }
+  void reset() { ready = false; }
+  void seed(T) {}
+ private:
+  int64_t slope = 0;
+  bool ready = false;
+};
+
+// Exponential smoothing with weight cfg.emaPct for the new sample. The state
+// is kept in Q8 so steps smaller than one output unit still add up; it is
+// seeded with the first sample instead of ramping up from zero after boot.
+template <typename T>
+class FilterEma {
+ public:
+  T operator()(T x, const ChannelFilter& cfg) {
+    int32_t xq = (int32_t)x << 8;
+    if (!seeded || cfg.emaPct >= 100) {
+      acc = xq;
+      seeded = true;
+    } else {
+      int32_t w = ((int32_t)(cfg.emaPct ? cfg.emaPct : 1) << 16) / 100;  // Q16 weight
+      acc += (int32_t)(((int64_t)(xq - acc) * w) >> 16);
+    }
+    return (T)((acc + 128) >> 8);
+  }
+  void reset() { seeded = false; }
+  // continue from output y, as if the previous samples had settled there
+  void seed(T y) {
+    acc = (int32_t)y << 8;
+    seeded = true;
+  }
+ private:
+  int32_t acc = 0;
+  bool seeded = false;
+};
+
+template <typename T, typename... Stages>
+class FilterPipeline;
+
+template <typename T>
+class FilterPipeline<T> {
+ public:
+  T process(T x, const ChannelFilter&) { return x; }
+  void reset() {}
+  void seed(T) {}
+};
+
+template <typename T, typename First, typename... Rest>
+class FilterPipeline<T, First, Rest...> {
+ public:
+  T process(T x, const ChannelFilter& cfg) { return rest.process(first(x, cfg), cfg); }
+  void reset() { first.reset(); rest.reset(); }
+  // Restart with y as the last output. Only stages holding output-side
+  // state (the EMA) use it; input-side ones restart empty.
+  void seed(T y) { first.seed(y); rest.seed(y); }
+ private:
+  First first;
+  FilterPipeline<T, Rest...> rest;
+};
+
+#endif
@@ -0,0 +1,85 @@
+// sensor_power.cpp
+#include "sensor_power.h"
+#include "sensor_registry.h"
+
+struct Rail {
+  const char* key;
+  uint8_t pin;
+  uint16_t settleMs;
+};
+
+static const Rail rails[RAIL_COUNT] = {
+    {"soil", SOIL_PWR_PIN, SOIL_SETTLE_MS},
+    {"ph",   PH_PWR_PIN,   PH_SETTLE_MS},
+};
+
+static uint8_t railsOn = 0;
+static uint8_t railsHeld = 0;  // left on by sensorPowerDown()
+static unsigned long onAt[RAIL_COUNT];
+static uint32_t awakeMs[RAIL_COUNT];
+
+void initSensorPower() {
+  for (uint8_t r = 0; r < RAIL_COUNT; r++) {
+    pinMode(rails[r].pin, OUTPUT);
+    digitalWrite(rails[r].pin, LOW);
+  }
+  railsOn = 0;
+}
+
+uint8_t sensorRailsFor(uint8_t analogMask) {
+  uint8_t mask = 0;
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    const SensorChannel& ch = sensorChannels[i];
+    if (ch.analog == SENSOR_NONE || ch.rail == SENSOR_NONE) continue;
+    if (analogMask & (1u << ch.analog)) mask |= RAIL_BIT(ch.rail);
+  }
+  return mask;
+}
+
+unsigned long sensorPowerUp(uint8_t railMask) {
+  // rails already on (held) have settled
+  uint8_t pending = railMask & ~railsOn;
+  uint16_t longest = 0;
+  for (uint8_t r = 0; r < RAIL_COUNT; r++) {
+    if ((pending & RAIL_BIT(r)) && rails[r].settleMs > longest) longest = rails[r].settleMs;
+  }
+  // rail r goes on at longest - settleMs, so none is powered longer than it
+  // needs and the window is only as long as the slowest rail
+  unsigned long t0 = millis();
+  while (1) {
+    uint32_t elapsed = millis() - t0;
+    uint32_t wait = longest - (elapsed < longest ? elapsed : longest);
+    for (uint8_t r = 0; r < RAIL_COUNT; r++) {
+      if (!(pending & RAIL_BIT(r))) continue;
+      uint32_t at = longest - rails[r].settleMs;
+      if (elapsed >= at) {
+        digitalWrite(rails[r].pin, HIGH);
+        onAt[r] = millis();
+        railsOn |= RAIL_BIT(r);
+        pending &= ~RAIL_BIT(r);
+      } else if (at - elapsed < wait) {
+        wait = at - elapsed;
+      }
+    }
+    if (!wait) break;
+    vTaskDelay(pdMS_TO_TICKS(wait));
+  }
+  return millis();
+}
+
+void sensorPowerDown() {
+  unsigned long now = millis();
+  for (uint8_t r = 0; r < RAIL_COUNT; r++) {
+    if (!(railsOn & RAIL_BIT(r)) || (railsHeld & RAIL_BIT(r))) continue;
+    digitalWrite(rails[r].pin, LOW);
+    awakeMs[r] += now - onAt[r];
+    railsOn &= ~RAIL_BIT(r);
+  }
+}
+
+void sensorPowerHold(uint8_t railMask) { railsHeld = railMask; }
+
+void sensorPowerToJson(JsonObject obj) {
+  JsonObject awake = obj.createNestedObject("sensorAwakeMs");
+  for (uint8_t r = 0; r < RAIL_COUNT; r++) awake[rails[r].key] = awakeMs[r];
+}
@@ -0,0 +1,37 @@
+// sensor_power.h
+#ifndef SENSOR_POWER_H
+#define SENSOR_POWER_H
+
+#include "config.h"
+
+// Switched supplies for the analog front ends. A rail is only powered for a
+// measurement window: DC through a resistive probe corrodes it, and the pH
+// board draws current the whole time it is on. The rails due in one window
+// are switched on longest-settling first, staggered so they all finish
+// settling at the same moment, then read and powered down together.
+#ifndef SOIL_SETTLE_MS
+#define SOIL_SETTLE_MS 100   // resistive probe: divider + ADC input RC
+#endif
+#ifndef PH_SETTLE_MS
+#define PH_SETTLE_MS 1000    // pH amplifier warm-up and output filter
+#endif
+
+enum SensorRail { RAIL_SOIL, RAIL_PH, RAIL_COUNT };
+
+#define RAIL_BIT(r) (1u << (r))
+
+void initSensorPower();
+// Rails feeding the analog channels in analogMask (bit per FilterChannel)
+uint8_t sensorRailsFor(uint8_t analogMask);
+// Power the rails in railMask and block until every one has settled.
+// Returns millis() at that point; readings taken from then on are valid.
+unsigned long sensorPowerUp(uint8_t railMask);
+// Switch every rail off, except held ones, and account its awake time
+void sensorPowerDown();
+// Keep the rails in railMask on across sensorPowerDown() (burst capture);
+// 0 releases them for the next sensorPowerDown()
+void sensorPowerHold(uint8_t railMask);
+// Add "sensorAwakeMs": {"soil": ms, "ph": ms}, powered time since boot
+void sensorPowerToJson(JsonObject obj);
+
+#endif
@@ -0,0 +1,56 @@
+// sensor_registry.cpp
+#include "sensor_registry.h"
+#include "adc_sampler.h"
+#include "sensor_power.h"
+
+const SensorChannel sensorChannels[SENSOR_COUNT] = {
+    // key    label kind        pin          analog        zone rail         whole  scale
+    {"temp",  "T",  KIND_TEMP,  SENSOR_NONE, SENSOR_NONE,  0, SENSOR_NONE, false, 1},
+    {"hum",   "H",  KIND_HUM,   SENSOR_NONE, SENSOR_NONE,  0, SENSOR_NONE, false, 1},
+    {"soil1", "S1", KIND_SOIL,  SOIL1_PIN,   FILTER_SOIL1, 0, RAIL_SOIL,   true,  1},
+    {"soil2", "S2", KIND_SOIL,  SOIL2_PIN,   FILTER_SOIL2, 0, RAIL_SOIL,   true,  1},
+    {"light", "L",  KIND_LIGHT, LDR_PIN,     FILTER_LIGHT, 0, SENSOR_NONE, true,  1},
+    {"ph",    "pH", KIND_PH,    PH_PIN,      FILTER_PH,    0, RAIL_PH,     false, 1000},
+};
+
+// pH starts neutral so no alert fires before the first reading
+static_assert(SENSOR_COUNT == 6, "give new channels an initial value");
+float sensorValues[SENSOR_COUNT] = {0, 0, 0, 0, 0, 7.0f};
+
+static_assert((int)ADC_IN_COUNT == (int)FILTER_CHANNEL_COUNT, "one ADC input per filtered channel");
+
+const SensorChannel* sensorForAnalog(uint8_t analog) {
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    if (sensorChannels[i].analog == analog) return &sensorChannels[i];
+  }
+  return nullptr;
+}
+
+float sensorAverage(SensorKind kind, uint8_t zone) {
+  float sum = 0;
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    if (sensorChannels[i].kind != kind || sensorChannels[i].zone != zone) continue;
+    sum += sensorValues[i];
+    n++;
+  }
+  return n ? sum / n : NAN;
+}
+
+const float* sensorThresholdRef(SensorKind kind) {
+  switch (kind) {
+    case KIND_TEMP: return &settings.tempThresh;
+    case KIND_HUM: return &settings.humThresh;
+    case KIND_SOIL: return &settings.soilThresh;
+    case KIND_LIGHT: return &settings.lightThresh;
+    default: return &settings.phThreshMax;
+  }
+}
+
+void sensorsToJson(JsonObject obj, const float* values) {
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    const SensorChannel& ch = sensorChannels[i];
+    if (ch.whole) obj[ch.key] = (int)lroundf(values[i]);
+    else obj[ch.key] = values[i];
+  }
+}
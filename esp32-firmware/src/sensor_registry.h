@@ -0,0 +1,44 @@
+// sensor_registry.h
+#ifndef SENSOR_REGISTRY_H
+#define SENSOR_REGISTRY_H
+
+#include "config.h"
+
+// Every measured quantity is one row in sensorChannels[] and one slot in
+// sensorValues[]. Sampling, filtering, telemetry and the relay rules walk
+// the table, so another probe or irrigation zone is another row here (plus
+// a FilterChannel slot if it is analog).
+enum SensorId { SENSOR_TEMP, SENSOR_HUM, SENSOR_SOIL1, SENSOR_SOIL2, SENSOR_LIGHT, SENSOR_PH, SENSOR_COUNT };
+
+enum SensorKind : uint8_t { KIND_TEMP, KIND_HUM, KIND_SOIL, KIND_LIGHT, KIND_PH };
+
+#define SENSOR_NONE 0xFF
+
+struct SensorChannel {
+  const char* key;    // telemetry / config key
+  const char* label;  // LCD label
+  SensorKind kind;
+  uint8_t pin;        // analog input pin, SENSOR_NONE for the DHT
+  uint8_t analog;     // FilterChannel / AdcInput index, SENSOR_NONE for the DHT
+  uint8_t zone;       // irrigation zone of a soil probe
+  uint8_t rail;       // SensorRail powering it, SENSOR_NONE when always on
+  bool whole;        // reported as an integer (%)
+  uint16_t scale;     // filter output units per value unit (0.001 pH -> 1000)
+};
+
+extern const SensorChannel sensorChannels[SENSOR_COUNT];
+extern float sensorValues[SENSOR_COUNT];
+
+inline float sensorValue(SensorId id) { return sensorValues[id]; }
+// Channel behind settings.filters[analog] / AdcReading::mean[analog]
+const SensorChannel* sensorForAnalog(uint8_t analog);
+// Mean of the channels of one kind in a zone, NAN when there are none
+float sensorAverage(SensorKind kind, uint8_t zone);
+// Relay / alert threshold a kind is compared against (pH: phThreshMax);
+// the reference stays valid, so it follows edits from the LCD or config
+const float* sensorThresholdRef(SensorKind kind);
+inline float sensorThreshold(SensorKind kind) { return *sensorThresholdRef(kind); }
+// Add "key": value for every channel of a values[SENSOR_COUNT] copy
+void sensorsToJson(JsonObject obj, const float* values);
+
+#endif
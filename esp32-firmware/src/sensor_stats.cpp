@@ -0,0 +1,187 @@
+// sensor_stats.cpp
+#include "sensor_stats.h"
+
+// running state of one channel in one window (sensor task only)
+struct StatsAcc {
+  uint16_t n;
+  float mean;
+  float m2;  // sum of squared differences from the mean
+  float min;
+  float max;
+  uint32_t aboveMs;
+  unsigned long lastMs;  // last sample, or the window start it was carried into
+  bool above;            // the last sample was above the threshold
+  bool seen;
+};
+
+static StatsAcc acc[STATS_WINDOW_COUNT][SENSOR_COUNT];
+static unsigned long windowStart[STATS_WINDOW_COUNT];
+static unsigned long windowEnd[STATS_WINDOW_COUNT];
+static bool windowsReady = false;
+// set by applyStatsConfig(); the sensor task restarts the windows
+static volatile bool windowsChanged = false;
+
+// completed windows, copied out under statsMux by other tasks
+static StatsSummary done[STATS_WINDOW_COUNT][SENSOR_COUNT];
+static bool haveDone[STATS_WINDOW_COUNT];
+static volatile uint32_t closed[STATS_WINDOW_COUNT];
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+void defaultStatsWindows() {
+  settings.statsWindowSec[0] = 60;
+  settings.statsWindowSec[1] = 900;
+}
+
+void applyStatsConfig(JsonObjectConst obj) {
+  JsonArrayConst arr = obj["windowsSec"].as<JsonArrayConst>();
+  if (arr.isNull()) return;
+  for (uint8_t w = 0; w < STATS_WINDOW_COUNT && w < arr.size(); w++) {
+    settings.statsWindowSec[w] = constrain(arr[w].as<uint32_t>(), (uint32_t)STATS_WINDOW_MIN_SEC, (uint32_t)STATS_WINDOW_MAX_SEC);
+  }
+  windowsChanged = true;
+  Serial.printf("[STATS] windows %u s / %u s\n", settings.statsWindowSec[0], settings.statsWindowSec[1]);
+}
+
+uint16_t statsWindowSec(uint8_t w) {
+  uint16_t s = settings.statsWindowSec[w];
+  return s < STATS_WINDOW_MIN_SEC ? STATS_WINDOW_MIN_SEC : (s > STATS_WINDOW_MAX_SEC ? STATS_WINDOW_MAX_SEC : s);
+}
+
+static void resetWindows(unsigned long now) {
+  memset(acc, 0, sizeof(acc));
+  portENTER_CRITICAL(&statsMux);
+  for (uint8_t w = 0; w < STATS_WINDOW_COUNT; w++) {
+    uint32_t len = (uint32_t)statsWindowSec(w) * 1000UL;
+    windowStart[w] = now;
+    windowEnd[w] = (now / len + 1) * len;
+    haveDone[w] = false;
+  }
+  portEXIT_CRITICAL(&statsMux);
+  windowsReady = true;
+}
+
+static void closeWindow(uint8_t w) {
+  unsigned long end = windowEnd[w];
+  StatsSummary out[SENSOR_COUNT];
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    StatsAcc& a = acc[w][i];
+    // the held value counts up to the end of the window
+    if (a.seen && a.above) a.aboveMs += end - a.lastMs;
+    out[i].count = a.n;
+    out[i].min = a.n ? a.min : NAN;
+    out[i].max = a.n ? a.max : NAN;
+    out[i].mean = a.n ? a.mean : NAN;
+    out[i].sd = a.n > 1 ? sqrtf(a.m2 / (a.n - 1)) : 0;
+    out[i].aboveMs = a.aboveMs;
+    out[i].spanMs = end - windowStart[w];
+    // carry the held value into the next window
+    bool above = a.above, seen = a.seen;
+    memset(&a, 0, sizeof(a));
+    a.above = above;
+    a.seen = seen;
+    a.lastMs = end;
+  }
+  portENTER_CRITICAL(&statsMux);
+  memcpy(done[w], out, sizeof(out));
+  haveDone[w] = true;
+  closed[w] = closed[w] + 1;
+  portEXIT_CRITICAL(&statsMux);
+  windowStart[w] = end;
+  windowEnd[w] = end + (uint32_t)statsWindowSec(w) * 1000UL;
+}
+
+void statsTick(unsigned long now) {
+  if (!windowsReady || windowsChanged) {
+    windowsChanged = false;
+    resetWindows(now);
+    return;
+  }
+  for (uint8_t w = 0; w < STATS_WINDOW_COUNT; w++) {
+    if ((long)(now - windowEnd[w]) < 0) continue;
+    closeWindow(w);
+    // after a long stall skip the empty windows instead of closing each one
+    if ((long)(now - windowEnd[w]) >= 0) {
+      uint32_t len = (uint32_t)statsWindowSec(w) * 1000UL;
+      windowStart[w] = now;
+      windowEnd[w] = (now / len + 1) * len;
+      for (uint8_t i = 0; i < SENSOR_COUNT; i++) acc[w][i].lastMs = now;
+    }
+  }
+}
+
+void statsAdd(SensorId id, float v, unsigned long now) {
+  if (isnan(v)) return;
+  statsTick(now);
+  bool above = v > sensorThreshold(sensorChannels[id].kind);
+  for (uint8_t w = 0; w < STATS_WINDOW_COUNT; w++) {
+    StatsAcc& a = acc[w][id];
+    if (a.seen && a.above) a.aboveMs += now - a.lastMs;
+    // Welford: numerically stable running mean and variance
+    a.n++;
+    float delta = v - a.mean;
+    a.mean += delta / a.n;
+    a.m2 += delta * (v - a.mean);
+    if (a.n == 1 || v < a.min) a.min = v;
+    if (a.n == 1 || v > a.max) a.max = v;
+    a.lastMs = now;
+    a.above = above;
+    a.seen = true;
+  }
+}
+
+static bool copyDone(uint8_t w, StatsSummary* out) {
+  portENTER_CRITICAL(&statsMux);
+  bool ok = haveDone[w];
+  if (ok) memcpy(out, done[w], sizeof(done[w]));
+  portEXIT_CRITICAL(&statsMux);
+  return ok;
+}
+
+bool statsSummary(uint8_t w, SensorId id, StatsSummary* out) {
+  portENTER_CRITICAL(&statsMux);
+  bool ok = haveDone[w];
+  if (ok) *out = done[w][id];
+  portEXIT_CRITICAL(&statsMux);
+  return ok;
+}
+
+uint32_t statsClosed(uint8_t w) { return closed[w]; }
+
+// two decimals keep the arrays short on the wire
+static float round2(float v) { return roundf(v * 100) / 100; }
+
+static void channelsToJson(JsonObject obj, const StatsSummary* s) {
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    if (!s[i].count) continue;
+    JsonArray a = obj.createNestedArray(sensorChannels[i].key);
+    a.add(s[i].count);
+    a.add(round2(s[i].min));
+    a.add(round2(s[i].max));
+    a.add(round2(s[i].mean));
+    a.add(round2(s[i].sd));
+    a.add(s[i].aboveMs);
+  }
+}
+
+void statsWindowToJson(JsonObject obj, uint8_t w) {
+  StatsSummary s[SENSOR_COUNT];
+  obj["windowSec"] = statsWindowSec(w);
+  if (!copyDone(w, s)) return;
+  obj["spanMs"] = s[0].spanMs;
+  channelsToJson(obj, s);
+}
+
+void statsToJson(JsonObject obj, uint32_t* seen) {
+  JsonObject stats;
+  for (uint8_t w = 0; w < STATS_WINDOW_COUNT; w++) {
+    uint32_t n = closed[w];
+    if (n == seen[w]) continue;
+    seen[w] = n;
+    StatsSummary s[SENSOR_COUNT];
+    if (!copyDone(w, s)) continue;
+    if (stats.isNull()) stats = obj.createNestedObject("stats");
+    char key[8];
+    snprintf(key, sizeof(key), "%u", statsWindowSec(w));
+    channelsToJson(stats.createNestedObject(key), s);
+  }
+}
@@ -0,0 +1,48 @@
+// sensor_stats.h
+#ifndef SENSOR_STATS_H
+#define SENSOR_STATS_H
+
+#include "config.h"
+#include "sensor_registry.h"
+
+// Per-channel summaries over tumbling windows (settings.statsWindowSec).
+// Every sample updates count, min, max and a Welford mean/variance in O(1),
+// so a telemetry frame carries what happened since the last one instead of
+// only the latest filtered value. Windows are aligned to multiples of their
+// length on the millis() clock; the first one after boot is shorter.
+#define STATS_WINDOW_MIN_SEC 10
+#define STATS_WINDOW_MAX_SEC 43200
+
+struct StatsSummary {
+  uint16_t count;
+  float min;
+  float max;
+  float mean;
+  float sd;          // sample standard deviation, 0 below two samples
+  uint32_t aboveMs;  // time the channel held a value above its threshold
+  uint32_t spanMs;   // time the window covered
+};
+
+void defaultStatsWindows();
+// Apply a remote "stats" object ({"windowsSec": [60, 900]}); restarts the windows
+void applyStatsConfig(JsonObjectConst obj);
+
+// Sensor task only: add a sample, close windows that ended
+void statsAdd(SensorId id, float value, unsigned long nowMs);
+void statsTick(unsigned long nowMs);
+
+// Last completed window w of a channel; false until one has closed (again,
+// after the window lengths changed)
+bool statsSummary(uint8_t w, SensorId id, StatsSummary* out);
+// Windows of slot w closed since boot; a change means a new summary
+uint32_t statsClosed(uint8_t w);
+uint16_t statsWindowSec(uint8_t w);
+
+// "stats": {"60": {"temp": [n, min, max, mean, sd, aboveMs], ...}, "900": {...}}
+// with the windows closed since seen[] (statsClosed() values), which it
+// updates, so each summary goes out once; nothing when none closed
+void statsToJson(JsonObject obj, uint32_t* seen);
+// One window: {"windowSec": 60, "spanMs": ..., "temp": [...], ...}
+void statsWindowToJson(JsonObject obj, uint8_t w);
+
+#endif
@@ -2,6 +2,23 @@
 #include "config.h"
 #include "relay_control.h"
 #include "wifi_server.h"
+#include "metrics.h"
+#include "trace.h"
+#include "task_monitor.h"
+#include "deferred_log.h"
+#include "boot_timeline.h"
+#include "task_stacks.h"
+#include "adc_sampler.h"
+#include "dht_rmt.h"
+#include "sensor_filter.h"
+#include "adc_calibration.h"
+#include "sensors.h"
+#include "sensor_registry.h"
+#include "sensor_power.h"
+#include "sensor_stats.h"
+#include "burst_capture.h"
+#include "alerts.h"
+#include <atomic>
 
 uint8_t dhtFailCount = 0;
 
@@ -9,133 +26,389 @@ bool dhtError;
 
 DHT dht(DHT_PIN, DHT_TYPE);
 
-struct SensorState {
-  float temp = 0.0;
-  float hum = 0.0;
-  int soil1 = 0;
-  int soil2 = 0;
-  int light = 0;
-  float ph = 7.0;
-  bool pump = false;
-  bool fan = false;
-  bool lightOn = false;
-};
 SensorState state;
-unsigned long lastLightMeasured = 0;
 
-// forward declaration
-void readSensors();
+// Seqlock: odd while a publish is copying. Writers on different tasks (the
+// sensor task, MQTT, HTTP, buttons) are serialised by snapMux; readers only
+// compare the sequence before and after their copy.
+static SensorSnapshot published;
+static std::atomic<uint32_t> snapSeq(0);
+static portMUX_TYPE snapMux = portMUX_INITIALIZER_UNLOCKED;
+
+void publishSensorState() {
+  portENTER_CRITICAL(&snapMux);
+  uint32_t seq = snapSeq.load(std::memory_order_relaxed) + 1;
+  snapSeq.store(seq, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(published.values, sensorValues, sizeof(published.values));
+  published.relays = state;
+  published.seq = seq + 1;
+  snapSeq.store(seq + 1, std::memory_order_release);
+  portEXIT_CRITICAL(&snapMux);
+}
+
+void snapshotSensorState(SensorSnapshot* out) {
+  uint32_t before, after;
+  do {
+    before = snapSeq.load(std::memory_order_acquire);
+    memcpy(out, &published, sizeof(*out));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    after = snapSeq.load(std::memory_order_relaxed);
+  } while ((before & 1) || before != after);
+}
+
+// counts -> mV -> units per channel, parameters in settings.filters
+typedef FilterPipeline<int, FilterAdcMv<int>, FilterMedian<int, FILTER_MEDIAN_MAX>, FilterMap<int>, FilterEma<int>>
+    SensorFilter;
+static SensorFilter filters[FILTER_CHANNEL_COUNT];
+// set by applyFilterConfig(); readSensors() restarts the filters
+static volatile bool filtersChanged = false;
+
+#define FILTER_MV_MAX 3300
+#define FILTER_OUT_LIMIT 100000  // keeps the EMA's Q8 state within int32
+
+// Default calibration by sensor kind.
+// soil: 3062 mV -> 0 %, 806 mV -> 100 % (set from your probe's wet/dry readings)
+static const ChannelFilter SOIL_FILTER = {3, 30, 3062, 806, 1, 0, 0, 100};
+// light: the LDR reads higher when darker, so brighter -> larger %
+static const ChannelFilter LIGHT_FILTER = {3, 30, 0, 3300, 1, 0, 100, 0};
+// pH probe two-point calibration: pH 7.00 at 2500 mV, pH 4.00 at 3040 mV
+static const ChannelFilter PH_FILTER = {3, 30, 2500, 3040, 0, 0, 7000, 4000};
+
+static const ChannelFilter& defaultFilter(uint8_t analog) {
+  const SensorChannel* ch = sensorForAnalog(analog);
+  if (ch && ch->kind == KIND_PH) return PH_FILTER;
+  if (ch && ch->kind == KIND_LIGHT) return LIGHT_FILTER;
+  return SOIL_FILTER;
+}
+
+void defaultFilterSettings() {
+  for (uint8_t i = 0; i < FILTER_CHANNEL_COUNT; i++) settings.filters[i] = defaultFilter(i);
+}
+
+bool validateFilterSettings() {
+  bool changed = false;
+  for (uint8_t i = 0; i < FILTER_CHANNEL_COUNT; i++) {
+    const ChannelFilter& c = settings.filters[i];
+    bool ok = c.median >= 1 && c.median <= FILTER_MEDIAN_MAX && c.emaPct >= 1 && c.emaPct <= 100 &&
+              c.mvLo >= 0 && c.mvLo <= FILTER_MV_MAX && c.mvHi >= 0 && c.mvHi <= FILTER_MV_MAX &&
+              c.mvLo != c.mvHi && c.clamp <= 1 && abs(c.outLo) <= FILTER_OUT_LIMIT &&
+              abs(c.outHi) <= FILTER_OUT_LIMIT;
+    if (ok) continue;
+    Serial.printf("[FILTER] %s: stored calibration invalid, using defaults\n", sensorForAnalog(i)->key);
+    settings.filters[i] = defaultFilter(i);
+    changed = true;
+  }
+  return changed;
+}
+
+// {"ph": {"median": 5, "ema": 30, "mvLo": 2500, "mvHi": 3040, "outLo": 7.0, "outHi": 4.0, "clamp": false}, ...}
+void applyFilterConfig(JsonObjectConst obj) {
+  for (uint8_t i = 0; i < FILTER_CHANNEL_COUNT; i++) {
+    const SensorChannel* ch = sensorForAnalog(i);
+    JsonObjectConst f = obj[ch->key].as<JsonObjectConst>();
+    if (f.isNull()) continue;
+    ChannelFilter c = settings.filters[i];
+    if (f.containsKey("median")) c.median = constrain(f["median"].as<int>(), 1, FILTER_MEDIAN_MAX);
+    if (f.containsKey("ema")) c.emaPct = constrain(f["ema"].as<int>(), 1, 100);
+    if (f.containsKey("mvLo")) c.mvLo = constrain(f["mvLo"].as<int>(), 0, FILTER_MV_MAX);
+    if (f.containsKey("mvHi")) c.mvHi = constrain(f["mvHi"].as<int>(), 0, FILTER_MV_MAX);
+    if (f.containsKey("outLo")) c.outLo = constrain(lroundf(f["outLo"].as<float>() * ch->scale), -FILTER_OUT_LIMIT, FILTER_OUT_LIMIT);
+    if (f.containsKey("outHi")) c.outHi = constrain(lroundf(f["outHi"].as<float>() * ch->scale), -FILTER_OUT_LIMIT, FILTER_OUT_LIMIT);
+    if (f.containsKey("clamp")) c.clamp = f["clamp"].as<bool>() ? 1 : 0;
+    if (c.mvLo == c.mvHi) {
+      Serial.printf("[FILTER] %s: mvLo == mvHi, ignored\n", ch->key);
+      continue;
+    }
+    settings.filters[i] = c;
+    Serial.printf("[FILTER] %s: median %u ema %u%% %d..%d mV -> %ld..%ld/%u%s\n", ch->key, c.median,
+                  c.emaPct, c.mvLo, c.mvHi, (long)c.outLo, (long)c.outHi, ch->scale,
+                  c.clamp ? " clamped" : "");
+  }
+  filtersChanged = true;
+}
+
+void seedSensorFilter(SensorId id, float value) {
+  const SensorChannel& ch = sensorChannels[id];
+  if (ch.analog == SENSOR_NONE) return;
+  if (filtersChanged) {
+    filtersChanged = false;
+    for (uint8_t a = 0; a < FILTER_CHANNEL_COUNT; a++) filters[a].reset();
+  }
+  filters[ch.analog].seed((int)lroundf(value * ch.scale));
+  sensorValues[id] = value;
+}
+
+// Channel groups sensorTask samples on their own periods
+enum SenseChannel { SENSE_DHT, SENSE_SOIL, SENSE_LIGHT, SENSE_PH, SENSE_CHANNEL_COUNT };
+#define SENSE_BIT(ch) (1u << (ch))
+#define SENSE_ALL (SENSE_BIT(SENSE_CHANNEL_COUNT) - 1)
+
+static uint8_t senseGroup(SensorKind kind) {
+  switch (kind) {
+    case KIND_SOIL: return SENSE_SOIL;
+    case KIND_LIGHT: return SENSE_LIGHT;
+    case KIND_PH: return SENSE_PH;
+    default: return SENSE_DHT;
+  }
+}
+
+// analog channels follow the AdcTask burst, so faster gains nothing
+#define SAMPLE_PERIOD_MIN_MS 1000
+#define SAMPLE_PERIOD_MAX_MS 3600000UL
+// longest sensorTask sleep: statistics windows and telemetry still run
+#define SENSOR_IDLE_MAX_MS 3000
+
+static const char* const SAMPLING_KEYS[] = {"dhtMs", "soilMs", "soilPumpMs", "lightMs", "phMs"};
+
+static unsigned long lastSampled[SENSE_CHANNEL_COUNT];
+static bool sampledOnce = false;
+// cuts a sensorTask sleep short (burst trigger, pump switched)
+static SemaphoreHandle_t sensorWake = NULL;
+
+static uint8_t sampleSensors(uint8_t mask);
+
+void defaultSamplePeriods() {
+  settings.sampling.dhtMs = 5000;
+  settings.sampling.soilMs = 5000;
+  settings.sampling.soilPumpMs = 1000;  // watch the soil come up while watering
+  settings.sampling.lightMs = 5000;
+  settings.sampling.phMs = 30000;       // the probe drifts slowly
+}
+
+void applySamplingConfig(JsonObjectConst obj) {
+  uint32_t* periods = &settings.sampling.dhtMs;
+  for (uint8_t i = 0; i < sizeof(SAMPLING_KEYS) / sizeof(SAMPLING_KEYS[0]); i++) {
+    if (!obj.containsKey(SAMPLING_KEYS[i])) continue;
+    periods[i] = constrain(obj[SAMPLING_KEYS[i]].as<uint32_t>(), (uint32_t)SAMPLE_PERIOD_MIN_MS, SAMPLE_PERIOD_MAX_MS);
+  }
+  Serial.printf("[SENSORS] periods dht=%u soil=%u (pump %u) light=%u ph=%u ms\n", settings.sampling.dhtMs,
+                settings.sampling.soilMs, settings.sampling.soilPumpMs, settings.sampling.lightMs,
+                settings.sampling.phMs);
+}
+
+static uint32_t samplePeriodMs(uint8_t ch) {
+  const SamplePeriods& p = settings.sampling;
+  uint32_t ms;
+  switch (ch) {
+    case SENSE_DHT:
+      // DHT11 needs >= 1 s between reads, DHT22 >= 2 s
+      ms = max(p.dhtMs, (uint32_t)(DHT_TYPE == DHT11 ? 1000 : 2000));
+      break;
+    case SENSE_SOIL: ms = state.pump ? p.soilPumpMs : p.soilMs; break;
+    case SENSE_LIGHT: ms = p.lightMs; break;
+    default: ms = p.phMs; break;
+  }
+  return constrain(ms, (uint32_t)SAMPLE_PERIOD_MIN_MS, SAMPLE_PERIOD_MAX_MS);
+}
+
+// channels whose period has elapsed; all of them on the first call
+static uint8_t dueChannels(unsigned long now) {
+  uint8_t due = 0;
+  for (uint8_t ch = 0; ch < SENSE_CHANNEL_COUNT; ch++) {
+    if (!sampledOnce || now - lastSampled[ch] >= samplePeriodMs(ch)) due |= SENSE_BIT(ch);
+  }
+  return due;
+}
+
+// ms until the next channel is due, capped at SENSOR_IDLE_MAX_MS
+static uint32_t nextDueMs(unsigned long now) {
+  uint32_t wait = SENSOR_IDLE_MAX_MS;
+  for (uint8_t ch = 0; ch < SENSE_CHANNEL_COUNT; ch++) {
+    uint32_t elapsed = now - lastSampled[ch];
+    uint32_t period = samplePeriodMs(ch);
+    uint32_t left = elapsed >= period ? 0 : period - elapsed;
+    if (left < wait) wait = left;
+  }
+  return wait;
+}
 
 void initSensors() {
-  dht.begin();
-  pinMode(SOIL1_PIN, INPUT);
-  pinMode(SOIL2_PIN, INPUT);
-  pinMode(LDR_PIN, INPUT);
-  pinMode(PH_PIN, INPUT);
-  // Configure ADC for more stable readings
-  analogSetPinAttenuation(SOIL1_PIN, ADC_11db);
-  analogSetPinAttenuation(SOIL2_PIN, ADC_11db);
-  analogSetPinAttenuation(LDR_PIN, ADC_11db);
-  analogSetPinAttenuation(PH_PIN, ADC_11db);
+  // probe supplies start off; sampleSensors() powers them per reading
+  initSensorPower();
+  // RMT capture when available; the DHT library bit-bangs with interrupts off
+  if (!dhtRmtBegin()) dht.begin();
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    if (sensorChannels[i].pin == SENSOR_NONE) continue;
+    pinMode(sensorChannels[i].pin, INPUT);
+    // Configure ADC for more stable readings
+    analogSetPinAttenuation(sensorChannels[i].pin, ADC_11db);
+  }
   analogSetWidth(12); // 12-bit ADC (0-4095)
+  // counts -> mV table from the eFuse characterisation
+  initAdcCalibration();
+  // background oversampling; analogRead() stays as the fallback
+  if (!initAdcSampler()) Serial.println("[ADC] continuous mode unavailable, using analogRead");
 }
 
-// Sensor task that periodically reads sensors every 3s
+// Sensor task: samples each channel group when its period (settings.sampling)
+// comes due and sleeps until the next one
 void sensorTask(void *param) {
-  const TickType_t delayTicks = pdMS_TO_TICKS(3000);
   unsigned long lastTelemetry = 0;
   while (1) {
+    taskLoopHead(MON_SENSOR);
     feedWatchdog();
-    readSensors();
-    // after reading sensors, evaluate relay control logic
-    controlRelays();
+    uint8_t due = dueChannels(millis());
+    if (due) {
+      uint8_t updated = sampleSensors(due);
+      publishSensorState();
+      // the control task runs the rules reading these channels
+      controlNotifySample(updated);
+      // out-of-range alerts are only queued here; serverTask sends them
+      alertsEvaluate(updated, millis());
+    }
+    // close statistics windows even when nothing was sampled
+    statsTick(millis());
+    // burst capture: pending trigger, then any frames due
+    uint32_t burstWait = burstPoll(millis());
     // send telemetry at most once every 10s
     if (millis() - lastTelemetry >= 10000) {
       requestTelemetrySend();
       lastTelemetry = millis();
     }
-    vTaskDelay(delayTicks);
+    uint32_t wait = nextDueMs(millis());
+    xSemaphoreTake(sensorWake, pdMS_TO_TICKS(burstWait < wait ? burstWait : wait));
   }
 }
 
+void wakeSensorTask() {
+  if (sensorWake) xSemaphoreGive(sensorWake);
+}
+
 void startSensorTask() {
-  xTaskCreatePinnedToCore(sensorTask, "SensorTask", 4096, NULL, 3, &sensorTaskHandle, 1);
+  sensorWake = xSemaphoreCreateBinary();
+  xTaskCreatePinnedToCore(sensorTask, "SensorTask", STACK_SENSOR_TASK, NULL, 3, &sensorTaskHandle, 1);
 }
 
 void readSensors() {
-  static unsigned long last = 0;
-  if (millis() - last < 5000) return;
-  last = millis();
+  sampleSensors(SENSE_ALL);
+  publishSensorState();
+}
 
-  // record the time of this measurement (used by relay control to detect "new" readings)
-  lastLightMeasured = last;
+// Returns the channels that got a new value, bit per SensorId
+static uint8_t sampleSensors(uint8_t mask) {
+  TRACE_SPAN("readSensors");
+  uint32_t t0 = micros();
+  unsigned long now = millis();
+  // a failed read also waits a full period before retrying
+  for (uint8_t ch = 0; ch < SENSE_CHANNEL_COUNT; ch++) {
+    if (mask & SENSE_BIT(ch)) lastSampled[ch] = now;
+  }
+  sampledOnce = true;
+  uint8_t updated = 0;
 
-  // state.temp = dht.readTemperature();
-  // state.hum = dht.readHumidity();
-  // if (isnan(state.temp)) state.temp = 0; //nếu lỗi NaN thì giá trị = 0 --> nguy hiểm 
-  // if (isnan(state.hum)) state.hum = 0;
+  // a frame the RMT callback decoded after the last DHT pass goes out with
+  // whatever this pass samples
+  if (!(mask & SENSE_BIT(SENSE_DHT)) && dhtRmtActive() && dhtRmtCollect()) {
+    updated |= (1u << SENSOR_TEMP) | (1u << SENSOR_HUM);
+  }
+  if (mask & SENSE_BIT(SENSE_DHT)) {
+    float t, h;
+    if (dhtRmtActive()) {
+      // the reply is decoded by the RMT callback; this cycle uses the
+      // previous one, except at boot where the first is awaited
+      dhtRmtStart();
+      dhtRmtWaitFirst(50);
+      dhtRmtCollect();
+      t = sensorValues[SENSOR_TEMP];
+      h = sensorValues[SENSOR_HUM];
+    } else {
+      t = dht.readTemperature();
+      h = dht.readHumidity();
+
+      //nếu DHT11 đọc lỗi 5 lần -> print ERR 
+      if (isnan(t) || isnan(h)) {
+        if (dhtFailCount < 255) dhtFailCount++;
+      } else {
+        dhtFailCount = 0;
+      }
 
-  float t = dht.readTemperature();
-  float h = dht.readHumidity();
+      if (!isnan(t)) {sensorValues[SENSOR_TEMP] = t;}
+      if (!isnan(h)) {sensorValues[SENSOR_HUM] = h;}
+    }
+    statsAdd(SENSOR_TEMP, t, now);
+    statsAdd(SENSOR_HUM, h, now);
+    updated |= (1u << SENSOR_TEMP) | (1u << SENSOR_HUM);
+    // dhtFailCount is kept by either reader (dht_rmt.cpp on the RMT path)
+    static bool dhtAlerted = false;
+    if (dhtFailCount >= 5 && !dhtAlerted) {
+      alertRaise("dht", ALERT_WARNING, NAN, "DHT read failed 5 times");
+      dhtAlerted = true;
+    } else if (dhtFailCount == 0 && dhtAlerted) {
+      alertClear("dht", NAN, "DHT reading again");
+      dhtAlerted = false;
+    }
 
-  //nếu DHT11 đọc lỗi 5 lần -> print ERR 
-  if (isnan(t) || isnan(h)) {
-    dhtFailCount++;
+    DLOG(LF_SENSORS_DHT, t, h, dhtFailCount);
+  }
+
+  uint8_t analogDue = 0;  // bit per FilterChannel
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    const SensorChannel& ch = sensorChannels[i];
+    if (ch.analog != SENSOR_NONE && (mask & SENSE_BIT(senseGroup(ch.kind)))) analogDue |= 1u << ch.analog;
+  }
+  if (!analogDue) {
+    metricsObserve(metrics.readSensors, micros() - t0);
+    return updated;
+  }
+
+  // power the probes behind the due channels and wait for them to settle
+  uint8_t rails = sensorRailsFor(analogDue);
+  unsigned long settledAt = rails ? sensorPowerUp(rails) : 0;
+
+  // raw counts per analog channel; the last ones stay for the log lines
+  static float raw[FILTER_CHANNEL_COUNT];
+  if (adcSamplerRunning()) {
+    // oversampled by AdcTask: a powered probe needs a burst taken after it
+    // settled, the others use the latest one (only the first call can wait)
+    AdcReading adc;
+    bool ok = rails ? adcSamplerFresh(&adc, settledAt, 500) : adcSamplerLatest(&adc, 500);
+    if (!ok) {
+      sensorPowerDown();
+      return updated;
+    }
+    for (uint8_t a = 0; a < FILTER_CHANNEL_COUNT; a++) {
+      if (analogDue & (1u << a)) raw[a] = adc.mean[a];
+    }
   } else {
-    dhtFailCount = 0;
-  }
-
-  if (!isnan(t)) {state.temp = t;}
-  if (!isnan(h)) {state.hum = h;}
-
-  // Read analog pins with averaging to reduce noise
-  const int SAMPLES = 8;
-  long sumSoil1 = 0, sumSoil2 = 0, sumLight = 0, sumPH = 0;
-  for (int i = 0; i < SAMPLES; i++) {
-    sumSoil1 += analogRead(SOIL1_PIN);
-    sumSoil2 += analogRead(SOIL2_PIN);
-    sumLight += analogRead(LDR_PIN);
-    sumPH += analogRead(PH_PIN);
-    delay(2);
-  }
-  int rawSoil1 = sumSoil1 / SAMPLES;
-  int rawSoil2 = sumSoil2 / SAMPLES;
-  int rawLight = sumLight / SAMPLES;
-  float rawPH = (float)sumPH / SAMPLES;
-
-  Serial.printf("[SENSORS] DHT t=%.2f h=%.2f dhtFail=%u\n", t, h, dhtFailCount);
-  Serial.printf("[SENSORS] RAW soil1=%d soil2=%d\n", rawSoil1, rawSoil2);
-  Serial.printf("[SENSORS] rawLight=%d rawPHraw=%0.1f\n", rawLight, rawPH);
-
-  // Map soil sensors to 0-100% with simple calibration/clamping (tweak MIN/MAX for your probes)
-  const int SOIL_MIN = 1000;   // adjust to your dry reading
-  const int SOIL_MAX = 3800;  // adjust to your wet reading
-  int mappedSoil1 = constrain(map(rawSoil1, SOIL_MAX, SOIL_MIN, 0, 100), 0, 100);
-  int mappedSoil2 = constrain(map(rawSoil2, SOIL_MAX, SOIL_MIN, 0, 100), 0, 100);
-
-  // Map light to 0-100% (calibrate if needed)
-  // Note: the sensor returns higher ADC when it's darker and lower ADC when brighter.
-  // We invert the mapping so a brighter environment yields a larger percentage.
-  const int LIGHT_MIN = 0;
-  const int LIGHT_MAX = 4095;
-  int percent = 0;
-  if (LIGHT_MAX != LIGHT_MIN) {
-    percent = (int)(((long)rawLight - LIGHT_MIN) * 100L / (LIGHT_MAX - LIGHT_MIN));
-  }
-  int mappedLight = constrain(100 - percent, 0, 100);
-
-  // Convert averaged PH ADC to voltage then to pH with calibration constants
-  float voltage = (rawPH * 3.3f) / 4095.0f;
-  float computedPH = 7.0f + ((2.5f - voltage) / 0.18f);
-
-  // Apply simple exponential smoothing to reduce jitter
-  const float ALPHA = 0.3f; // smoothing factor (0..1)
-  state.soil1 = (int)(ALPHA * mappedSoil1 + (1.0f - ALPHA) * state.soil1);
-  state.soil2 = (int)(ALPHA * mappedSoil2 + (1.0f - ALPHA) * state.soil2);
-  state.light = (int)(ALPHA * mappedLight + (1.0f - ALPHA) * state.light);
-  // mark when light value was last updated (useful to ensure we act on a new reading)
-  lastLightMeasured = last;
-  state.ph = ALPHA * computedPH + (1.0f - ALPHA) * state.ph;
-
-  Serial.printf("[SENSORS] light=%d ph=%.2f voltage=%.3f\n", state.light, state.ph, voltage);
+    // Read the due analog pins with averaging to reduce noise
+    const int SAMPLES = 8;
+    long sum[FILTER_CHANNEL_COUNT] = {0};
+    for (int n = 0; n < SAMPLES; n++) {
+      for (uint8_t a = 0; a < FILTER_CHANNEL_COUNT; a++) {
+        if (analogDue & (1u << a)) sum[a] += analogRead(sensorForAnalog(a)->pin);
+      }
+      delay(2);
+    }
+    for (uint8_t a = 0; a < FILTER_CHANNEL_COUNT; a++) {
+      if (analogDue & (1u << a)) raw[a] = (float)sum[a] / SAMPLES;
+    }
+  }
+  sensorPowerDown();
+
+  if (filtersChanged) {
+    filtersChanged = false;
+    for (uint8_t a = 0; a < FILTER_CHANNEL_COUNT; a++) filters[a].reset();
+  }
+  // median (spike rejection) -> calibration map -> EMA, per channel
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    const SensorChannel& ch = sensorChannels[i];
+    if (ch.analog == SENSOR_NONE || !(analogDue & (1u << ch.analog))) continue;
+    int counts = (int)lroundf(raw[ch.analog]);
+    sensorValues[i] = (float)filters[ch.analog].process(counts, settings.filters[ch.analog]) / ch.scale;
+    statsAdd((SensorId)i, sensorValues[i], now);
+    burstObserve(ch.analog, sensorValues[i]);
+    updated |= 1u << i;
+  }
+
+  if (mask & SENSE_BIT(SENSE_SOIL)) {
+    DLOG(LF_SENSORS_RAW, (int)lroundf(raw[FILTER_SOIL1]), (int)lroundf(raw[FILTER_SOIL2]));
+  }
+  if (mask & (SENSE_BIT(SENSE_LIGHT) | SENSE_BIT(SENSE_PH))) {
+    DLOG(LF_SENSORS_RAW_LIGHT, (int)lroundf(raw[FILTER_LIGHT]), raw[FILTER_PH]);
+    float voltage = adcCountsToMv((uint16_t)lroundf(raw[FILTER_PH])) / 1000.0f;
+    DLOG(LF_SENSORS_RESULT, (int)sensorValues[SENSOR_LIGHT], sensorValues[SENSOR_PH], voltage);
+  }
+  metricsObserve(metrics.readSensors, micros() - t0);
+  return updated;
 }
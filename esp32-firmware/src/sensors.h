@@ -3,25 +3,51 @@
 #define SENSORS_H
 
 #include "config.h"
+#include "sensor_registry.h"
 
+// Relay states; the measurements live in sensorValues (sensor_registry.h)
 struct SensorState {
-  float temp = 0.0;
-  float hum = 0.0;
-  int soil1 = 0;
-  int soil2 = 0;
-  int light = 0;
-  float ph = 7.0;
   bool pump = false;
   bool fan = false;
   bool lightOn = false;
 };
 extern SensorState state;
-extern unsigned long lastLightMeasured;
+
+// Consistent copy of sensorValues and the relay states for other tasks.
+// Writers update the globals and then publishSensorState(); readers take a
+// snapshot instead of reading the globals, so a telemetry document or LCD
+// frame never mixes two sampling passes. Neither side takes a lock: a reader
+// retries if a publish overlapped its copy, and a writer never waits on it.
+struct SensorSnapshot {
+  float values[SENSOR_COUNT];
+  SensorState relays;
+  uint32_t seq;  // advances with every publish
+};
+void publishSensorState();
+void snapshotSensorState(SensorSnapshot* out);
 
 void initSensors();
+// Sample every channel now (sensorTask samples each on its own period)
 void readSensors();
 
+// Per-channel filter parameters (settings.filters, see sensor_filter.h)
+void defaultFilterSettings();
+// Reset channels whose stored calibration is out of range; true if any was
+bool validateFilterSettings();
+// Apply a remote "filters" object; restarts the filters on the next read
+void applyFilterConfig(JsonObjectConst obj);
+// Continue an analog channel's filter from `value` (host replay: the state a
+// capture was in). Call from the thread that runs readSensors().
+void seedSensorFilter(SensorId id, float value);
+
+// Per-channel sampling periods (settings.sampling), used by sensorTask
+void defaultSamplePeriods();
+// Apply a remote "sampling" object ({"soilMs": 5000, ...})
+void applySamplingConfig(JsonObjectConst obj);
+
 // Start sensor FreeRTOS task (periodic read)
 void startSensorTask();
+// End the sensor task's current sleep (burst trigger, pump switched)
+void wakeSensorTask();
 
 #endif
\ No newline at end of file
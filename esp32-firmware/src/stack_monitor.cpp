@@ -0,0 +1,84 @@
+// stack_monitor.cpp
+#include "config.h"
+#include "stack_monitor.h"
+#include "deferred_log.h"
+
+static const char* const stackTaskNames[STK_TASK_COUNT] = {"server", "sensor", "lcd", "button",
+                                                           "eeprom", "watchdog", "log", "adc", "control"};
+static const char* const stackMacroNames[STK_TASK_COUNT] = {"SERVER", "SENSOR", "LCD", "BUTTON",
+                                                            "EEPROM", "WATCHDOG", "LOG", "ADC", "CONTROL"};
+static const uint32_t stackConfigured[STK_TASK_COUNT] = {
+    STACK_SERVER_TASK, STACK_SENSOR_TASK, STACK_LCD_TASK,  STACK_BUTTON_TASK,
+    STACK_EEPROM_TASK, STACK_WATCHDOG_TASK, STACK_LOG_TASK, STACK_ADC_TASK, STACK_CONTROL_TASK};
+
+static TaskHandle_t selfHandles[STK_TASK_COUNT];
+// lowest high-water mark seen, 0 = not sampled yet
+static uint32_t minFree[STK_TASK_COUNT];
+
+void stackTrackSelf(StackTask t) { selfHandles[t] = xTaskGetCurrentTaskHandle(); }
+
+static TaskHandle_t handleFor(uint8_t t) {
+  switch (t) {
+    case STK_SERVER: return serverTaskHandle;
+    case STK_SENSOR: return sensorTaskHandle;
+    case STK_LCD: return lcdTaskHandle;
+    case STK_BUTTON: return buttonTaskHandle;
+    default: return selfHandles[t];
+  }
+}
+
+void stackMonitorSample() {
+  for (uint8_t t = 0; t < STK_TASK_COUNT; t++) {
+    TaskHandle_t h = handleFor(t);
+    if (!h) continue;
+    // ESP-IDF reports the high-water mark in bytes, like the create sizes;
+    // an untouched stack (the host sim) tells us nothing
+    uint32_t hw = uxTaskGetStackHighWaterMark(h);
+    if (hw && hw < stackConfigured[t] && (!minFree[t] || hw < minFree[t])) minFree[t] = hw;
+  }
+}
+
+uint32_t stackPeakUse(StackTask t) {
+  if (!minFree[t]) return 0;
+  return minFree[t] < stackConfigured[t] ? stackConfigured[t] - minFree[t] : 0;
+}
+
+uint32_t stackRecommended(StackTask t) {
+  if (!minFree[t]) return stackConfigured[t];  // never observed: keep what we have
+  uint32_t used = stackPeakUse(t);
+  uint32_t margin = used * STACK_MARGIN_PCT / 100;
+  if (margin < STACK_MARGIN_MIN) margin = STACK_MARGIN_MIN;
+  uint32_t rec = (used + margin + 255) & ~255u;
+  return rec < STACK_FLOOR ? STACK_FLOOR : rec;
+}
+
+void stackMonitorReport() {
+  for (uint8_t t = 0; t < STK_TASK_COUNT; t++) {
+    if (!minFree[t]) continue;
+    DLOG(LF_STACK_PEAK, stackTaskNames[t], stackConfigured[t], stackPeakUse((StackTask)t),
+         stackRecommended((StackTask)t));
+  }
+}
+
+size_t stackHeaderWrite(char* buf, size_t len) {
+  size_t n = 0;
+  auto put = [&](int w) {
+    if (w > 0) n += (size_t)w < len - n ? (size_t)w : len - n - 1;
+  };
+  put(snprintf(buf, len,
+               "// task_stacks_gen.h - generated from stack peaks after %lu s uptime\n"
+               "// peak use + max(%d%%, %d B), rounded up to 256 B. Code paths that did not\n"
+               "// run during the soak (OTA, captive portal, ...) are not covered.\n",
+               (unsigned long)(millis() / 1000), STACK_MARGIN_PCT, STACK_MARGIN_MIN));
+  for (uint8_t t = 0; t < STK_TASK_COUNT; t++) {
+    if (minFree[t]) {
+      put(snprintf(buf + n, len - n, "#ifndef STACK_%s_TASK\n#define STACK_%s_TASK %lu  // peak %lu of %lu\n#endif\n",
+                   stackMacroNames[t], stackMacroNames[t], (unsigned long)stackRecommended((StackTask)t),
+                   (unsigned long)stackPeakUse((StackTask)t), (unsigned long)stackConfigured[t]));
+    } else {
+      put(snprintf(buf + n, len - n, "// STACK_%s_TASK not observed, keeps %lu\n", stackMacroNames[t],
+                   (unsigned long)stackConfigured[t]));
+    }
+  }
+  return n;
+}
@@ -0,0 +1,34 @@
+// stack_monitor.h
+#ifndef STACK_MONITOR_H
+#define STACK_MONITOR_H
+
+#include "config.h"
+#include "task_stacks.h"
+
+enum StackTask {
+  STK_SERVER,
+  STK_SENSOR,
+  STK_LCD,
+  STK_BUTTON,
+  STK_EEPROM,
+  STK_WATCHDOG,
+  STK_LOG,
+  STK_ADC,
+  STK_CONTROL,
+  STK_TASK_COUNT
+};
+
+// Tasks without a global handle register themselves at the top of their entry
+void stackTrackSelf(StackTask t);
+// Read every task's high-water mark and keep the lowest seen since boot
+// (watchdogTask)
+void stackMonitorSample();
+// bytes of stack the task has used at its deepest, 0 until first sampled
+uint32_t stackPeakUse(StackTask t);
+uint32_t stackRecommended(StackTask t);
+// "[STACK]" line per task (scripts/stack_header.py turns them into a header)
+void stackMonitorReport();
+// task_stacks_gen.h contents with the current recommendations
+size_t stackHeaderWrite(char* buf, size_t len);
+
+#endif
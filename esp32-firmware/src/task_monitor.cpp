@@ -0,0 +1,151 @@
+// task_monitor.cpp
+#include "config.h"
+#include "task_monitor.h"
+#include <esp_freertos_hooks.h>
+
+const char* const monitoredTaskNames[MON_TASK_COUNT] = {"server", "sensor", "lcd", "button", "eeprom"};
+
+TaskMonitorReport taskReport = {{-1, -1}, {-1, -1, -1, -1, -1}, {0}, 0};
+
+static TaskHandle_t loopHandles[MON_TASK_COUNT];
+static uint32_t lastHead[MON_TASK_COUNT];
+static uint32_t maxGap[MON_TASK_COUNT];
+static uint32_t windowStart = 0;
+static portMUX_TYPE monMux = portMUX_INITIALIZER_UNLOCKED;
+
+void taskLoopHead(MonitoredTask t) {
+  uint32_t now = millis();
+  portENTER_CRITICAL(&monMux);
+  loopHandles[t] = xTaskGetCurrentTaskHandle();
+  if (lastHead[t] && now - lastHead[t] > maxGap[t]) maxGap[t] = now - lastHead[t];
+  lastHead[t] = now;
+  portEXIT_CRITICAL(&monMux);
+}
+
+// Core load from the idle tasks, since the stock Arduino-ESP32 core is built
+// without run-time stats. Each core's idle hook adds the time since its
+// previous call when that was under CPU_IDLE_SLICE_US, i.e. nothing else ran
+// in between. The hook returns false so the idle task keeps looping rather
+// than waiting for an interrupt, which would hide those gaps; that gives up
+// the small saving of the idle WAITI.
+#define CPU_IDLE_SLICE_US 50
+static volatile uint32_t idleUs[2];  // written by that core's idle task only
+static uint32_t lastIdleCall[2];
+static uint32_t prevIdleUs[2];
+static bool idleHooked = false;
+
+static bool idleHook(uint8_t core) {
+  uint32_t now = micros();
+  uint32_t d = now - lastIdleCall[core];
+  if (d < CPU_IDLE_SLICE_US) idleUs[core] += d;
+  lastIdleCall[core] = now;
+  return false;
+}
+static bool idleHook0() { return idleHook(0); }
+static bool idleHook1() { return idleHook(1); }
+
+static void sampleIdle(uint32_t windowMs) {
+  for (uint8_t core = 0; core < 2; core++) {
+    uint32_t idle = idleUs[core];
+    uint32_t d = idle - prevIdleUs[core];
+    prevIdleUs[core] = idle;
+    if (!idleHooked || !windowMs) {
+      taskReport.corePct[core] = -1;
+      continue;
+    }
+    uint32_t idlePct = d / 10 / windowMs;  // d in us
+    taskReport.corePct[core] = (int8_t)(idlePct >= 100 ? 0 : 100 - idlePct);
+  }
+}
+
+#if configGENERATE_RUN_TIME_STATS && configUSE_TRACE_FACILITY
+// run-time counters from the previous window, matched by handle
+#define MON_MAX_TASKS 24
+static TaskStatus_t taskStatus[MON_MAX_TASKS];
+static TaskHandle_t prevHandle[MON_MAX_TASKS];
+static uint32_t prevRunTime[MON_MAX_TASKS];
+static UBaseType_t prevCount = 0;
+static uint32_t prevTotal = 0;
+
+static uint32_t runTimeDelta(TaskHandle_t h, uint32_t runTime) {
+  for (UBaseType_t i = 0; i < prevCount; i++) {
+    if (prevHandle[i] == h) return runTime - prevRunTime[i];
+  }
+  return runTime;  // task started during the window
+}
+
+static int8_t pct(uint32_t part, uint32_t whole) {
+  if (!whole) return -1;
+  uint32_t p = (uint32_t)((uint64_t)part * 100 / whole);
+  return (int8_t)(p > 100 ? 100 : p);
+}
+
+static void sampleRunTimeStats() {
+  uint32_t total = 0;
+  UBaseType_t n = uxTaskGetSystemState(taskStatus, MON_MAX_TASKS, &total);
+  if (n == 0) return;  // more tasks than MON_MAX_TASKS
+  // the run-time clock is shared, so elapsed time is each core's capacity
+  uint32_t elapsed = total - prevTotal;
+  bool first = (prevCount == 0);
+
+  for (uint8_t t = 0; t < MON_TASK_COUNT; t++) {
+    taskReport.taskPct[t] = -1;
+    for (UBaseType_t i = 0; i < n && !first; i++) {
+      if (loopHandles[t] && taskStatus[i].xHandle == loopHandles[t]) {
+        taskReport.taskPct[t] = pct(runTimeDelta(loopHandles[t], taskStatus[i].ulRunTimeCounter), elapsed);
+      }
+    }
+  }
+
+  for (UBaseType_t i = 0; i < n; i++) {
+    prevHandle[i] = taskStatus[i].xHandle;
+    prevRunTime[i] = taskStatus[i].ulRunTimeCounter;
+  }
+  prevCount = n;
+  prevTotal = total;
+}
+#endif
+
+void taskMonitorUpdate() {
+  uint32_t now = millis();
+  portENTER_CRITICAL(&monMux);
+  for (uint8_t t = 0; t < MON_TASK_COUNT; t++) {
+    // a task stuck right now counts up to this moment
+    uint32_t gap = maxGap[t];
+    if (lastHead[t] && now - lastHead[t] > gap) gap = now - lastHead[t];
+    taskReport.maxGapMs[t] = gap;
+    maxGap[t] = 0;
+  }
+  portEXIT_CRITICAL(&monMux);
+  taskReport.windowMs = now - windowStart;
+  windowStart = now;
+  // the first window only starts the count
+  sampleIdle(taskReport.windowMs);
+  if (!idleHooked) {
+    idleHooked = esp_register_freertos_idle_hook_for_cpu(idleHook0, 0) == ESP_OK &&
+                 esp_register_freertos_idle_hook_for_cpu(idleHook1, 1) == ESP_OK;
+  }
+#if configGENERATE_RUN_TIME_STATS && configUSE_TRACE_FACILITY
+  sampleRunTimeStats();
+#endif
+}
+
+void taskMonitorToJson(JsonObject obj, bool perTask) {
+  if (taskReport.corePct[0] >= 0) {
+    JsonArray cpu = obj.createNestedArray("cpu");
+    cpu.add(taskReport.corePct[0]);
+    cpu.add(taskReport.corePct[1]);
+  }
+#if configGENERATE_RUN_TIME_STATS && configUSE_TRACE_FACILITY
+  if (perTask) {
+    JsonObject tc = obj.createNestedObject("taskCpu");
+    for (uint8_t t = 0; t < MON_TASK_COUNT; t++) {
+      if (taskReport.taskPct[t] >= 0) tc[monitoredTaskNames[t]] = taskReport.taskPct[t];
+    }
+  }
+#else
+  (void)perTask;
+#endif
+  JsonObject gaps = obj.createNestedObject("loopGapMs");
+  for (uint8_t t = 0; t < MON_TASK_COUNT; t++) gaps[monitoredTaskNames[t]] = taskReport.maxGapMs[t];
+}
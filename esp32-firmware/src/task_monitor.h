@@ -0,0 +1,36 @@
+// task_monitor.h
+#ifndef TASK_MONITOR_H
+#define TASK_MONITOR_H
+
+#include "config.h"
+
+enum MonitoredTask {
+  MON_SERVER,
+  MON_SENSOR,
+  MON_LCD,
+  MON_BUTTON,
+  MON_EEPROM,
+  MON_TASK_COUNT
+};
+extern const char* const monitoredTaskNames[MON_TASK_COUNT];
+
+// Call at the top of every loop iteration of the monitored task
+void taskLoopHead(MonitoredTask t);
+
+// Results of the last watchdog window. corePct comes from idle hooks and is
+// -1 until they have covered a full window; taskPct needs a core built with
+// FreeRTOS run-time stats and is -1 otherwise.
+struct TaskMonitorReport {
+  int8_t corePct[2];
+  int8_t taskPct[MON_TASK_COUNT];
+  uint32_t maxGapMs[MON_TASK_COUNT];  // longest stretch without reaching the loop head
+  uint32_t windowMs;
+};
+extern TaskMonitorReport taskReport;
+
+// Close the current window and start the next one (watchdogTask)
+void taskMonitorUpdate();
+// Add "cpu", optionally "taskCpu", and "loopGapMs" to a JSON object
+void taskMonitorToJson(JsonObject obj, bool perTask);
+
+#endif
@@ -0,0 +1,53 @@
+// task_stacks.h
+// Stack size in bytes for every firmware task. A header generated from a soak
+// run (GET /stacks, or scripts/stack_header.py on a serial capture) saved as
+// src/task_stacks_gen.h takes precedence over the defaults below; -D flags
+// take precedence over both.
+#ifndef TASK_STACKS_H
+#define TASK_STACKS_H
+
+#if __has_include("task_stacks_gen.h")
+#include "task_stacks_gen.h"
+#endif
+
+#ifndef STACK_SERVER_TASK
+#define STACK_SERVER_TASK 12288
+#endif
+#ifndef STACK_SENSOR_TASK
+#define STACK_SENSOR_TASK 4096
+#endif
+#ifndef STACK_LCD_TASK
+#define STACK_LCD_TASK 8192
+#endif
+#ifndef STACK_BUTTON_TASK
+#define STACK_BUTTON_TASK 4096
+#endif
+#ifndef STACK_EEPROM_TASK
+#define STACK_EEPROM_TASK 4096
+#endif
+#ifndef STACK_WATCHDOG_TASK
+#define STACK_WATCHDOG_TASK 4096
+#endif
+#ifndef STACK_LOG_TASK
+#define STACK_LOG_TASK 3072
+#endif
+#ifndef STACK_ADC_TASK
+#define STACK_ADC_TASK 3072
+#endif
+#ifndef STACK_CONTROL_TASK
+#define STACK_CONTROL_TASK 3072
+#endif
+
+// Recommended size = peak use + max(STACK_MARGIN_PCT %, STACK_MARGIN_MIN),
+// rounded up to 256 bytes and never below STACK_FLOOR
+#ifndef STACK_MARGIN_PCT
+#define STACK_MARGIN_PCT 25
+#endif
+#ifndef STACK_MARGIN_MIN
+#define STACK_MARGIN_MIN 1024
+#endif
+#ifndef STACK_FLOOR
+#define STACK_FLOOR 2048
+#endif
+
+#endif
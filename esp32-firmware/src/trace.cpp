@@ -0,0 +1,122 @@
+// trace.cpp
+#include "config.h"
+#include "trace.h"
+#include <stdarg.h>
+
+// Timestamps come from micros() (esp_timer), which both cores share; the
+// per-core CCOUNT registers are not aligned with each other and wrap every
+// ~18 s at 240 MHz, so they cannot place spans from two cores on one timeline.
+struct TraceEvent {
+  uint32_t tsUs;
+  const char* name;
+  TaskHandle_t task;
+  uint8_t phase;  // 'B' or 'E'
+  uint8_t core;
+};
+
+static TraceEvent events[TRACE_EVENTS];
+static uint32_t traceNext = 0;  // events recorded so far; slot is traceNext % TRACE_EVENTS
+static volatile bool tracePaused = false;
+static portMUX_TYPE traceMux = portMUX_INITIALIZER_UNLOCKED;
+
+static void record(const char* name, uint8_t phase) {
+  TaskHandle_t task = xTaskGetCurrentTaskHandle();
+  uint8_t core = (uint8_t)xPortGetCoreID();
+  portENTER_CRITICAL(&traceMux);
+  if (tracePaused) {
+    portEXIT_CRITICAL(&traceMux);
+    return;
+  }
+  TraceEvent& e = events[traceNext % TRACE_EVENTS];
+  traceNext++;
+  e.tsUs = micros();
+  e.name = name;
+  e.task = task;
+  e.phase = phase;
+  e.core = core;
+  portEXIT_CRITICAL(&traceMux);
+}
+
+void traceBegin(const char* name) { record(name, 'B'); }
+
+void traceEnd(const char* name) { record(name, 'E'); }
+
+// ---- dump ----
+// Output state lives on the dumping task's stack; tracePaused doubles as the
+// busy flag, so a second dump (serial 'T' on loopTask, /trace on serverTask)
+// is turned away instead of sharing it.
+struct TraceOut {
+  void (*write)(const char*, size_t);
+  size_t len;
+  char buf[256];
+};
+
+static void outFlush(TraceOut& out) {
+  if (out.len) out.write(out.buf, out.len);
+  out.len = 0;
+}
+
+static void outf(TraceOut& out, const char* fmt, ...) {
+  for (int pass = 0; pass < 2; pass++) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(out.buf + out.len, sizeof(out.buf) - out.len, fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if (out.len + n < sizeof(out.buf)) {
+      out.len += n;
+      return;
+    }
+    outFlush(out);
+  }
+  out.len = sizeof(out.buf) - 1;
+}
+
+bool traceDump(void (*write)(const char* data, size_t len)) {
+  portENTER_CRITICAL(&traceMux);
+  if (tracePaused) {
+    portEXIT_CRITICAL(&traceMux);
+    return false;
+  }
+  tracePaused = true;
+  uint32_t end = traceNext;
+  portEXIT_CRITICAL(&traceMux);
+  uint32_t count = end < TRACE_EVENTS ? end : TRACE_EVENTS;
+  uint32_t first = end - count;
+  uint32_t baseUs = count ? events[first % TRACE_EVENTS].tsUs : 0;
+
+  TraceOut out;
+  out.write = write;
+  out.len = 0;
+  // ts is relative to the oldest event so micros() wrap cannot reorder spans
+  outf(out, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"fw\":\"%s\",\"baseMicros\":%u,\"uptimeMs\":%lu},"
+            "\"traceEvents\":[", FIRMWARE_VERSION, baseUs, millis());
+
+  // pid = core, tid = task; name both so the timeline reads "core 1 / SensorTask"
+  TaskHandle_t tasks[16];
+  uint8_t numTasks = 0;
+  const char* sep = "";
+  for (uint8_t core = 0; core < 2; core++) {
+    outf(out, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"name\":\"core %u\"}}", sep, core,
+              core);
+    sep = ",";
+  }
+  for (uint32_t i = first; i < end; i++) {
+    const TraceEvent& e = events[i % TRACE_EVENTS];
+    uint8_t tid = 0;
+    while (tid < numTasks && tasks[tid] != e.task) tid++;
+    if (tid == numTasks && numTasks < 16) {
+      tasks[numTasks++] = e.task;
+      outf(out, ",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", e.core,
+                tid + 1, e.task ? pcTaskGetName(e.task) : "main");
+    }
+    outf(out, ",{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%u,\"pid\":%u,\"tid\":%u}", e.name, e.phase,
+              e.tsUs - baseUs, e.core, tid + 1);
+  }
+  outf(out, "]}\n");
+  outFlush(out);
+  portENTER_CRITICAL(&traceMux);
+  tracePaused = false;
+  portEXIT_CRITICAL(&traceMux);
+  return true;
+}
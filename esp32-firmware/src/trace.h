@@ -0,0 +1,35 @@
+// trace.h
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "config.h"
+
+// Span tracing into a fixed RAM ring buffer, dumped as Chrome trace_event
+// JSON (load in chrome://tracing or ui.perfetto.dev). Each event is 16 bytes;
+// build with -DTRACE_DISABLED to compile the spans out.
+#ifndef TRACE_EVENTS
+#define TRACE_EVENTS 512
+#endif
+
+// name must be a string literal (only the pointer is stored)
+void traceBegin(const char* name);
+void traceEnd(const char* name);
+
+// Stream the buffer as JSON through write(); tracing pauses meanwhile.
+// False, with nothing written, if another task is dumping already.
+bool traceDump(void (*write)(const char* data, size_t len));
+
+struct TraceSpan {
+  const char* name;
+  explicit TraceSpan(const char* n) : name(n) { traceBegin(name); }
+  ~TraceSpan() { traceEnd(name); }
+};
+
+#ifdef TRACE_DISABLED
+#define TRACE_SPAN(name)
+#else
+// one per scope: spans from the macro to the end of the enclosing block
+#define TRACE_SPAN(name) TraceSpan traceSpan_(name)
+#endif
+
+#endif
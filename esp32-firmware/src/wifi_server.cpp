@@ -7,6 +7,16 @@
 #include "ota_update.h"
 #include "lcd_menu.h"
 #include "mqtt_client.h"
+#include "metrics.h"
+#include "trace.h"
+#include "task_monitor.h"
+#include "deferred_log.h"
+#include "boot_timeline.h"
+#include "stack_monitor.h"
+#include "sensor_power.h"
+#include "sensor_stats.h"
+#include "burst_capture.h"
+#include "alerts.h"
 #include <WebServer.h>
 #include <ArduinoJson.h>
 #include <LittleFS.h>
@@ -20,7 +30,16 @@ WebServer* webServer = NULL;
 
 // file-scoped reusable buffers to avoid large stack allocations in serverTask
 static char g_responseBuf[1024];
-static char g_payloadBuf[512];
+static char g_payloadBuf[1536];
+// JSON documents reused every cycle instead of heap-allocated per call.
+// g_respDoc serves handleServerComm and /apply_config, both run by serverTask.
+static StaticJsonDocument<3072> g_telemetryDoc;
+static StaticJsonDocument<4096> g_respDoc;
+
+// IP/MAC as text, refreshed on (re)connect rather than formatted into
+// Strings for every telemetry message
+char deviceIP[16] = "0.0.0.0";
+char deviceMAC[18] = "";
 
 // Telemetry queue - serverTask will process telemetry requests so network operations are isolated
 typedef uint32_t TelemetryReq;
@@ -32,58 +51,58 @@ unsigned long lastTelemetrySent = 0;
 // when true, include full settings in next telemetry and ask server to persist
 volatile bool telemetryPersistConfig = false;
 
-// Failed payload retry queue (in-memory ring buffer)
-struct FailedPayload {
-  char data[512];
-  size_t len;
-  uint32_t ts;
-};
-static FailedPayload failedQueue[5];
+// Failed payload retry queue: a ring of FAILED_SLOTS LittleFS files, each a
+// sequence number line followed by the payload. Only the ring position is
+// kept in RAM; a retry reads its payload back into g_payloadBuf, which
+// handleServerComm() only fills afterwards.
+#define FAILED_SLOTS 5
 static int failedHead = 0;
-static int failedTail = 0;
 static int failedCount = 0;
+static uint32_t failedNextSeq = 1;
 
-// track LittleFS mount state to avoid repeated mount attempts
-static bool littlefsAvailable = false;
-static bool littlefsFormatTried = false;
-
-static bool ensureLittleFS() {
-  if (littlefsAvailable) return true;
-  if (LittleFS.begin()) {
-    littlefsAvailable = true;
-    return true;
-  }
-  // do not auto-format LittleFS here — formatting would erase identity.json
-  // Log the failure and return; formatting must be an explicit admin action.
-  if (!littlefsFormatTried) {
-    littlefsFormatTried = true;
-    Serial.println("LittleFS mount failed; not formatting automatically.");
-  }
-  return false;
+static void failedSlotPath(char* path, size_t size, int slot) {
+  snprintf(path, size, "/failed%d.txt", slot);
 }
 
 static void enqueueFailedPayload(const char* data, size_t len) {
-  if (failedCount >= 5) return; // drop if full
-  int idx = failedTail;
-  memcpy(failedQueue[idx].data, data, len);
-  failedQueue[idx].len = len;
-  failedQueue[idx].ts = millis();
-  failedTail = (failedTail + 1) % 5;
-  failedCount++;
-  // persist to LittleFS if available (avoid repeated errors when FS not mounted)
-  if (ensureLittleFS()) {
-    DynamicJsonDocument doc(2048);
-    JsonArray arr = doc.to<JsonArray>();
-    for (int i = 0; i < failedCount; i++) {
-      int p = (failedHead + i) % 5;
-      arr.add(String(failedQueue[p].data).substring(0, failedQueue[p].len));
-    }
-    File f = LittleFS.open("/failed_payloads.json", "w");
-    if (f) {
-      serializeJson(doc, f);
-      f.close();
-    }
+  if (failedCount >= FAILED_SLOTS) return; // drop if full
+  // without the filesystem there is nowhere to keep it
+  if (!ensureLittleFS()) return;
+  char path[20];
+  failedSlotPath(path, sizeof(path), (failedHead + failedCount) % FAILED_SLOTS);
+  File f = LittleFS.open(path, "w");
+  if (!f) return;
+  f.printf("%lu\n", (unsigned long)failedNextSeq);
+  bool ok = f.write((const uint8_t*)data, len) == len;
+  f.close();
+  if (!ok) {
+    LittleFS.remove(path);
+    return;
   }
+  failedNextSeq++;
+  failedCount++;
+}
+
+// Payload of a slot into buf, NUL-terminated; 0 if missing or too long
+static size_t readFailedSlot(int slot, char* buf, size_t size) {
+  char path[20];
+  failedSlotPath(path, sizeof(path), slot);
+  File f = LittleFS.open(path, "r");
+  if (!f) return 0;
+  while (f.available() && f.read() != '\n') {}
+  size_t len = f.readBytes(buf, size - 1);
+  bool whole = !f.available();
+  f.close();
+  buf[len] = '\0';
+  return whole ? len : 0;
+}
+
+static void dropFailedHead() {
+  char path[20];
+  failedSlotPath(path, sizeof(path), failedHead);
+  LittleFS.remove(path);
+  failedHead = (failedHead + 1) % FAILED_SLOTS;
+  failedCount--;
 }
 
 static bool retryFailedPayloads() {
@@ -91,28 +110,24 @@ static bool retryFailedPayloads() {
   bool anySuccess = false;
   int attempts = failedCount;
   while (attempts-- > 0 && failedCount > 0) {
-    int idx = failedHead;
+    size_t len = readFailedSlot(failedHead, g_payloadBuf, sizeof(g_payloadBuf));
+    if (!len) {
+      dropFailedHead();
+      continue;
+    }
     HTTPClient http2;
     char url2[128];
     snprintf(url2, sizeof(url2), "http://%s/api/v1/agents/%s/status", SERVER_IP, settings.deviceID);
     http2.begin(url2);
     http2.addHeader("Content-Type", "application/json");
     http2.addHeader("X-Device-Token", settings.token);
-    int code2 = http2.POST((uint8_t*)failedQueue[idx].data, failedQueue[idx].len);
+    uint32_t t0 = micros();
+    int code2 = http2.POST((uint8_t*)g_payloadBuf, len);
+    metricsObserve(metrics.httpPost, micros() - t0);
+    metricsCountHttpResult(code2);
     http2.end();
     if (code2 == 200) {
-      // remove head
-      failedHead = (failedHead + 1) % 5;
-      failedCount--;
-      // persist updated queue
-      DynamicJsonDocument doc(4096);
-      JsonArray arr = doc.to<JsonArray>();
-      for (int i = 0; i < failedCount; i++) {
-        int p = (failedHead + i) % 5;
-        arr.add(String(failedQueue[p].data).substring(0, failedQueue[p].len));
-      }
-      File f = LittleFS.open("/failed_payloads.json", "w");
-      if (f) { serializeJson(doc, f); f.close(); }
+      dropFailedHead();
       anySuccess = true;
     } else {
       // if still fails, stop retrying to avoid hammering
@@ -122,28 +137,77 @@ static bool retryFailedPayloads() {
   return anySuccess;
 }
 
-// Load failed payloads from LittleFS into memory queue (call at boot)
-void loadFailedQueueFromFS() {
-  if (!ensureLittleFS()) return;
-  if (!LittleFS.exists("/failed_payloads.json")) return;
-  File f = LittleFS.open("/failed_payloads.json", "r");
+// Older builds kept the queue as one JSON array of strings in RAM and
+// mirrored it to this file; move its entries into slots.
+static void migrateFailedQueueFile() {
+  const char* legacy = "/failed_payloads.json";
+  if (!LittleFS.exists(legacy)) return;
+  File f = LittleFS.open(legacy, "r");
   if (!f) return;
-  DynamicJsonDocument doc(4096);
+  // the strings are copied out of the stream, so the file size plus the
+  // array slots bounds what the document needs
+  size_t size = f.size();
+  DynamicJsonDocument doc(size + 256);
   DeserializationError err = deserializeJson(doc, f);
   f.close();
-  if (err) return;
-  JsonArray arr = doc.as<JsonArray>();
-  for (JsonVariant v : arr) {
-    if (failedCount >= 5) break;
-    const char* s = v.as<const char*>();
-    size_t l = strlen(s);
-    int idx = failedTail;
-    memcpy(failedQueue[idx].data, s, l);
-    failedQueue[idx].len = l;
-    failedQueue[idx].ts = millis();
-    failedTail = (failedTail + 1) % 5;
-    failedCount++;
+  if (err) {
+    Serial.printf("[FAILQ] %s: %s, %u bytes dropped\n", legacy, err.c_str(), (unsigned)size);
+  } else {
+    for (JsonVariant v : doc.as<JsonArray>()) {
+      const char* s = v.as<const char*>();
+      if (s) enqueueFailedPayload(s, strlen(s));
+    }
+  }
+  LittleFS.remove(legacy);
+}
+
+// Rebuild the ring from the slot files (call at boot): the head is the
+// oldest sequence number, and the queue runs on through consecutive ones.
+void loadFailedQueueFromFS() {
+  if (!ensureLittleFS()) return;
+  uint32_t seq[FAILED_SLOTS] = {0};
+  int oldest = -1;
+  for (int slot = 0; slot < FAILED_SLOTS; slot++) {
+    char path[20];
+    failedSlotPath(path, sizeof(path), slot);
+    File f = LittleFS.open(path, "r");
+    if (!f) continue;
+    uint32_t n = 0;
+    int c;
+    while ((c = f.read()) >= '0' && c <= '9') n = n * 10 + (uint32_t)(c - '0');
+    f.close();
+    if (c != '\n' || !n) {
+      LittleFS.remove(path);
+      continue;
+    }
+    seq[slot] = n;
+    if (oldest < 0 || n < seq[oldest]) oldest = slot;
+  }
+  failedHead = 0;
+  failedCount = 0;
+  if (oldest >= 0) {
+    failedHead = oldest;
+    while (failedCount < FAILED_SLOTS) {
+      int slot = (oldest + failedCount) % FAILED_SLOTS;
+      if (seq[slot] != seq[oldest] + (uint32_t)failedCount) break;
+      failedCount++;
+    }
+    failedNextSeq = seq[oldest] + (uint32_t)failedCount;
+    // anything off the run cannot be placed in order
+    for (int i = failedCount; i < FAILED_SLOTS; i++) {
+      int slot = (oldest + i) % FAILED_SLOTS;
+      if (!seq[slot]) continue;
+      char path[20];
+      failedSlotPath(path, sizeof(path), slot);
+      LittleFS.remove(path);
+    }
   }
+  migrateFailedQueueFile();
+  if (failedCount) Serial.printf("[FAILQ] %d payload(s) waiting for retry\n", failedCount);
+}
+
+int failedPayloadCount() {
+  return failedCount;
 }
 
 void initTelemetryQueue() {
@@ -177,13 +241,28 @@ void feedWatchdog() {
   esp_task_wdt_reset();
 }
 
+void refreshNetIdentity() {
+  IPAddress ip = WiFi.localIP();
+  snprintf(deviceIP, sizeof(deviceIP), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+  uint8_t mac[6];
+  WiFi.macAddress(mac);
+  snprintf(deviceMAC, sizeof(deviceMAC), "%02X:%02X:%02X:%02X:%02X:%02X",
+           mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
 void connectWiFi() {
   Serial.println("Reset WiFi state...");
 
-  WiFi.mode(WIFI_OFF);
-  delay(1000);
+  // the radio is still off on the first join after boot; only a retry needs
+  // the full reset
+  static bool radioStarted = false;
+  if (radioStarted) {
+    WiFi.mode(WIFI_OFF);
+    delay(1000);
+  }
   WiFi.mode(WIFI_STA);
-  delay(500);
+  if (radioStarted) delay(500);
+  radioStarted = true;
 
   Serial.printf("SSID=[%s] len=%d\n", settings.ssid, strlen(settings.ssid));
   Serial.printf("PASS len=%d\n", strlen(settings.pass));
@@ -202,11 +281,13 @@ void connectWiFi() {
 
   if (WiFi.status() == WL_CONNECTED) {
     Serial.println("Ket noi WiFi thanh cong");
+    bootMark(BOOT_WIFI);
+    refreshNetIdentity();
     // Request LCD update via queue (do not access LCD directly)
     char l0[21];
     char l1[21];
     snprintf(l0, sizeof(l0), "WiFi OK           ");
-    snprintf(l1, sizeof(l1), "%s", WiFi.localIP().toString().c_str());
+    snprintf(l1, sizeof(l1), "%s", deviceIP);
     lcdPostLine(0, l0);
     lcdPostLine(1, l1);
     // start small debug web server if not already
@@ -214,25 +295,62 @@ void connectWiFi() {
       webServer = new WebServer(80);
       webServer->on("/debug", HTTP_GET, []() {
         char buf[512];
-        size_t freeHeap = ESP.getFreeHeap();
         unsigned int sServer = serverTaskHandle ? uxTaskGetStackHighWaterMark(serverTaskHandle) : 0;
         unsigned int sLCD = lcdTaskHandle ? uxTaskGetStackHighWaterMark(lcdTaskHandle) : 0;
         unsigned int sBtn = buttonTaskHandle ? uxTaskGetStackHighWaterMark(buttonTaskHandle) : 0;
         unsigned int sSensor = sensorTaskHandle ? uxTaskGetStackHighWaterMark(sensorTaskHandle) : 0;
-        snprintf(buf, sizeof(buf), "{\"freeHeap\":%u,\"serverStackHigh\":%u,\"lcdStackHigh\":%u,\"btnStackHigh\":%u,\"sensorStackHigh\":%u,\"uptimeMs\":%lu}", (unsigned)freeHeap, sServer, sLCD, sBtn, sSensor, millis());
+        StaticJsonDocument<512> doc;
+        doc["freeHeap"] = (unsigned)ESP.getFreeHeap();
+        doc["serverStackHigh"] = sServer;
+        doc["lcdStackHigh"] = sLCD;
+        doc["btnStackHigh"] = sBtn;
+        doc["sensorStackHigh"] = sSensor;
+        doc["uptimeMs"] = millis();
+        // CPU and loop-gap figures from the last watchdog window
+        taskMonitorToJson(doc.as<JsonObject>(), true);
+        serializeJson(doc, buf, sizeof(buf));
         webServer->send(200, "application/json", buf);
       });
+      // recommended task stack sizes as a header: curl .../stacks > src/task_stacks_gen.h
+      webServer->on("/stacks", HTTP_GET, []() {
+        static char hdr[1024];
+        stackMonitorSample();
+        stackHeaderWrite(hdr, sizeof(hdr));
+        webServer->send(200, "text/plain", hdr);
+      });
+      webServer->on("/metrics", HTTP_GET, []() {
+        metricsHandleRequest(*webServer);
+      });
+      webServer->on("/trace", HTTP_GET, []() {
+        // headers go out with the first chunk, so a busy dump can still get a 503
+        static bool started;
+        started = false;
+        bool dumped = traceDump([](const char* data, size_t len) {
+          if (!started) {
+            started = true;
+            webServer->setContentLength(CONTENT_LENGTH_UNKNOWN);
+            webServer->send(200, "application/json", "");
+          }
+          webServer->sendContent(data, len);
+        });
+        if (!dumped) {
+          webServer->send(503, "application/json", "{\"error\":\"trace dump in progress\"}");
+          return;
+        }
+        webServer->sendContent("", 0);
+      });
       // allow backend to push config immediately
       webServer->on("/apply_config", HTTP_POST, []() {
-        String body = webServer->arg("plain");
+        // arg() returns the body by value (a WebServer copy); parse that one
+        // copy into the shared document rather than adding more
+        const String& body = webServer->arg("plain");
         Serial.printf("[/apply_config] body len=%u\n", body.length());
         if (body.length() == 0) {
           webServer->send(400, "application/json", "{\"error\":\"empty body\"}");
           return;
         }
-          // Use heap-allocated JSON to avoid stack overflow in serverTask
-          DynamicJsonDocument doc(4096);
-          DeserializationError err = deserializeJson(doc, body);
+        StaticJsonDocument<4096>& doc = g_respDoc;
+        DeserializationError err = deserializeJson(doc, body);
         if (err) {
           Serial.printf("[/apply_config] json error: %s\n", err.c_str());
           // return 400 so backend knows it's bad format
@@ -318,6 +436,7 @@ void connectWiFi() {
           if (!settings.lightAuto) { state.lightOn = l; digitalWrite(RELAY_LIGHT, state.lightOn); }
           else Serial.println("[/apply_config] Ignoring remote light command because lightAuto is enabled");
         }
+        publishSensorState();
         if (doc.containsKey("deepSleep")) {
           bool ds = doc["deepSleep"].as<bool>();
           settings.deepSleep = ds;
@@ -370,12 +489,24 @@ void connectWiFi() {
         if (doc.containsKey("mqttUseTLS")) {
           settings.mqttUseTLS = doc["mqttUseTLS"].as<bool>();
         }
+        if (doc.containsKey("filters")) applyFilterConfig(doc["filters"].as<JsonObjectConst>());
+        if (doc.containsKey("sampling")) applySamplingConfig(doc["sampling"].as<JsonObjectConst>());
+        if (doc.containsKey("stats")) applyStatsConfig(doc["stats"].as<JsonObjectConst>());
+        if (doc.containsKey("burst")) applyBurstConfig(doc["burst"].as<JsonObjectConst>());
+        if (doc.containsKey("rules")) applyRuleConfig(doc["rules"].as<JsonArrayConst>());
+        if (doc.containsKey("alerts")) applyAlertConfig(doc["alerts"].as<JsonArrayConst>());
+        // deferred log filter and UDP sink (runtime only, not persisted)
+        if (doc.containsKey("logLevel")) logLevel = doc["logLevel"].as<uint8_t>();
+        if (doc.containsKey("logUdpHost")) {
+          uint16_t port = doc.containsKey("logUdpPort") ? doc["logUdpPort"].as<uint16_t>() : 5514;
+          logSetUdp(doc["logUdpHost"].as<const char*>(), port);
+        }
 
         // persist immediately to EEPROM so web changes survive restarts
         saveSettingsNow();
         // Re-init MQTT to pick up any updated runtime MQTT settings
         mqtt_init();
-        controlRelays();
+        controlNotifyConfig();
         // request immediate UI refresh (do not overwrite other menus)
         if (menuState == MAIN_SCREEN) drawMainScreen(); else needMainRefresh = true;
         webServer->send(200, "application/json", "{\"ok\":true}");
@@ -398,42 +529,22 @@ void connectWiFi() {
   }
 }
 
-void handleServerComm() {
-  if (WiFi.status() != WL_CONNECTED) return;
-
-  feedWatchdog();
-  // attempt to resend any failed payloads first (non-blocking, limited)
-  retryFailedPayloads();
-
-  HTTPClient http;
-  http.setTimeout(10000);
-  // Send telemetry to backend agent status endpoint and include device token for auth
-  char url[160];
-  // include explicit port so device connects to intended service
-  snprintf(url, sizeof(url), "http://%s:%d/api/v1/agents/%s/status", SERVER_IP, SERVER_PORT, settings.deviceID);
-  Serial.printf("[HTTP] POST %s\n", url);
-  http.begin(url);
-  http.addHeader("Content-Type", "application/json");
-  http.addHeader("X-Device-Token", settings.token);
-  // close connection after request to avoid keep-alive/socket reuse issues
-  http.addHeader("Connection", "close");
-
-  DynamicJsonDocument doc(768);
-  doc["id"] = settings.deviceID;
-  doc["temp"] = state.temp;
-  doc["hum"] = state.hum;
-  doc["soil1"] = state.soil1;
-  doc["soil2"] = state.soil2;
-  doc["light"] = state.light;
-  doc["ph"] = state.ph;
+// Serialize the telemetry document posted to /api/v1/agents/<id>/status
+size_t buildTelemetryPayload(char* buf, size_t size) {
+  StaticJsonDocument<3072>& doc = g_telemetryDoc;
+  doc.clear();
+  SensorSnapshot snap;
+  snapshotSensorState(&snap);
+  doc["id"] = (const char*)settings.deviceID;
+  sensorsToJson(doc.as<JsonObject>(), snap.values);
   // include local IP and MAC so backend records correct reachable address and identity
-  doc["ip"] = WiFi.localIP().toString();
-  doc["mac"] = WiFi.macAddress();
+  doc["ip"] = (const char*)deviceIP;
+  doc["mac"] = (const char*)deviceMAC;
   doc["fw"] = FIRMWARE_VERSION;
   doc["deepSleep"] = settings.deepSleep;
-  doc["pump"] = state.pump;
-  doc["fan"] = state.fan;
-  doc["lightOn"] = state.lightOn;
+  doc["pump"] = snap.relays.pump;
+  doc["fan"] = snap.relays.fan;
+  doc["lightOn"] = snap.relays.lightOn;
   // include auto-mode flags and override state
   doc["pumpAuto"] = settings.pumpAuto;
   doc["fanAuto"] = settings.fanAuto;
@@ -457,22 +568,59 @@ void handleServerComm() {
   doc["uptimeMs"] = millis();
   extern unsigned long eepromWriteCount; // declared in eeprom_utils.h
   doc["eepromWrites"] = eepromWriteCount;
+  sensorPowerToJson(doc.as<JsonObject>());
+  // per-channel summaries of the 1 and 15 min windows, once each
+  static uint32_t statsSent[STATS_WINDOW_COUNT];
+  statsToJson(doc.as<JsonObject>(), statsSent);
+  taskMonitorToJson(doc.as<JsonObject>(), false);
+  alertsToJson(doc.as<JsonObject>());
+  // boot phase timestamps, until the backend has acknowledged them once
+  bootTimelineToJson(doc.as<JsonObject>());
+
+  return serializeJson(doc, buf, size);
+}
+
+void handleServerComm() {
+  if (WiFi.status() != WL_CONNECTED) return;
+  TRACE_SPAN("handleServerComm");
 
-  size_t len = serializeJson(doc, g_payloadBuf, sizeof(g_payloadBuf));
+  feedWatchdog();
+  // attempt to resend any failed payloads first (non-blocking, limited)
+  retryFailedPayloads();
+
+  HTTPClient http;
+  http.setTimeout(10000);
+  // Send telemetry to backend agent status endpoint and include device token for auth
+  char url[160];
+  // include explicit port so device connects to intended service
+  snprintf(url, sizeof(url), "http://%s:%d/api/v1/agents/%s/status", SERVER_IP, SERVER_PORT, settings.deviceID);
+  DLOG(LF_HTTP_POST, url);
+  http.begin(url);
+  http.addHeader("Content-Type", "application/json");
+  http.addHeader("X-Device-Token", settings.token);
+  // close connection after request to avoid keep-alive/socket reuse issues
+  http.addHeader("Connection", "close");
+
+  bootMark(BOOT_TELEMETRY);
+  size_t len = buildTelemetryPayload(g_payloadBuf, sizeof(g_payloadBuf));
   // publish telemetry also via MQTT (best-effort)
   mqtt_publishTelemetry();
-  Serial.printf("[HTTP] payload len=%u\n", (unsigned)len);
+  DLOG(LF_HTTP_PAYLOAD, len);
   int code = -1;
   // try twice on transient socket errors
   for (int attempt = 0; attempt < 2; attempt++) {
+    uint32_t t0 = micros();
     code = http.POST((uint8_t*)g_payloadBuf, len);
+    metricsObserve(metrics.httpPost, micros() - t0);
+    metricsCountHttpResult(code);
     if (code > 0) break;
-    Serial.printf("[HTTP] attempt %d failed, code=%d, err=%s\n", attempt+1, code, http.errorToString(code).c_str());
+    DLOG(LF_HTTP_ATTEMPT_FAILED, attempt + 1, code, http.errorToString(code).c_str());
     delay(250);
   }
   feedWatchdog();
 
   if (code == 200) {
+    bootTimelineDelivered();
     // Read response into fixed buffer to avoid dynamic String
     WiFiClient* stream = http.getStreamPtr();
     size_t pos = 0;
@@ -487,21 +635,20 @@ void handleServerComm() {
     g_responseBuf[pos] = '\0';
     feedWatchdog();
 
-  // Use a heap-allocated JSON document to avoid large stack allocations
-  DynamicJsonDocument respDoc(4096);
+  // g_responseBuf is writable, so the document references strings in place
+  StaticJsonDocument<4096>& respDoc = g_respDoc;
   DeserializationError error = deserializeJson(respDoc, g_responseBuf);
     feedWatchdog();
     yield();
     if (!error) {
-      // For debugging: print full server response so we can see fields
-      Serial.println("[SERVER_RESP] response: ");
-      Serial.println(g_responseBuf);
+      // debug copy of the response (cut to one log record)
+      DLOG(LF_SERVER_RESP, pos, g_responseBuf);
       bool suppress = (millis() < suppressRemoteUntil) || (menuState >= EDIT_TEMP && menuState <= EDIT_PH_MAX);
 
         // If server sent a pending config block, apply it (same as top-level fields)
         if (respDoc.containsKey("pending")) {
           JsonObject p = respDoc["pending"].as<JsonObject>();
-          Serial.println("[SERVER_RESP] pending config received");
+          DLOG(LF_SERVER_PENDING);
           if (p.containsKey("tempThresh")) settings.tempThresh = p["tempThresh"].as<float>();
           if (p.containsKey("temperature_threshold")) settings.tempThresh = p["temperature_threshold"].as<float>();
           if (p.containsKey("humThresh")) settings.humThresh = p["humThresh"].as<float>();
@@ -521,12 +668,12 @@ void handleServerComm() {
           if (p.containsKey("phThreshMin")) settings.phThreshMin = p["phThreshMin"].as<float>();
           if (p.containsKey("phThreshMax")) settings.phThreshMax = p["phThreshMax"].as<float>();
           if (p.containsKey("dailyWater")) settings.dailyWater = p["dailyWater"].as<bool>();
-          if (p.containsKey("pumpAuto")) Serial.printf("[SERVER_RESP] pending.pumpAuto=%d\n", p["pumpAuto"].as<bool>());
-          if (p.containsKey("pump_auto")) Serial.printf("[SERVER_RESP] pending.pump_auto=%d\n", p["pump_auto"].as<bool>());
-          if (p.containsKey("fanAuto")) Serial.printf("[SERVER_RESP] pending.fanAuto=%d\n", p["fanAuto"].as<bool>());
-          if (p.containsKey("fan_auto")) Serial.printf("[SERVER_RESP] pending.fan_auto=%d\n", p["fan_auto"].as<bool>());
-          if (p.containsKey("lightAuto")) Serial.printf("[SERVER_RESP] pending.lightAuto=%d\n", p["lightAuto"].as<bool>());
-          if (p.containsKey("light_auto")) Serial.printf("[SERVER_RESP] pending.light_auto=%d\n", p["light_auto"].as<bool>());
+          if (p.containsKey("pumpAuto")) DLOG(LF_SERVER_PENDING_FLAG, "pumpAuto", p["pumpAuto"].as<bool>());
+          if (p.containsKey("pump_auto")) DLOG(LF_SERVER_PENDING_FLAG, "pump_auto", p["pump_auto"].as<bool>());
+          if (p.containsKey("fanAuto")) DLOG(LF_SERVER_PENDING_FLAG, "fanAuto", p["fanAuto"].as<bool>());
+          if (p.containsKey("fan_auto")) DLOG(LF_SERVER_PENDING_FLAG, "fan_auto", p["fan_auto"].as<bool>());
+          if (p.containsKey("lightAuto")) DLOG(LF_SERVER_PENDING_FLAG, "lightAuto", p["lightAuto"].as<bool>());
+          if (p.containsKey("light_auto")) DLOG(LF_SERVER_PENDING_FLAG, "light_auto", p["light_auto"].as<bool>());
           if (!suppress && p.containsKey("pumpAuto")) { settings.pumpAuto = p["pumpAuto"].as<bool>(); if (settings.pumpAuto) settings.relayOverride = false; }
           if (!suppress && p.containsKey("pump_auto")) { settings.pumpAuto = p["pump_auto"].as<bool>(); if (settings.pumpAuto) settings.relayOverride = false; }
           if (!suppress && p.containsKey("fanAuto")) { settings.fanAuto = p["fanAuto"].as<bool>(); if (settings.fanAuto) settings.relayOverride = false; }
@@ -586,6 +733,7 @@ void handleServerComm() {
                 if (respDoc.containsKey("pump")) { state.pump = respDoc["pump"].as<bool>(); digitalWrite(RELAY_PUMP, state.pump); }
                 if (respDoc.containsKey("fan"))  { state.fan = respDoc["fan"].as<bool>(); digitalWrite(RELAY_FAN, state.fan); }
                 if (respDoc.containsKey("lightOn")) { state.lightOn = respDoc["lightOn"].as<bool>(); digitalWrite(RELAY_LIGHT, state.lightOn); }
+                publishSensorState();
               }
             }
 
@@ -641,13 +789,13 @@ void handleServerComm() {
       if (!suppress && respDoc.containsKey("fan_auto")) { settings.fanAuto = respDoc["fan_auto"].as<bool>(); if (settings.fanAuto) settings.relayOverride = false; }
       if (!suppress && respDoc.containsKey("light_auto")) { settings.lightAuto = respDoc["light_auto"].as<bool>(); if (settings.lightAuto) settings.relayOverride = false; }
       saveSettings();
-      controlRelays();
+      controlNotifyConfig();
       if (menuState == MAIN_SCREEN) drawMainScreen(); else needMainRefresh = true;
       // clear persist flag after server responded
       telemetryPersistConfig = false;
     }
   } else {
-    Serial.printf("HTTP POST failed, code: %d, err=%s\n", code, http.errorToString(code).c_str());
+    DLOG(LF_HTTP_POST_FAILED, code, http.errorToString(code).c_str());
     // enqueue payload for retry later
     enqueueFailedPayload(g_payloadBuf, len);
   }
@@ -673,12 +821,28 @@ void requestTelemetrySendPersist() {
 
 void watchdogTask(void* pv) {
   const TickType_t delayTicks = pdMS_TO_TICKS(30000); // 30s check
+  stackTrackSelf(STK_WATCHDOG);
+#ifdef STACK_SOAK_REPORT_MS
+  unsigned long lastStackReport = millis();
+#endif
   while (1) {
     unsigned int sServer = serverTaskHandle ? uxTaskGetStackHighWaterMark(serverTaskHandle) : 0;
     unsigned int sLCD = lcdTaskHandle ? uxTaskGetStackHighWaterMark(lcdTaskHandle) : 0;
     unsigned int sBtn = buttonTaskHandle ? uxTaskGetStackHighWaterMark(buttonTaskHandle) : 0;
     unsigned int sSensor = sensorTaskHandle ? uxTaskGetStackHighWaterMark(sensorTaskHandle) : 0;
-    Serial.printf("[WATCHDOG] stacks: server=%u lcd=%u btn=%u sensor=%u freeHeap=%u\n", sServer, sLCD, sBtn, sSensor, (unsigned)ESP.getFreeHeap());
+    DLOG(LF_WATCHDOG_STACKS, sServer, sLCD, sBtn, sSensor, ESP.getFreeHeap());
+    taskMonitorUpdate();
+    DLOG(LF_WATCHDOG_CPU, taskReport.corePct[0], taskReport.corePct[1], taskReport.maxGapMs[MON_SERVER],
+         taskReport.maxGapMs[MON_SENSOR], taskReport.maxGapMs[MON_LCD], taskReport.maxGapMs[MON_BUTTON],
+         taskReport.maxGapMs[MON_EEPROM]);
+    stackMonitorSample();
+#ifdef STACK_SOAK_REPORT_MS
+    // soak builds print the per-task peaks and recommended sizes periodically
+    if (millis() - lastStackReport >= STACK_SOAK_REPORT_MS) {
+      stackMonitorReport();
+      lastStackReport = millis();
+    }
+#endif
     // If any stack high-water is too small, force restart to recover
     const unsigned int STACK_THRESHOLD = 100;
     if ((sServer > 0 && sServer < STACK_THRESHOLD) || (sLCD > 0 && sLCD < STACK_THRESHOLD) ||
@@ -24,11 +24,22 @@ extern volatile bool telemetryPersistConfig;
 
 // restore failed payload queue from LittleFS (call at boot)
 void loadFailedQueueFromFS();
+// payloads currently waiting in the retry queue
+int failedPayloadCount();
+
+// cached "a.b.c.d" and "AA:BB:..." of the station interface
+extern char deviceIP[16];
+extern char deviceMAC[18];
+// re-read IP/MAC into deviceIP/deviceMAC (after WiFi connects). serverTask
+// only: it is the sole writer, and every reader runs there too.
+void refreshNetIdentity();
 
 void connectWiFi();
 void initWatchdog();
 void feedWatchdog();
 void handleServerComm();
+// serialize the status telemetry into buf; returns bytes written
+size_t buildTelemetryPayload(char* buf, size_t size);
 
 // expose web server pointer for serverTask to call handleClient
 extern WebServer* webServer;